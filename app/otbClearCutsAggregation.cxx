@@ -21,82 +21,28 @@
 
 // Mosaic filters
 #include "otbClearCutsMosaicingFilter.h"
+#include "otbClearCutsReducers.h"
 
-enum Modes
-{
-  max,mean
-};
-
-/**
- * \class Max Clear Cut Functor
- * \brief Compute the maximum of the dNDVI label value
- */
-template< class T>
-class MaxCC
-{
-public:
-  MaxCC() {}
+// Pipelined streaming
+#include "otbPrefetchImageFilter.h"
 
-  ~MaxCC() {}
-
-  bool operator!=( const MaxCC & ) const {
-    return false;
-  }
+// Cloud optimized GeoTIFF writer
+#include "otbStreamingCOGWriter.h"
 
-  bool operator==( const MaxCC & other ) const {
-    return !(*this != other);
-  }
+// Memory-mapped inputs
+#include "otbMappedRasterImageSource.h"
 
-  inline T operator()( const std::vector<T> & A ) const
-  {
-    T output;
-    output.SetSize(1);
-    output[0] = itk::NumericTraits<typename T::ValueType>::Zero;
-    for (unsigned int i = 0 ; i < A.size() ; i++)
-      {
-      if (output[0] < A[i][0])
-        output[0] = A[i][0];
-      }
+#include <stdint.h>
+#include <algorithm>
 
-    return output;
-  }
+enum Modes
+{
+  max,mean,count,lastdate,mode,vote,all
 };
 
-/**
- * \class Mean Clear Cut Functor
- * \brief Compute the maximum of the dNDVI label value
- */
-template< class T>
-class MeanCC
+enum COGCompressions
 {
-public:
-  MeanCC() {}
-
-  ~MeanCC() {}
-
-  bool operator!=( const MeanCC & ) const {
-    return false;
-  }
-
-  bool operator==( const MeanCC & other ) const {
-    return !(*this != other);
-  }
-
-  inline T operator()( const std::vector<T> & A ) const
-  {
-    double sum = 0;
-    T output;
-    output.SetSize(1);
-    for (unsigned int i = 0 ; i < A.size() ; i++)
-      {
-      sum += A[i][0];
-      }
-    if (A.size()>0)
-      sum /= ((double) A.size());
-    output[0] = static_cast<typename T::ValueType>(sum);
-
-    return output;
-  }
+  compression_deflate,compression_lzw,compression_zstd
 };
 
 namespace otb
@@ -119,12 +65,21 @@ public:
   itkTypeMacro(ClearCutsAggregation, Application);
 
   /** Typedefs */
-  typedef MaxCC<FloatVectorImageType::PixelType> MaxCCType;
-  typedef MeanCC<FloatVectorImageType::PixelType> MeanCCType;
-  typedef otb::ClearCutsMosaicingFilter<FloatVectorImageType,
-      FloatVectorImageType, double, MaxCCType> MaxClearCutsMosaicingFilterType;
-  typedef otb::ClearCutsMosaicingFilter<FloatVectorImageType,
-      FloatVectorImageType, double, MeanCCType> MeanClearCutsMosaicingFilterType;
+  typedef FloatVectorImageType::InternalPixelType                   ValueType;
+  typedef otb::Functor::MaxCC<ValueType>                            MaxCCType;
+  typedef otb::Functor::MeanCC<ValueType>                           MeanCCType;
+  typedef otb::Functor::CountCC<ValueType>                          CountCCType;
+  typedef otb::Functor::LastDateCC<ValueType>                       LastDateCCType;
+  typedef otb::Functor::WeightedModeCC<ValueType, false>            ModeCCType;
+  typedef otb::Functor::WeightedModeCC<ValueType, true>             VoteCCType;
+  typedef otb::Functor::ReducerChain<CountCCType,
+      otb::Functor::ReducerChain<LastDateCCType,
+      otb::Functor::ReducerChain<ModeCCType, VoteCCType> > >        AllCCType;
+  typedef itk::ProcessObject                                        MosaicFilterType;
+  typedef otb::PrefetchImageFilter<FloatVectorImageType> PrefetchFilterType;
+  typedef otb::StreamingCOGWriter<FloatVectorImageType> COGWriterType;
+  typedef otb::MappedRasterImageSource<FloatVectorImageType> MappedSourceType;
+  typedef otb::MappedRasterImageSource<UInt8VectorImageType> MappedLabelSourceType;
 
 private:
 
@@ -132,31 +87,150 @@ private:
   #define SSTR( x ) dynamic_cast< std::ostringstream & >( \
     ( std::ostringstream() << std::dec << x ) ).str()
 
+  /*
+   * Input images: images of il, then memory-mapped rasters of ilm
+   */
+  std::vector<FloatVectorImageType *> GetInputImages()
+  {
+    std::vector<FloatVectorImageType *> inputImages;
+    if (HasValue("il"))
+      {
+      FloatVectorImageListType::Pointer inputArray = this->GetParameterImageList("il");
+      for (unsigned int i = 0 ; i < inputArray->Size() ; i++)
+        {
+        inputImages.push_back(inputArray->GetNthElement(i));
+        }
+      }
+    if (HasValue("ilm"))
+      {
+      std::vector<std::string> filenames = GetParameterStringList("ilm");
+      m_MappedSources.resize(filenames.size());
+      for (unsigned int i = 0 ; i < filenames.size() ; i++)
+        {
+        m_MappedSources[i] = MappedSourceType::New();
+        m_MappedSources[i]->SetFileName(filenames[i]);
+        m_MappedSources[i]->UpdateOutputInformation();
+        if (!m_MappedSources[i]->IsZeroCopy())
+          {
+          otbAppLogINFO("Pixels of " << filenames[i] << " are converted to float");
+          }
+        inputImages.push_back(m_MappedSources[i]->GetOutput());
+        }
+      }
+    return inputImages;
+  }
+
+  /*
+   * Input label images, when the inputs are only uint8 rasters of ilm (e.g.
+   * written by ClearCutsDetection -outlabels): they are mapped without copy,
+   * and their pixels are converted by the mosaic filter. Returns an empty
+   * array otherwise.
+   */
+  std::vector<UInt8VectorImageType *> GetInputLabelImages()
+  {
+    std::vector<UInt8VectorImageType *> inputImages;
+    if (HasValue("il") || !HasValue("ilm"))
+      return inputImages;
+
+    std::vector<std::string> filenames = GetParameterStringList("ilm");
+    m_MappedLabelSources.resize(filenames.size());
+    for (unsigned int i = 0 ; i < filenames.size() ; i++)
+      {
+      m_MappedLabelSources[i] = MappedLabelSourceType::New();
+      m_MappedLabelSources[i]->SetFileName(filenames[i]);
+      m_MappedLabelSources[i]->UpdateOutputInformation();
+      if (!m_MappedLabelSources[i]->IsZeroCopy())
+        {
+        m_MappedLabelSources.clear();
+        inputImages.clear();
+        return inputImages;
+        }
+      inputImages.push_back(m_MappedLabelSources[i]->GetOutput());
+      }
+    return inputImages;
+  }
+
   /*
    * Create a mosaic filter, which is connected to the inputs array
    */
-  template<class TMosaicFilterType>
+  template<class TMosaicFilterType, class TInputImageType>
   typename TMosaicFilterType::Pointer
-  CreateConnectedMosaicFilterToInputs()
+  CreateConnectedMosaicFilterToInputs(const std::vector<TInputImageType *> & inputArray)
   {
-    // Get the input image list
-    FloatVectorImageListType::Pointer inputArray = this->GetParameterImageList("il");
-
     typename TMosaicFilterType::Pointer mosaicFilter = TMosaicFilterType::New();
-    if (inputArray->Size() ==0)
+    if (inputArray.size() ==0)
       {
       otbAppLogFATAL("Filter array have wrong number of elements");
       }
     else
       {
-      for (unsigned int i = 0 ; i < inputArray->Size() ; i++)
+      for (unsigned int i = 0 ; i < inputArray.size() ; i++)
         {
-        mosaicFilter->PushBackInput(inputArray->GetNthElement(i) );
+        mosaicFilter->PushBackInput(inputArray[i] );
         }
       }
     return mosaicFilter;
   }
 
+  /*
+   * Parse a list of numbers (inputs dates or weights)
+   */
+  std::vector<double> GetParameterNumberList(std::string key)
+  {
+    std::vector<double> numbers;
+    if (HasValue(key))
+      {
+      std::vector<std::string> values = GetParameterStringList(key);
+      for (unsigned int i = 0 ; i < values.size() ; i++)
+        {
+        char * end;
+        numbers.push_back(std::strtod(values[i].c_str(), &end));
+        if (*end != '\0')
+          {
+          otbAppLogFATAL("Parameter " << key << ": " << values[i] << " is not a number");
+          }
+        }
+      if (numbers.size() != m_MosaicFilter->GetNumberOfInputs())
+        {
+        otbAppLogFATAL("Parameter " << key << " must have one value for each input image");
+        }
+      }
+    return numbers;
+  }
+
+  /*
+   * Create the mosaic filter of the given reducer and input image type
+   */
+  template<class TInputImageType, class TReducerType>
+  FloatVectorImageType * CreateMosaic(const std::vector<TInputImageType *> & inputArray)
+  {
+    typedef otb::ClearCutsMosaicingFilter<TInputImageType,
+        FloatVectorImageType, double, TReducerType> ClearCutsMosaicingFilterType;
+
+    typename ClearCutsMosaicingFilterType::Pointer mosaicFilter =
+        CreateConnectedMosaicFilterToInputs<ClearCutsMosaicingFilterType>(inputArray);
+    m_MosaicFilter = mosaicFilter;
+    mosaicFilter->GetFunctor().SetInputDates(GetParameterNumberList("dates"));
+    mosaicFilter->GetFunctor().SetInputWeights(GetParameterNumberList("weights"));
+
+    return mosaicFilter->GetOutput();
+  }
+
+  /*
+   * Create the mosaic filter of the given reducer: uint8 label images are
+   * mosaiced as they are mapped, other inputs as float images
+   */
+  template<class TReducerType>
+  FloatVectorImageType * CreateMosaic()
+  {
+    std::vector<UInt8VectorImageType *> labelImages = GetInputLabelImages();
+    if (!labelImages.empty())
+      {
+      return CreateMosaic<UInt8VectorImageType, TReducerType>(labelImages);
+      }
+    return CreateMosaic<FloatVectorImageType, TReducerType>(GetInputImages());
+  }
+
 
   void DoInit()
   {
@@ -177,18 +251,75 @@ private:
     // Input image
     AddParameter(ParameterType_InputImageList,  "il",   "Input Clear Cuts Label Images");
     SetParameterDescription("il", "Input Clear Cuts Label Images to mosaic");
+    MandatoryOff("il");
+
+    AddParameter(ParameterType_InputFilenameList, "ilm", "Input Clear Cuts Label Images (.ccr)");
+    SetParameterDescription("ilm", "Input label images in the native memory-mapped raster format "
+        "(e.g. written by ClearCutsDetection -outlabels), mapped in memory. When all the inputs are uint8 "
+        "label images of ilm, they are read without copy. Otherwise, pixels which are not float are "
+        "converted tile by tile. They come after "
+        "the images of il (for dates and weights).");
+    MandatoryOff("ilm");
 
     // Output image
     AddParameter(ParameterType_OutputImage,  "out",   "Output image");
-    SetParameterDescription("out"," Output image.");
+    SetParameterDescription("out"," Output image. The count, lastdate and all methods need a "
+        "pixel type which holds the number of inputs, and the dates (e.g. uint16).");
     SetDefaultOutputPixelType("out", ImagePixelType_uint8);
+    MandatoryOff("out");
+
+    // Cloud optimized GeoTIFF output
+    AddParameter(ParameterType_Group, "cog", "Cloud optimized GeoTIFF output");
+    SetParameterDescription("cog", "Quantized (8 bits), tiled and compressed output, with "
+        "overviews built while streaming. The image is streamed in a temporary file next to "
+        "cog.out, which is then copied with the COG layout and removed.");
+    AddParameter(ParameterType_OutputFilename, "cog.out", "Output COG file");
+    MandatoryOff("cog.out");
+    AddParameter(ParameterType_Float, "cog.scale", "Quantization scale");
+    SetParameterDescription("cog.scale", "Output value is round(value * scale), clamped in [0, 255]. "
+        "For instance, use 100 to write the mean aggregation as a percentage.");
+    SetDefaultParameterFloat("cog.scale", 1.0);
+    AddParameter(ParameterType_Int, "cog.blocksize", "Size of the blocks");
+    SetMinimumParameterIntValue("cog.blocksize", 16);
+    SetDefaultParameterInt     ("cog.blocksize", 512);
+    AddParameter(ParameterType_Choice, "cog.compression", "Compression");
+    AddChoice("cog.compression.deflate", "DEFLATE");
+    AddChoice("cog.compression.lzw", "LZW");
+    AddChoice("cog.compression.zstd", "ZSTD");
 
     // Mode de calcul
     AddParameter(ParameterType_Choice,"method","Aggregation method");
     SetParameterDescription("method","Set the aggregation method for composition");
     AddChoice("method.max","Maximum");
     AddChoice("method.mean","Mean");
-
+    AddChoice("method.count","Number of detections");
+    AddChoice("method.lastdate","Date of the most recent detection");
+    AddChoice("method.mode","Majority label");
+    AddChoice("method.vote","Weighted majority label");
+    AddChoice("method.all","Number of detections, date of the most recent detection, majority "
+        "label and weighted majority label (4 bands, computed in a single pass)");
+
+    // Inputs dates and weights
+    AddParameter(ParameterType_StringList, "dates", "Inputs dates");
+    SetParameterDescription("dates","Date of each input image, as a number (e.g. day of year), "
+        "used by the lastdate method. Default is the rank of the input (1, 2, ...). Dates "
+        "which do not fit in the output pixel type are refused.");
+    MandatoryOff("dates");
+    AddParameter(ParameterType_StringList, "weights", "Inputs weights");
+    SetParameterDescription("weights","Confidence of each input image, used by the vote method. "
+        "Default is 1 for all inputs.");
+    MandatoryOff("weights");
+
+    // Pipelined streaming
+    AddParameter(ParameterType_Int, "prefetch", "Number of tiles computed in advance");
+    SetParameterDescription("prefetch","Number of mosaic tiles (input reads and aggregation) "
+        "generated on a worker thread while the current tile is written in cog.out. "
+        "Only applies to cog.out: out is streamed by the application framework, and is "
+        "never prefetched. The available RAM is shared between the in-flight tiles. "
+        "0 disables the prefetch.");
+    SetMinimumParameterIntValue("prefetch", 0);
+    SetDefaultParameterInt     ("prefetch", 1);
+    MandatoryOff("prefetch");
 
     AddRAMParameter();
 
@@ -199,21 +330,189 @@ private:
     // Nothing to do here : all parameters are independent
   }
 
-  void DoExecute()
+  /*
+   * Range of the values which can be written in the output image pixel type
+   */
+  void GetOutputPixelTypeRange(double & minValue, double & maxValue, bool & integral)
+  {
+    integral = true;
+    switch (GetParameterOutputImagePixelType("out"))
+      {
+      case ImagePixelType_uint8:
+        minValue = itk::NumericTraits<uint8_t>::min();
+        maxValue = itk::NumericTraits<uint8_t>::max();
+        break;
+      case ImagePixelType_int16:
+        minValue = itk::NumericTraits<int16_t>::min();
+        maxValue = itk::NumericTraits<int16_t>::max();
+        break;
+      case ImagePixelType_uint16:
+        minValue = itk::NumericTraits<uint16_t>::min();
+        maxValue = itk::NumericTraits<uint16_t>::max();
+        break;
+      case ImagePixelType_int32:
+        minValue = itk::NumericTraits<int32_t>::min();
+        maxValue = itk::NumericTraits<int32_t>::max();
+        break;
+      case ImagePixelType_uint32:
+        minValue = itk::NumericTraits<uint32_t>::min();
+        maxValue = itk::NumericTraits<uint32_t>::max();
+        break;
+      default:
+        minValue = itk::NumericTraits<float>::NonpositiveMin();
+        maxValue = itk::NumericTraits<float>::max();
+        integral = false;
+        break;
+      }
+  }
+
+  /*
+   * Numbers of detections and dates can exceed the output pixel type (uint8
+   * by default) or the 8 bits of the COG: such lossy outputs are refused
+   */
+  void CheckOutputRange()
   {
+    const int method = GetParameterInt("method");
+    if (method != count && method != lastdate && method != all)
+      return;
+
+    const double nbOfInputs = m_MosaicFilter->GetNumberOfInputs();
+    double minValue = 0.0;
+    double maxValue = 0.0;
+    bool integral = true;
+    if (method == count || method == all)
+      {
+      maxValue = nbOfInputs;
+      }
+    if (method == lastdate || method == all)
+      {
+      std::vector<double> dates = GetParameterNumberList("dates");
+      if (dates.empty())
+        maxValue = std::max(maxValue, nbOfInputs);
+      for (unsigned int i = 0 ; i < dates.size() ; i++)
+        {
+        minValue = std::min(minValue, dates[i]);
+        maxValue = std::max(maxValue, dates[i]);
+        if (dates[i] != vcl_floor(dates[i]))
+          integral = false;
+        }
+      }
 
-    if (GetParameterInt("method") == max)
+    if (HasValue("out"))
       {
-      m_MaxMosaicFilter = CreateConnectedMosaicFilterToInputs<MaxClearCutsMosaicingFilterType>();
-      SetParameterOutputImage("out", m_MaxMosaicFilter->GetOutput() );
+      double typeMinValue, typeMaxValue;
+      bool typeIntegral;
+      GetOutputPixelTypeRange(typeMinValue, typeMaxValue, typeIntegral);
+      if (minValue < typeMinValue || maxValue > typeMaxValue || (typeIntegral && !integral))
+        {
+        otbAppLogFATAL("Output values range in [" << minValue << ", " << maxValue << "]"
+            << (integral ? "" : " (not integers)") << " and do not fit in the pixel type of out. "
+            << "Use a wider pixel type, e.g. -out " << GetParameterString("out")
+            << (integral ? (maxValue > itk::NumericTraits<uint16_t>::max() ? " uint32" : " uint16") : " float"));
+        }
+      }
+
+    if (HasValue("cog.out"))
+      {
+      const double scale = GetParameterFloat("cog.scale");
+      if (minValue * scale < 0.0 || maxValue * scale > 255.0)
+        {
+        otbAppLogFATAL("Output values range in [" << minValue << ", " << maxValue << "]: once scaled by "
+            << scale << " they do not fit in the 8 bits of cog.out");
+        }
       }
-    else if (GetParameterInt("method") == mean)
+  }
+
+  /*
+   * Write the mosaic as a cloud optimized GeoTIFF
+   */
+  void WriteCOG(FloatVectorImageType * mosaicImage)
+  {
+    // The RAM is shared between the in-flight tiles and the written one
+    const unsigned int queueDepth = GetParameterInt("prefetch");
+    const unsigned int streamingRAM = GetParameterInt("ram") / (queueDepth + 1);
+    FloatVectorImageType * cogInputImage = mosaicImage;
+    if (queueDepth > 0)
       {
-      m_MeanMosaicFilter = CreateConnectedMosaicFilterToInputs<MeanClearCutsMosaicingFilterType>();
-      SetParameterOutputImage("out", m_MeanMosaicFilter->GetOutput() );
+      otbAppLogINFO("Prefetching " << queueDepth << " tile(s), using " << streamingRAM
+          << " Mb for the streaming");
+      m_PrefetchFilter = PrefetchFilterType::New();
+      m_PrefetchFilter->SetInput(mosaicImage);
+      m_PrefetchFilter->SetQueueDepth(queueDepth);
+      cogInputImage = m_PrefetchFilter->GetOutput();
       }
+
+    m_COGWriter = COGWriterType::New();
+    m_COGWriter->SetInput(cogInputImage);
+    m_COGWriter->SetFileName(GetParameterString("cog.out"));
+    m_COGWriter->SetScale(GetParameterFloat("cog.scale"));
+    m_COGWriter->SetBlockSize(GetParameterInt("cog.blocksize"));
+    m_COGWriter->SetAvailableRAM(streamingRAM);
+    if (GetParameterInt("cog.compression") == compression_lzw)
+      m_COGWriter->SetCompression("LZW");
+    else if (GetParameterInt("cog.compression") == compression_zstd)
+      m_COGWriter->SetCompression("ZSTD");
     else
-      otbAppLogFATAL("Unknow aggregation method");
+      m_COGWriter->SetCompression("DEFLATE");
+    if (m_PrefetchFilter.IsNotNull())
+      m_PrefetchFilter->SetStreamingManager(m_COGWriter->GetStreamingManager());
+
+    AddProcess(m_COGWriter, "Writing cloud optimized GeoTIFF");
+    m_COGWriter->Update();
+  }
+
+  void DoExecute()
+  {
+
+    if (!HasValue("out") && !HasValue("cog.out"))
+      {
+      otbAppLogFATAL("An output image (out or cog.out) is required");
+      }
+
+    FloatVectorImageType * mosaicImage = NULL;
+    switch (GetParameterInt("method"))
+      {
+      case max:
+        mosaicImage = CreateMosaic<MaxCCType>();
+        break;
+      case mean:
+        mosaicImage = CreateMosaic<MeanCCType>();
+        break;
+      case count:
+        mosaicImage = CreateMosaic<CountCCType>();
+        break;
+      case lastdate:
+        mosaicImage = CreateMosaic<LastDateCCType>();
+        break;
+      case mode:
+        mosaicImage = CreateMosaic<ModeCCType>();
+        break;
+      case vote:
+        mosaicImage = CreateMosaic<VoteCCType>();
+        break;
+      case all:
+        mosaicImage = CreateMosaic<AllCCType>();
+        break;
+      default:
+        otbAppLogFATAL("Unknow aggregation method");
+      }
+    CheckOutputRange();
+
+    if (HasValue("cog.out"))
+      {
+      WriteCOG(mosaicImage);
+      }
+
+    // The streaming of out is driven by the application framework, whose
+    // splits can not be known here: it is not prefetched
+    if (HasValue("out"))
+      {
+      if (!HasValue("cog.out") && GetParameterInt("prefetch") > 0)
+        {
+        otbAppLogINFO("prefetch only applies to cog.out: it is ignored for out");
+        }
+      SetParameterOutputImage("out", mosaicImage );
+      }
 
 
   }   // DOExecute()
@@ -223,8 +522,11 @@ private:
     // Nothing to do
   }
 
-  MaxClearCutsMosaicingFilterType::Pointer m_MaxMosaicFilter;
-  MeanClearCutsMosaicingFilterType::Pointer m_MeanMosaicFilter;
+  MosaicFilterType::Pointer m_MosaicFilter;
+  PrefetchFilterType::Pointer m_PrefetchFilter;
+  COGWriterType::Pointer m_COGWriter;
+  std::vector<MappedSourceType::Pointer> m_MappedSources;
+  std::vector<MappedLabelSourceType::Pointer> m_MappedLabelSources;
 
 };
 }
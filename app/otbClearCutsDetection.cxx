@@ -15,7 +15,7 @@
 // Elevation handler
 #include "otbWrapperElevationParametersHandler.h"
 #include "otbWrapperApplicationFactory.h"
-#include "otbWrapperCompositeApplication.h"
+#include "otbWrapperApplication.h"
 
 // Application engine
 #include "otbStandardFilterWatcher.h"
@@ -23,11 +23,16 @@
 
 // Filters
 #include "itkMaskImageFilter.h"
-#include "otbStreamingStatisticsImageFilter.h"
+#include "otbStreamingDeltaNDVIStatisticsFilter.h"
 #include "otbStreamingResampleImageFilter.h"
+#include "otbGridAlignedResampleImageFilter.h"
 #include "otbMultiChannelExtractROI.h"
+#include "otbExtractROI.h"
 #include "otbDeltaNDVILabelerFilter.h"
 #include "itkAndImageFilter.h"
+#include "otbConcatenateVectorImageFilter.h"
+#include "otbVectorDataProjectionFilter.h"
+#include "otbVectorDataMaskImageFilter.h"
 
 // Helper
 #include "otbRegionComparator.h"
@@ -37,22 +42,55 @@
 
 // Connected components
 #include "otbConnectedLabelsImageFilter.h"
+#include "otbStreamingConnectedComponentsFilter.h"
+#include "otbConnectedComponentsRunTableToImageFilter.h"
+
+// Sparse pipeline
+#include "otbStreamingDeltaNDVIRunsFilter.h"
+#include "otbConnectedComponentsRunTableToVectorDataFilter.h"
+
+// Pipelined streaming
+#include "otbPrefetchImageFilter.h"
+#include "otbRAMDrivenAdaptativeStreamingManager.h"
+
+// Coarse-to-fine processing
+#include "otbImageFileReader.h"
+#include "otbCandidateBlocksImageFilter.h"
+#include "otbStreamingCoarseCandidatesFilter.h"
 
 // Vectorization
 #include "otbCacheLessLabelImageToVectorData.h"
 
+// Label image output
+#include "otbMappedRasterFileWriter.h"
+#include "otbMappedRasterFileTeeFilter.h"
+
+// Job cache
+#include "otbMappedRasterImageSource.h"
+#include "itksys/Directory.hxx"
+#include "itksys/SystemTools.hxx"
+#include <sys/stat.h>
+#include <stdint.h>
+#include <cerrno>
+#include <cstdio>
+#include <vector>
+#include <algorithm>
+
+#include <fstream>
+#include <sstream>
+
 namespace otb
 {
 
 namespace Wrapper
 {
 
-class ClearCutsDetection : public CompositeApplication
+class ClearCutsDetection : public Application
 {
 public:
   /** Standard class typedefs. */
   typedef ClearCutsDetection            Self;
-  typedef CompositeApplication          Superclass;
+  typedef Application                   Superclass;
   typedef itk::SmartPointer<Self>       Pointer;
   typedef itk::SmartPointer<const Self> ConstPointer;
 
@@ -64,18 +102,97 @@ public:
   typedef UInt8ImageType                                                                    MaskImageType;
   typedef otb::StreamingResampleImageFilter<FloatVectorImageType, FloatVectorImageType>     ResampleImageFilterType;
   typedef itk::NearestNeighborInterpolateImageFunction<FloatVectorImageType>                NNInterpolatorType;
+  typedef otb::GridAlignedResampleImageFilter<FloatVectorImageType>                         GridResampleFilterType;
   typedef otb::Functor::DeltaNDVIFromChannels<FloatVectorImageType::PixelType,
       FloatImageType::PixelType>                                                            DeltaNDVIFunctorType;
   typedef itk::BinaryFunctorImageFilter<FloatVectorImageType, FloatVectorImageType,
       FloatImageType, DeltaNDVIFunctorType>                                                 DeltaNDVIFilterType;
   typedef itk::MaskImageFilter<FloatImageType, MaskImageType, FloatImageType>               MaskImageFilterType;
   typedef otb::DeltaNDVILabelerFilter<FloatImageType, MaskImageType>                        NDVILabelImageFilterType;
-  typedef otb::StreamingStatisticsImageFilter<FloatImageType>                               StatsFilterType;
+  typedef otb::StreamingDeltaNDVIStatisticsFilter<FloatImageType>                           StatsFilterType;
+  typedef StatsFilterType::RealObjectType                                                   RealObjectType;
   typedef otb::MultiChannelExtractROI<FloatVectorImageType::InternalPixelType,
       FloatVectorImageType::InternalPixelType>                                              ExtractROIFilterType;
   typedef otb::MosaicFromDirectoryHandler<MaskImageType,FloatImageType>                     MaskHandlerType;
   typedef otb::ConnectedLabelsImageFilter<MaskImageType>                                    ConnectedLabelsFilterType;
+  typedef otb::StreamingConnectedComponentsFilter<MaskImageType, FloatImageType>            ComponentsFilterType;
+  typedef ComponentsFilterType::RunTableType                                                RunTableType;
+  typedef otb::ConnectedComponentsRunTableToImageFilter<MaskImageType>                      ComponentsImageSourceType;
+  typedef otb::ConnectedComponentsRunTableToImageFilter<UInt32ImageType,
+      MaskImageType::PixelType>                                                             ComponentIdsImageSourceType;
+  typedef otb::MappedRasterFileWriter<UInt32ImageType>                                      ComponentIdsWriterType;
+  typedef otb::StreamingDeltaNDVIRunsFilter<FloatImageType, MaskImageType::PixelType>       RunsFilterType;
+  typedef otb::ConnectedComponentsRunTableToVectorDataFilter<RunTableType, VectorDataType>  PolygonsFilterType;
   typedef otb::CacheLessLabelImageToVectorData<MaskImageType::PixelType>                    VectorizationFilterType;
+  typedef otb::MappedRasterFileWriter<MaskImageType>                                        LabelWriterType;
+  typedef otb::MappedRasterFileTeeFilter<MaskImageType>                                     LabelTeeFilterType;
+  typedef otb::MappedRasterFileWriter<FloatImageType>                                       DeltaNDVIWriterType;
+  typedef otb::MappedRasterImageSource<FloatImageType>                                      DeltaNDVISourceType;
+  typedef otb::PrefetchImageFilter<FloatImageType>                                          PrefetchFilterType;
+  typedef otb::RAMDrivenAdaptativeStreamingManager<MaskImageType>                           LabelStreamingManagerType;
+  typedef otb::ExtractROI<FloatImageType::PixelType, FloatImageType::PixelType>             PartExtractROIFilterType;
+  typedef otb::ExtractROI<MaskImageType::PixelType, MaskImageType::PixelType>               LabelExtractROIFilterType;
+  typedef otb::ImageFileReader<FloatVectorImageType>                                        ReaderType;
+  typedef otb::CandidateBlocksImageFilter<FloatImageType>                                   CandidateBlocksFilterType;
+  typedef otb::StreamingCoarseCandidatesFilter<FloatImageType>                              CoarseCandidatesFilterType;
+  typedef otb::ConcatenateVectorImageFilter<FloatVectorImageType, FloatVectorImageType,
+      FloatVectorImageType>                                                                 ConcatenateFilterType;
+  typedef otb::VectorDataProjectionFilter<VectorDataType, VectorDataType>                   VectorDataProjectionFilterType;
+  typedef otb::VectorDataMaskImageFilter<FloatVectorImageType, VectorDataType>              VectorMaskFilterType;
+
+  /** Filters computing the (masked) dNDVI of the overlap of two images */
+  struct DeltaNDVIPipeline
+  {
+    ResampleImageFilterType::Pointer resampleFilter;
+    GridResampleFilterType::Pointer  gridResampleFilter;
+    ExtractROIFilterType::Pointer    extractROIFilter;
+    DeltaNDVIFilterType::Pointer     deltaNDVIFilter;
+    MaskImageFilterType::Pointer     maskImageFilter;
+    MaskHandlerType::Pointer         maskHandler;
+  };
+
+  /** Filters appending the quality band of an input image */
+  struct QualityBand
+  {
+    GridResampleFilterType::Pointer  gridResampleFilter;
+    ResampleImageFilterType::Pointer resampleFilter;
+    ConcatenateFilterType::Pointer   concatenateFilter;
+    unsigned int                     channel;
+  };
+
+  /** Filters restricting an input image to a vector data mask */
+  struct VectorMask
+  {
+    VectorDataProjectionFilterType::Pointer projectionFilter;
+    VectorMaskFilterType::Pointer           maskFilter;
+  };
+
+  /** Quality masks types */
+  enum QualityMaskTypes
+  {
+    qa_classes, qa_bits
+  };
+
+  /** Connected components methods */
+  enum ComponentsMethods
+  {
+    halo, table, sparse
+  };
+
+  /** Job modes */
+  enum JobModes
+  {
+    full, stats, detect
+  };
+
+  /** Statistics of the full resolution pass, in coarse-to-fine processing */
+  enum CoarseStatistics
+  {
+    coarse_stats_full, coarse_stats_coarse
+  };
+
+  /** Parts of a distributed job are aligned on this number of rows (the bands of the statistics) */
+  static const unsigned int PartRowsAlignment = 256;
 
   void DoUpdateParameters()
   {
@@ -100,16 +217,10 @@ public:
 
     AddDocTag(Tags::ChangeDetection);
 
-    ClearApplications();
-
-    // Add applications
-    AddApplication("ExtractGeom", "roib" , "Extract ROI from image b");
-    AddApplication("ExtractGeom", "roia" , "Extract ROI from image a");
-
-    // Shared parameters
-    ShareParameter("inbmask", "roib.vec", "Input vector data for T0 Image mask (Before)", "Input vector data for T0 Image mask (Before)");
+    // Input images masks
+    AddParameter(ParameterType_InputVectorData, "inbmask", "Input vector data for T0 Image mask (Before)");
     MandatoryOff("inbmask");
-    ShareParameter("inamask", "roia.vec", "Input vector data for T1 Image mask (After)" , "Input vector data for T1 Image mask (After)" );
+    AddParameter(ParameterType_InputVectorData, "inamask", "Input vector data for T1 Image mask (After)" );
     MandatoryOff("inamask");
 
     // Input images
@@ -141,66 +252,332 @@ public:
     SetMinimumParameterIntValue("reda", 1);
     SetDefaultParameterInt     ("reda", 1);
 
+    // Quality masks
+    AddParameter(ParameterType_InputImage, "inbqa", "Input T0 quality mask (Before)");
+    SetParameterDescription("inbqa", "Quality band of the T0 image (e.g. Sentinel-2 SCL), resampled "
+        "with the nearest neighbor on the T0 image grid. Pixels failing the quality test are no-data.");
+    MandatoryOff("inbqa");
+    AddParameter(ParameterType_InputImage, "inaqa", "Input T1 quality mask (After)");
+    SetParameterDescription("inaqa", "Quality band of the T1 image, as inbqa.");
+    MandatoryOff("inaqa");
+
+    AddParameter(ParameterType_Choice, "qa", "Quality mask type");
+    AddChoice("qa.classes", "Classification (e.g. Sentinel-2 SCL)");
+    AddParameter(ParameterType_String, "qa.classes.invalid", "Invalid classes");
+    SetParameterDescription("qa.classes.invalid", "Space separated classes values (0 to 31). The "
+        "default is no-data, saturated, cloud shadows, medium and high probability clouds, and cirrus "
+        "of the Sentinel-2 SCL.");
+    SetParameterString("qa.classes.invalid", "0 1 3 8 9 10");
+    MandatoryOff("qa.classes.invalid");
+    AddChoice("qa.bits", "Bitmask (e.g. Landsat QA_PIXEL)");
+    AddParameter(ParameterType_Int, "qa.bits.mask", "Invalid bits");
+    SetParameterDescription("qa.bits.mask", "Pixels whose quality value has one of these bits set are "
+        "not valid. The default is the dilated cloud, cloud and cloud shadow bits of Landsat QA_PIXEL.");
+    SetMinimumParameterIntValue("qa.bits.mask", 0);
+    SetDefaultParameterInt     ("qa.bits.mask", 26);
+    MandatoryOff("qa.bits.mask");
+
+    // Threshold
+    AddParameter(ParameterType_Float, "sigma", "dNDVI threshold, in standard deviations below the mean");
+    SetParameterDescription("sigma", "Pixels with dNDVI <= mean - sigma * std are clear cuts (std is the "
+        "standard deviation of the dNDVI).");
+    SetMinimumParameterFloatValue("sigma", 0.0);
+    SetDefaultParameterFloat     ("sigma", 3.0);
+    MandatoryOff("sigma");
+
     // Spatial filtering (connected components)
     AddParameter(ParameterType_Int, "filt", "Minimum number of pixels detected" );
     SetMinimumParameterIntValue("filt", 1  );
     SetMaximumParameterIntValue("filt", 100);
     SetDefaultParameterInt     ("filt", 10 );
 
+    AddParameter(ParameterType_Choice, "cc", "Connected components method");
+    SetParameterDescription("cc", "Method used to remove the connected components smaller than filt.");
+    AddChoice("cc.halo", "Each streamed tile is computed with a margin of filt pixels");
+    AddChoice("cc.table", "Global components table: a first pass computes the components across "
+        "the tiles, then small components are removed during the vectorization, without any margin");
+    AddParameter(ParameterType_OutputFilename, "cc.table.outids", "Output component IDs image (.ccr)");
+    SetParameterDescription("cc.table.outids", "Image of the components IDs (0 outside the components), "
+        "in the native memory-mapped raster format. IDs index the attribute table.");
+    MandatoryOff("cc.table.outids");
+    AddParameter(ParameterType_OutputFilename, "cc.table.outattr", "Output components attribute table (.csv)");
+    SetParameterDescription("cc.table.outattr", "Area, bounding box (pixel indices in the full input images, also in mode.detect) and min/mean dNDVI of each component. "
+        "In mode.detect, only the components starting in the rows of the part are written, and the ones which can be "
+        "truncated by the margin of the part are flagged.");
+    MandatoryOff("cc.table.outattr");
+    AddChoice("cc.sparse", "Sparse pipeline: the dNDVI is thresholded directly into runs of candidate "
+        "pixels, whose components are filtered and polygonized without any label image");
+
+    AddParameter(ParameterType_Int, "connectivity", "Connectivity of the components (4 or 8)");
+    SetMinimumParameterIntValue("connectivity", 4);
+    SetMaximumParameterIntValue("connectivity", 8);
+    SetDefaultParameterInt     ("connectivity", 4);
+    MandatoryOff("connectivity");
+
     // Output vector
     AddParameter(ParameterType_OutputVectorData, "outvec", "Output vector layer");
+    MandatoryOff("outvec");
+
+    // Output label image
+    AddParameter(ParameterType_OutputFilename, "outlabels", "Output label image (.ccr)");
+    SetParameterDescription("outlabels", "Filtered label image, in the native memory-mapped raster "
+        "format (uint8 pixels), which ClearCutsAggregation maps in memory (ilm parameter). It is written "
+        "by the vectorization pass, without a second computation of the label image.");
+    MandatoryOff("outlabels");
+
+    // Distributed job
+    AddParameter(ParameterType_Choice, "mode", "Job mode");
+    SetParameterDescription("mode", "Process the whole overlap, or one part of a distributed job. "
+        "A distributed job runs in two steps: first each part computes its partial dNDVI statistics "
+        "(mode.stats), then each part merges all partial statistics and computes the clear cuts "
+        "over its own rows (mode.detect). Partial layers are finally merged with the "
+        "ClearCutsStitching application.");
+    AddChoice("mode.full", "Whole overlap");
+    AddChoice("mode.stats", "Partial dNDVI statistics of one part");
+    AddParameter(ParameterType_OutputFilename, "mode.stats.out", "Output partial statistics file");
+    AddChoice("mode.detect", "Clear cuts of one part, from all partial statistics");
+    AddParameter(ParameterType_InputFilenameList, "mode.detect.il", "Input partial statistics files");
+
+    AddParameter(ParameterType_Int, "part.id", "Part of the distributed job");
+    SetMinimumParameterIntValue("part.id", 0);
+    SetDefaultParameterInt     ("part.id", 0);
+    MandatoryOff("part.id");
+    AddParameter(ParameterType_Int, "part.count", "Number of parts of the distributed job");
+    SetMinimumParameterIntValue("part.count", 1);
+    SetDefaultParameterInt     ("part.count", 1);
+    MandatoryOff("part.count");
+
+    // Pipelined streaming
+    AddParameter(ParameterType_Int, "prefetch", "Number of dNDVI tiles computed in advance");
+    SetParameterDescription("prefetch","Number of dNDVI tiles (input reads and dNDVI computation) "
+        "generated on a worker thread while the current tile is labeled and vectorized. "
+        "The available RAM is shared between the in-flight tiles. 0 disables the prefetch.");
+    SetMinimumParameterIntValue("prefetch", 0);
+    SetDefaultParameterInt     ("prefetch", 1);
+    MandatoryOff("prefetch");
+
+    // Coarse-to-fine processing
+    AddParameter(ParameterType_Group, "coarse", "Coarse-to-fine processing");
+    SetParameterDescription("coarse", "The dNDVI is first computed and thresholded on an overview "
+        "level of the input images, then only the blocks containing candidate clear cuts are "
+        "processed at full resolution. The candidates are selected with the statistics of the coarse dNDVI. "
+        "Input images must be files with internal or external overviews (e.g. built with gdaladdo). "
+        "Only available with mode.full.");
+    AddParameter(ParameterType_Int, "coarse.level", "Overview level");
+    SetParameterDescription("coarse.level", "Overview level of the input images used for the "
+        "coarse pass (1 is the first overview). 0 disables the coarse-to-fine processing.");
+    SetMinimumParameterIntValue("coarse.level", 0);
+    SetDefaultParameterInt     ("coarse.level", 0);
+    MandatoryOff("coarse.level");
+    AddParameter(ParameterType_Int, "coarse.blocksize", "Size of the full resolution blocks");
+    SetMinimumParameterIntValue("coarse.blocksize", 16);
+    SetDefaultParameterInt     ("coarse.blocksize", 256);
+    MandatoryOff("coarse.blocksize");
+    AddParameter(ParameterType_Int, "coarse.margin", "Safety margin around the candidates (full resolution pixels)");
+    SetMinimumParameterIntValue("coarse.margin", 0);
+    SetDefaultParameterInt     ("coarse.margin", 64);
+    MandatoryOff("coarse.margin");
+    AddParameter(ParameterType_Float, "coarse.relax", "Threshold relaxation of the coarse pass (in sigma)");
+    SetParameterDescription("coarse.relax", "Coarse pixels are candidates when dNDVI < mean - (sigma - relax) * std, "
+        "sigma being the threshold parameter and std the standard deviation of the dNDVI. "
+        "The decimation smooths small clear cuts, which the relaxation keeps as candidates.");
+    SetMinimumParameterFloatValue("coarse.relax", 0.0);
+    SetDefaultParameterFloat     ("coarse.relax", 0.5);
+    MandatoryOff("coarse.relax");
+    AddParameter(ParameterType_Choice, "coarse.stats", "Statistics of the full resolution thresholds");
+    AddChoice("coarse.stats.full", "Full resolution dNDVI: exact thresholds, the whole full resolution "
+        "images are read once (statistics only)");
+    AddChoice("coarse.stats.coarse", "Coarse dNDVI: approximate thresholds, since the decimation "
+        "smooths the dNDVI (lower sigma), but only the candidate blocks are read at full resolution");
+    SetParameterDescription("coarse.stats", "Statistics used for the thresholds of the full resolution pass. "
+        "The candidate blocks are always selected with the coarse statistics.");
+    MandatoryOff("coarse.stats");
+
+    // Job cache
+    AddParameter(ParameterType_Directory, "cache", "Job cache directory");
+    SetParameterDescription("cache", "The dNDVI and its statistics are stored in this directory, "
+        "under a key computed from the input files (path, size, modification time) and the "
+        "parameters of the dNDVI. A rerun with the same inputs (e.g. another filt or sigma) "
+        "reads them instead of the input images. Only used with mode.full, without "
+        "coarse-to-fine processing.");
+    MandatoryOff("cache");
 
     AddRAMParameter();
   }
 
-  void PrepareFilters(FloatVectorImageType * &imageToResample,
+  /*
+   * Extract the overlap of one image, and resample the other one over it.
+   * Returns the resampled image.
+   */
+  FloatVectorImageType * PrepareFilters(FloatVectorImageType * &imageToResample,
       FloatVectorImageType * &imageToExtract,
-      FloatVectorImageType::RegionType imageToExtractRegion)
+      FloatVectorImageType::RegionType imageToExtractRegion,
+      DeltaNDVIPipeline & pipeline)
   {
+    // Initialize roi extract filter
+    pipeline.extractROIFilter = ExtractROIFilterType::New();
+    pipeline.extractROIFilter->SetInput(imageToExtract);
+    pipeline.extractROIFilter->SetExtractionRegion(imageToExtractRegion);
+    pipeline.extractROIFilter->UpdateOutputInformation();
+    FloatVectorImageType * extractedImage = pipeline.extractROIFilter->GetOutput();
+
+    // Same CRS: the nearest neighbor mapping is separable, use index tables
+    if (imageToResample->GetProjectionRef() == imageToExtract->GetProjectionRef())
+      {
+      otbAppLogINFO("Same projection: using grid aligned resampling");
+      pipeline.gridResampleFilter = GridResampleFilterType::New();
+      pipeline.gridResampleFilter->SetInput(imageToResample);
+      pipeline.gridResampleFilter->SetOutputOrigin(extractedImage->GetOrigin());
+      pipeline.gridResampleFilter->SetOutputSpacing(extractedImage->GetSignedSpacing());
+      pipeline.gridResampleFilter->SetOutputSize(extractedImage->GetLargestPossibleRegion().GetSize());
+      pipeline.gridResampleFilter->UpdateOutputInformation();
+      return pipeline.gridResampleFilter->GetOutput();
+      }
+
     // Initialize resample filter
     NNInterpolatorType::Pointer interpolator = NNInterpolatorType::New();
-    m_ResampleFilter = ResampleImageFilterType::New();
-    m_ResampleFilter->SetInput(imageToResample);
-    m_ResampleFilter->SetInterpolator(interpolator);
-
-    // Initialize roi extract filter
-    m_ExtractROIFilter = ExtractROIFilterType::New();
-    m_ExtractROIFilter->SetInput(imageToExtract);
-    m_ExtractROIFilter->SetExtractionRegion(imageToExtractRegion);
-    m_ExtractROIFilter->UpdateOutputInformation();
+    pipeline.resampleFilter = ResampleImageFilterType::New();
+    pipeline.resampleFilter->SetInput(imageToResample);
+    pipeline.resampleFilter->SetInterpolator(interpolator);
 
     // Set the resample filter with extracted image origin, spacing, and size
-    m_ResampleFilter->SetOutputOrigin(m_ExtractROIFilter->GetOutput()->GetOrigin());
-    m_ResampleFilter->SetOutputSpacing(m_ExtractROIFilter->GetOutput()->GetSignedSpacing());
-    m_ResampleFilter->SetOutputSize(m_ExtractROIFilter->GetOutput()->GetLargestPossibleRegion().GetSize());
-    m_ResampleFilter->UpdateOutputInformation();
+    pipeline.resampleFilter->SetOutputOrigin(extractedImage->GetOrigin());
+    pipeline.resampleFilter->SetOutputSpacing(extractedImage->GetSignedSpacing());
+    pipeline.resampleFilter->SetOutputSize(extractedImage->GetLargestPossibleRegion().GetSize());
+    pipeline.resampleFilter->UpdateOutputInformation();
+    return pipeline.resampleFilter->GetOutput();
   }
 
-  void DoExecute()
+  /*
+   * Restrict an input image to the input vector data mask (if any).
+   * The polygons are reprojected in the image projection, then filled
+   * tile by tile with the pixels of the image (outside pixels are 0)
+   */
+  FloatVectorImageType * ApplyInputMask(FloatVectorImageType * image, std::string maskKey, VectorMask & mask)
   {
+    if (!HasValue(maskKey))
+      return image;
+
+    image->UpdateOutputInformation();
+    VectorDataType * vectorData = GetParameterVectorData(maskKey);
+    mask.projectionFilter = VectorDataProjectionFilterType::New();
+    mask.projectionFilter->SetInput(vectorData);
+    mask.projectionFilter->SetInputProjectionRef(vectorData->GetProjectionRef());
+    mask.projectionFilter->SetOutputKeywordList(image->GetImageKeywordlist());
+    mask.projectionFilter->SetOutputProjectionRef(image->GetProjectionRef());
+    mask.projectionFilter->Update();
+
+    mask.maskFilter = VectorMaskFilterType::New();
+    mask.maskFilter->SetInput(image);
+    mask.maskFilter->SetVectorData(mask.projectionFilter->GetOutput());
+    mask.maskFilter->UpdateOutputInformation();
+    otbAppLogINFO("Input " << maskKey << ": " << mask.maskFilter->GetNumberOfPolygons() << " polygon(s)");
+    return mask.maskFilter->GetOutput();
+  }
+
+  /*
+   * Append the quality band of an input image (if any) after its bands,
+   * on the grid of the image (nearest neighbor)
+   */
+  FloatVectorImageType * AppendQualityBand(FloatVectorImageType * image, std::string qaKey, QualityBand & quality)
+  {
+    quality.channel = 0;
+    if (!HasValue(qaKey))
+      return image;
+
+    image->UpdateOutputInformation();
+    FloatVectorImageType * qaImage = GetParameterImage(qaKey);
+    qaImage->UpdateOutputInformation();
+    FloatVectorImageType * resampledImage;
+    if (qaImage->GetProjectionRef() == image->GetProjectionRef())
+      {
+      quality.gridResampleFilter = GridResampleFilterType::New();
+      quality.gridResampleFilter->SetInput(qaImage);
+      quality.gridResampleFilter->SetOutputOrigin(image->GetOrigin());
+      quality.gridResampleFilter->SetOutputSpacing(image->GetSignedSpacing());
+      quality.gridResampleFilter->SetOutputSize(image->GetLargestPossibleRegion().GetSize());
+      resampledImage = quality.gridResampleFilter->GetOutput();
+      }
+    else
+      {
+      NNInterpolatorType::Pointer interpolator = NNInterpolatorType::New();
+      quality.resampleFilter = ResampleImageFilterType::New();
+      quality.resampleFilter->SetInput(qaImage);
+      quality.resampleFilter->SetInterpolator(interpolator);
+      quality.resampleFilter->SetOutputOrigin(image->GetOrigin());
+      quality.resampleFilter->SetOutputSpacing(image->GetSignedSpacing());
+      quality.resampleFilter->SetOutputSize(image->GetLargestPossibleRegion().GetSize());
+      resampledImage = quality.resampleFilter->GetOutput();
+      }
 
-    // Get input images pointers
-    FloatVectorImageType* t0 = GetParameterImage("inb");
-    FloatVectorImageType* t1 = GetParameterImage("ina");
+    quality.concatenateFilter = ConcatenateFilterType::New();
+    quality.concatenateFilter->SetInput1(image);
+    quality.concatenateFilter->SetInput2(resampledImage);
+    quality.concatenateFilter->UpdateOutputInformation();
+    quality.channel = image->GetNumberOfComponentsPerPixel() + 1;
+    otbAppLogINFO("Quality mask " << qaKey << " appended as band " << quality.channel);
+    return quality.concatenateFilter->GetOutput();
+  }
+
+  /*
+   * Bits tested in the quality bands
+   */
+  unsigned int GetQualityMask()
+  {
+    if (GetParameterInt("qa") == qa_bits)
+      return GetParameterInt("qa.bits.mask");
 
-    // Use input image mask for image b (t0)
-    if (HasValue("inbmask"))
+    unsigned int mask = 0;
+    std::istringstream classes(GetParameterString("qa.classes.invalid"));
+    int value;
+    while (classes >> value)
       {
-        GetInternalApplication("roib")->SetParameterInputImage("in", GetParameterImage("inb"));
-        ExecuteInternal("roib");
-        t0 = static_cast<FloatVectorImageType*>(GetInternalApplication("roib")->GetParameterOutputImage("out"));
-        t0->UpdateOutputInformation();
+      if (value < 0 || value > 31)
+        {
+        otbAppLogFATAL("Quality classes must be in [0, 31]");
+        }
+      mask |= 1u << value;
       }
+    if (!classes.eof())
+      {
+      otbAppLogFATAL("Invalid quality classes: " << GetParameterString("qa.classes.invalid"));
+      }
+    return mask;
+  }
 
-    // Use input image mask for image a (t1)
-    if (HasValue("inamask"))
+  /*
+   * Vegetation masks directory, from the input parameter or the environment.
+   * Returns false if there is no vegetation mask.
+   */
+  bool GetForestMasksDirectory(std::string & forestMasksDir)
+  {
+    bool hasForestMask = false;
+
+    // Input parameter
+    if (HasValue("masksdir"))
       {
-        GetInternalApplication("roia")->SetParameterInputImage("in", GetParameterImage("ina"));
-        ExecuteInternal("roia");
-        t1 = static_cast<FloatVectorImageType*>(GetInternalApplication("roia")->GetParameterOutputImage("out"));
-        t1->UpdateOutputInformation();
+        hasForestMask = true;
+        forestMasksDir = GetParameterAsString("masksdir");
       }
 
+    // Environment variable
+    char * envVarVal = std::getenv("FOREST_MASK_DIR");
+    if (envVarVal != NULL)
+      {
+        hasForestMask = true;
+        forestMasksDir = std::string(envVarVal);
+      }
+
+    return hasForestMask;
+  }
+
+  /*
+   * Build the pipeline computing the dNDVI over the overlap of t0 and t1,
+   * masked with the vegetation masks
+   */
+  FloatImageType * CreateDeltaNDVIPipeline(FloatVectorImageType * t0, FloatVectorImageType * t1,
+      DeltaNDVIPipeline & pipeline, unsigned int qaChannelT0 = 0, unsigned int qaChannelT1 = 0)
+  {
     // Compute rasters intersection region, check overlap
     otb::RegionComparator<FloatVectorImageType, FloatVectorImageType> comparator;
     comparator.SetImage1(t0);
@@ -222,119 +599,875 @@ public:
         // Resample t0 over t1 and extract ROI (overlap) of t1
         otbAppLogINFO("inb-->resampled");
         otbAppLogINFO("ina-->extracted");
-        PrepareFilters(t0, t1, comparator.GetOverlapInImage2Indices());
-        inputExtractedT0 = m_ResampleFilter->GetOutput();
-        inputExtractedT1 = m_ExtractROIFilter->GetOutput();
+        inputExtractedT0 = PrepareFilters(t0, t1, comparator.GetOverlapInImage2Indices(), pipeline);
+        inputExtractedT1 = pipeline.extractROIFilter->GetOutput();
       }
     else
       {
         // Resample t1 over t0 and extract ROI (overlap) of t0
         otbAppLogINFO("inb-->extracted");
         otbAppLogINFO("ina-->resampled");
-        PrepareFilters(t1, t0, comparator.GetOverlapInImage1Indices());
-        inputExtractedT0 = m_ExtractROIFilter->GetOutput();
-        inputExtractedT1 = m_ResampleFilter->GetOutput();
+        inputExtractedT1 = PrepareFilters(t1, t0, comparator.GetOverlapInImage1Indices(), pipeline);
+        inputExtractedT0 = pipeline.extractROIFilter->GetOutput();
       }
 
     // Compute Delta NDVI
-    m_DeltaNDVIFilter = DeltaNDVIFilterType::New();
-    m_DeltaNDVIFilter->SetInput1(inputExtractedT0);
-    m_DeltaNDVIFilter->SetInput2(inputExtractedT1);
-    m_DeltaNDVIFilter->GetFunctor().SetNIRChannelT0(GetParameterInt("nirb"));
-    m_DeltaNDVIFilter->GetFunctor().SetRedChannelT0(GetParameterInt("redb"));
-    m_DeltaNDVIFilter->GetFunctor().SetNIRChannelT1(GetParameterInt("nira"));
-    m_DeltaNDVIFilter->GetFunctor().SetRedChannelT1(GetParameterInt("reda"));
-    m_DeltaNDVIFilter->UpdateOutputInformation();
-
-    // Stats filter
-    m_StatsFilter = StatsFilterType::New();
-    m_StatsFilter->SetIgnoreUserDefinedValue(true);
-    m_StatsFilter->SetUserIgnoredValue(m_DeltaNDVIFilter->GetFunctor().GetNoDataValue());
+    pipeline.deltaNDVIFilter = DeltaNDVIFilterType::New();
+    pipeline.deltaNDVIFilter->SetInput1(inputExtractedT0);
+    pipeline.deltaNDVIFilter->SetInput2(inputExtractedT1);
+    pipeline.deltaNDVIFilter->GetFunctor().SetNIRChannelT0(GetParameterInt("nirb"));
+    pipeline.deltaNDVIFilter->GetFunctor().SetRedChannelT0(GetParameterInt("redb"));
+    pipeline.deltaNDVIFilter->GetFunctor().SetNIRChannelT1(GetParameterInt("nira"));
+    pipeline.deltaNDVIFilter->GetFunctor().SetRedChannelT1(GetParameterInt("reda"));
+    if (qaChannelT0 > 0 || qaChannelT1 > 0)
+      {
+        // Quality test inside the dNDVI functor
+        pipeline.deltaNDVIFilter->GetFunctor().SetQAChannelT0(qaChannelT0);
+        pipeline.deltaNDVIFilter->GetFunctor().SetQAChannelT1(qaChannelT1);
+        pipeline.deltaNDVIFilter->GetFunctor().SetQAMask(GetQualityMask());
+        pipeline.deltaNDVIFilter->GetFunctor().SetQAClasses(GetParameterInt("qa") == qa_classes);
+      }
+    pipeline.deltaNDVIFilter->UpdateOutputInformation();
 
-    FloatImageType * deltaNDVIImage = m_DeltaNDVIFilter->GetOutput();
+    FloatImageType * deltaNDVIImage = pipeline.deltaNDVIFilter->GetOutput();
 
-    // Forest masks
-    bool hasForestMask = false;
+    // Mask directory
     std::string forestMasksDir("");
+    if (GetForestMasksDirectory(forestMasksDir))
+      {
+        otbAppLogINFO("Using vegetation masks from directory " << forestMasksDir);
 
-    // Input parameter
-    if (HasValue("masksdir"))
+        // Mask Delta NDVI image
+        pipeline.maskImageFilter = MaskImageFilterType::New();
+        pipeline.maskImageFilter->SetInput(pipeline.deltaNDVIFilter->GetOutput());
+        pipeline.maskImageFilter->SetOutsideValue(3.0);
+
+        // Instanciate a mosaic from directory handler
+        pipeline.maskHandler = MaskHandlerType::New();
+        pipeline.maskHandler->SetDirectory(forestMasksDir);
+        pipeline.maskHandler->SetReferenceImage(pipeline.deltaNDVIFilter->GetOutput());
+        pipeline.maskHandler->SetUseReferenceImage(true);
+        pipeline.maskHandler->UpdateOutputInformation();
+        pipeline.maskImageFilter->SetMaskImage(pipeline.maskHandler->GetOutput());
+
+        deltaNDVIImage = pipeline.maskImageFilter->GetOutput();
+      }
+
+    return deltaNDVIImage;
+  }
+
+  /*
+   * Read an overview level of an input image
+   */
+  FloatVectorImageType * CreateCoarseReader(std::string key, unsigned int level, ReaderType::Pointer & reader)
+  {
+    std::string filename = GetParameterString(key);
+    if (filename.empty())
       {
-        hasForestMask = true;
-        forestMasksDir = GetParameterAsString("masksdir");
+      otbAppLogFATAL("Coarse-to-fine processing needs the input image " << key << " to be a file");
       }
+    std::ostringstream extendedFilename;
+    extendedFilename << filename << (filename.find('?') == std::string::npos ? "?" : "")
+        << "&resol=" << level;
 
-    // Environment variable
-    char * envVarVal = std::getenv("FOREST_MASK_DIR");
-    if (envVarVal != NULL)
+    reader = ReaderType::New();
+    reader->SetFileName(extendedFilename.str());
+    reader->UpdateOutputInformation();
+
+    // When the overview level does not exist, the full resolution image is read
+    FloatVectorImageType::SpacingType fullSpacing = GetParameterImage(key)->GetSignedSpacing();
+    FloatVectorImageType::SpacingType coarseSpacing = reader->GetOutput()->GetSignedSpacing();
+    if (vnl_math_abs(coarseSpacing[0]) < 1.5 * vnl_math_abs(fullSpacing[0]))
       {
-        hasForestMask = true;
-        forestMasksDir = std::string(envVarVal);
+      otbAppLogFATAL("Image " << filename << " has no overview level " << level
+          << ". Overviews can be built with gdaladdo.");
       }
+    otbAppLogINFO("Coarse " << key << " spacing: " << coarseSpacing);
 
-    // Mask directory
-    if (hasForestMask)
+    return reader->GetOutput();
+  }
+
+  /*
+   * The prefetch filter generates in advance the next splits of the
+   * streaming manager of the dNDVI consumer about to be updated
+   */
+  template <class TStreamingManager>
+  void PrefetchSplits(TStreamingManager * streamingManager)
+  {
+    if (m_PrefetchFilter.IsNotNull())
+      m_PrefetchFilter->SetStreamingManager(streamingManager);
+  }
+
+  /*
+   * Threshold the coarse dNDVI, and mark the full resolution blocks around
+   * the coarse candidate pixels. The coarse dNDVI is streamed.
+   */
+  void ComputeCandidateBlocks(FloatImageType * coarseImage, double threshold, double margin)
+  {
+    m_CoarseCandidatesFilter = CoarseCandidatesFilterType::New();
+    m_CoarseCandidatesFilter->SetInput(coarseImage);
+    m_CoarseCandidatesFilter->SetThreshold(threshold);
+    m_CoarseCandidatesFilter->SetMargin(margin);
+    m_CoarseCandidatesFilter->SetCandidateBlocksFilter(m_CandidateBlocksFilter);
+    m_CoarseCandidatesFilter->GetStreamer()->SetAutomaticAdaptativeStreaming(GetParameterInt("ram"));
+    AddProcess(m_CoarseCandidatesFilter->GetStreamer(), "Computing coarse candidate blocks");
+    m_CoarseCandidatesFilter->Update();
+
+    otbAppLogINFO("Coarse candidate pixels: " << m_CoarseCandidatesFilter->GetNumberOfCandidatePixels()
+        << ", candidate blocks: " << m_CandidateBlocksFilter->GetNumberOfCandidateBlocks() << "/"
+        << m_CandidateBlocksFilter->GetNumberOfBlocks());
+  }
+
+  /*
+   * Rows of the current part of the job
+   */
+  FloatImageType::RegionType ComputePartRegion(const FloatImageType::RegionType & largestRegion)
+  {
+    const unsigned int partId = GetParameterInt("part.id");
+    const unsigned int partCount = GetParameterInt("part.count");
+    if (partId >= partCount)
       {
-        otbAppLogINFO("Using vegetation masks from directory " << forestMasksDir);
+      otbAppLogFATAL("part.id must be lower than part.count");
+      }
 
-        // Mask Delta NDVI image
-        m_MaskImageFilter = MaskImageFilterType::New();
-        m_MaskImageFilter->SetInput(m_DeltaNDVIFilter->GetOutput());
-        m_MaskImageFilter->SetOutsideValue(3.0);
+    const unsigned int nbOfRows = largestRegion.GetSize(1);
+    unsigned int rowsPerPart = (nbOfRows + partCount - 1) / partCount;
+    rowsPerPart = PartRowsAlignment * ((rowsPerPart + PartRowsAlignment - 1) / PartRowsAlignment);
 
-        // Instanciate a mosaic from directory handler
-        m_MaskHandler = MaskHandlerType::New();
-        m_MaskHandler->SetDirectory(forestMasksDir);
-        m_MaskHandler->SetReferenceImage(m_DeltaNDVIFilter->GetOutput());
-        m_MaskHandler->SetUseReferenceImage(true);
-        m_MaskHandler->UpdateOutputInformation();
-        m_MaskImageFilter->SetMaskImage(m_MaskHandler->GetOutput());
+    const unsigned int firstRow = partId * rowsPerPart;
+    if (firstRow >= nbOfRows)
+      {
+      otbAppLogFATAL("Part " << partId << " is empty: the overlap has only " << nbOfRows
+          << " rows, use less parts");
+      }
+
+    FloatImageType::RegionType partRegion(largestRegion);
+    partRegion.SetIndex(1, largestRegion.GetIndex(1) + firstRow);
+    partRegion.SetSize(1, std::min(rowsPerPart, nbOfRows - firstRow));
+    otbAppLogINFO("Part " << partId << "/" << partCount << ": " << partRegion);
+
+    return partRegion;
+  }
+
+  /*
+   * Merge the partial statistics files of all the parts, in the order of the
+   * parts. The bands of rows of the parts are appended, then merged along
+   * the same pairwise tree as the stats filter does in mode.full.
+   */
+  DeltaNDVIStatistics MergePartialStatistics(const FloatImageType::RegionType & largestRegion)
+  {
+    const unsigned int partCount = GetParameterInt("part.count");
+    std::vector<std::string> filenames = GetParameterStringList("mode.detect.il");
+
+    std::vector<DeltaNDVIStatistics> partStatistics(partCount);
+    std::vector<bool> hasPart(partCount, false);
+    for (unsigned int i = 0 ; i < filenames.size() ; i++)
+      {
+      DeltaNDVIStatistics partialStatistics;
+      if (!partialStatistics.Read(filenames[i]))
+        {
+        otbAppLogFATAL("Unable to read statistics file " << filenames[i]);
+        }
+      if (partialStatistics.GetPartCount() != partCount || partialStatistics.GetPartId() >= partCount)
+        {
+        otbAppLogFATAL("Statistics file " << filenames[i] << " is not a part of a "
+            << partCount << " parts job");
+        }
+      partStatistics[partialStatistics.GetPartId()] = partialStatistics;
+      hasPart[partialStatistics.GetPartId()] = true;
+      }
 
-        deltaNDVIImage = m_MaskImageFilter->GetOutput();
+    DeltaNDVIStatistics statistics;
+    for (unsigned int part = 0 ; part < partCount ; part++)
+      {
+      if (!hasPart[part])
+        {
+        otbAppLogFATAL("Missing statistics of part " << part);
+        }
+      statistics.AddBands(partStatistics[part]);
       }
 
-    // Wire stats filter
-    m_StatsFilter->SetInput(deltaNDVIImage);
+    const unsigned int nbOfBands = (largestRegion.GetSize(1) + PartRowsAlignment - 1) / PartRowsAlignment;
+    if (statistics.GetNumberOfBands() != nbOfBands)
+      {
+      otbAppLogFATAL("Partial statistics have " << statistics.GetNumberOfBands() << " bands of rows, "
+          << nbOfBands << " expected: they do not come from this overlap");
+      }
 
-    // Compute stats
+    return statistics;
+  }
+
+  /*
+   * FNV-1a hash
+   */
+  static void HashBytes(uint64_t & hash, const void * data, size_t size)
+  {
+    const unsigned char * bytes = static_cast<const unsigned char *>(data);
+    for (size_t i = 0 ; i < size ; i++)
+      {
+      hash ^= bytes[i];
+      hash *= 1099511628211ULL;
+      }
+  }
+
+  static void HashString(uint64_t & hash, const std::string & value)
+  {
+    HashBytes(hash, value.c_str(), value.size() + 1);
+  }
+
+  /*
+   * Hash the identity of a file (path, size, modification time).
+   * Returns false if the file does not exist.
+   */
+  static bool HashFile(uint64_t & hash, const std::string & filename)
+  {
+    struct stat fileStat;
+    if (filename.empty() || ::stat(filename.c_str(), &fileStat) != 0)
+      return false;
+    const uint64_t size = fileStat.st_size;
+    const int64_t mtime = fileStat.st_mtime;
+    HashString(hash, filename);
+    HashBytes(hash, &size, sizeof(size));
+    HashBytes(hash, &mtime, sizeof(mtime));
+    return true;
+  }
+
+  /*
+   * Files of the vegetation masks directory with a GeoTIFF extension, like
+   * the ones the mask handler reads, sorted by name.
+   * Returns false if the directory can not be read.
+   */
+  static bool GetForestMasksFiles(const std::string & forestMasksDir, std::vector<std::string> & files)
+  {
+    itksys::Directory directory;
+    if (!directory.Load(forestMasksDir))
+      return false;
+    for (unsigned long i = 0 ; i < directory.GetNumberOfFiles() ; i++)
+      {
+      const std::string filename = itksys::SystemTools::CollapseFullPath(directory.GetFile(i), forestMasksDir);
+      const std::string extension = itksys::SystemTools::LowerCase(
+          itksys::SystemTools::GetFilenameLastExtension(filename));
+      if ((extension == ".tif" || extension == ".tiff") && !itksys::SystemTools::FileIsDirectory(filename))
+        files.push_back(filename);
+      }
+    std::sort(files.begin(), files.end());
+    return true;
+  }
+
+  /*
+   * Directory of the job in the cache, from the inputs of the dNDVI.
+   * Returns an empty string if the inputs can not be identified.
+   */
+  std::string GetCacheDirectory()
+  {
+    uint64_t hash = 14695981039346656037ULL;
+    HashString(hash, "ClearCutsDetection dNDVI v1");
+
+    // Input images (extended filenames are part of the path)
+    const char * inputKeys[] = {"inb", "ina"};
+    for (unsigned int i = 0 ; i < 2 ; i++)
+      {
+      std::string filename = GetParameterString(inputKeys[i]);
+      if (!HashFile(hash, filename.substr(0, filename.find('?'))))
+        {
+        otbAppLogINFO("Input " << inputKeys[i] << " is not a file: the job cache is not used");
+        return "";
+        }
+      HashString(hash, filename);
+      }
+
+    // Vector masks
+    const char * maskKeys[] = {"inbmask", "inamask"};
+    for (unsigned int i = 0 ; i < 2 ; i++)
+      {
+      HashString(hash, maskKeys[i]);
+      if (HasValue(maskKeys[i]))
+        HashFile(hash, GetParameterString(maskKeys[i]));
+      }
+
+    // Quality masks
+    const char * qaKeys[] = {"inbqa", "inaqa"};
+    for (unsigned int i = 0 ; i < 2 ; i++)
+      {
+      HashString(hash, qaKeys[i]);
+      if (HasValue(qaKeys[i]))
+        {
+        std::string filename = GetParameterString(qaKeys[i]);
+        if (!HashFile(hash, filename.substr(0, filename.find('?'))))
+          {
+          otbAppLogINFO("Input " << qaKeys[i] << " is not a file: the job cache is not used");
+          return "";
+          }
+        HashString(hash, filename);
+        const uint32_t qaMask = GetQualityMask();
+        const int32_t qaType = GetParameterInt("qa");
+        HashBytes(hash, &qaMask, sizeof(qaMask));
+        HashBytes(hash, &qaType, sizeof(qaType));
+        }
+      }
+
+    // Vegetation masks (every GeoTIFF file the mask handler mosaics)
+    std::string forestMasksDir("");
+    if (GetForestMasksDirectory(forestMasksDir))
+      {
+      std::vector<std::string> maskFiles;
+      if (!GetForestMasksFiles(forestMasksDir, maskFiles))
+        {
+        otbAppLogINFO("Unable to list the vegetation masks directory: the job cache is not used");
+        return "";
+        }
+      HashString(hash, "masksdir");
+      for (unsigned int i = 0 ; i < maskFiles.size() ; i++)
+        HashFile(hash, maskFiles[i]);
+      }
+
+    // Bands
+    const char * bandKeys[] = {"nirb", "redb", "nira", "reda"};
+    for (unsigned int i = 0 ; i < 4 ; i++)
+      {
+      const int32_t band = GetParameterInt(bandKeys[i]);
+      HashBytes(hash, &band, sizeof(band));
+      }
+
+    char key[17];
+    std::snprintf(key, sizeof(key), "%016llx", static_cast<unsigned long long>(hash));
+    std::string cacheDir = GetParameterAsString("cache") + "/" + key;
+    if (::mkdir(cacheDir.c_str(), 0755) != 0 && errno != EEXIST)
+      {
+      otbAppLogFATAL("Unable to create cache directory " << cacheDir);
+      }
+    return cacheDir;
+  }
+
+  /*
+   * Cached dNDVI and statistics, or NULL if they are not in the cache
+   */
+  FloatImageType * ReadCachedDeltaNDVI(const std::string & cacheDir)
+  {
+    DeltaNDVIStatistics statistics;
+    const std::string deltaNDVIFileName = cacheDir + "/dndvi.ccr";
+    struct stat fileStat;
+    if (::stat(deltaNDVIFileName.c_str(), &fileStat) != 0 || !statistics.Read(cacheDir + "/stats.txt"))
+      return NULL;
+
+    otbAppLogINFO("Using cached dNDVI from " << cacheDir);
+    m_MeanObject = RealObjectType::New();
+    m_MeanObject->Set(statistics.GetMean());
+    m_SigmaObject = RealObjectType::New();
+    m_SigmaObject->Set(statistics.GetSigma());
+
+    m_DeltaNDVISource = DeltaNDVISourceType::New();
+    m_DeltaNDVISource->SetFileName(deltaNDVIFileName);
+    return m_DeltaNDVISource->GetOutput();
+  }
+
+  /*
+   * Write the dNDVI in the cache, then compute its statistics from the
+   * cached image. Files are written under temporary names, then renamed.
+   */
+  FloatImageType * WriteCachedDeltaNDVI(const std::string & cacheDir, FloatImageType * deltaNDVIImage)
+  {
+    m_DeltaNDVIWriter = DeltaNDVIWriterType::New();
+    m_DeltaNDVIWriter->SetInput(deltaNDVIImage);
+    m_DeltaNDVIWriter->SetFileName(cacheDir + "/dndvi.ccr");
+    m_DeltaNDVIWriter->SetAvailableRAM(GetParameterInt("ram"));
+    AddProcess(m_DeltaNDVIWriter, "Writing dNDVI in the job cache");
+    m_DeltaNDVIWriter->Update();
+
+    m_DeltaNDVISource = DeltaNDVISourceType::New();
+    m_DeltaNDVISource->SetFileName(cacheDir + "/dndvi.ccr");
+
+    m_StatsFilter->SetInput(m_DeltaNDVISource->GetOutput());
+    m_StatsFilter->SetBlockAlignedStreaming(GetParameterInt("ram"));
     AddProcess(m_StatsFilter->GetStreamer(),"Computing dNDVI statistics");
     m_StatsFilter->Update();
 
+    const std::string statsFileName = cacheDir + "/stats.txt";
+    m_StatsFilter->GetStatistics().Write(statsFileName + ".tmp");
+    if (std::rename((statsFileName + ".tmp").c_str(), statsFileName.c_str()) != 0)
+      {
+      otbAppLogFATAL("Unable to write " << statsFileName);
+      }
+
+    m_MeanObject = RealObjectType::New();
+    m_MeanObject->Set(m_StatsFilter->GetMeanOutput()->Get());
+    m_SigmaObject = RealObjectType::New();
+    m_SigmaObject->Set(m_StatsFilter->GetSigmaOutput()->Get());
+
+    return m_DeltaNDVISource->GetOutput();
+  }
+
+  /*
+   * Write the attributes of the connected components in a CSV file.
+   * The bounding boxes are offset by the index of the components region
+   * in the input images, so they are indices of the full input images
+   * (and not of the part extracted in detect mode).
+   *
+   * In detect mode, the components are computed over the part plus a
+   * margin of rows: only the components whose first pixel is in the rows
+   * of the part are written, so that each component is written by one
+   * part only. A component reaching a row where the margin was cut from
+   * the image can be truncated: it is flagged in the truncated column.
+   */
+  void WriteComponentsAttributes(const RunTableType & runTable, const MaskImageType::IndexType & origin,
+      const FloatImageType::RegionType & partRegion, const FloatImageType::RegionType & componentsRegion,
+      bool cutFirstRow, bool cutLastRow, std::string filename)
+  {
+    const long firstPartRow = partRegion.GetIndex(1);
+    const long lastPartRow = firstPartRow + static_cast<long>(partRegion.GetSize(1)) - 1;
+    const long lastRow = static_cast<long>(componentsRegion.GetSize(1)) - 1;
+    std::ofstream file(filename.c_str());
+    if (!file)
+      {
+      otbAppLogFATAL("Unable to write " << filename);
+      }
+    file << "id,label,area,xmin,ymin,xmax,ymax,dndvimin,dndvimean,truncated" << std::endl;
+    file.precision(8);
+    for (unsigned long id = 0 ; id < runTable.GetNumberOfComponents() ; id++)
+      {
+      const RunTableType::ComponentAttributes & attributes = runTable.GetComponentAttributes(id);
+      if (attributes.yMin < firstPartRow || attributes.yMin > lastPartRow)
+        continue;
+      const bool truncated = (cutFirstRow && attributes.yMin == 0) || (cutLastRow && attributes.yMax == lastRow);
+      file << (id + 1) << "," << static_cast<unsigned int>(attributes.label) << "," << attributes.area
+          << "," << (origin[0] + attributes.xMin) << "," << (origin[1] + attributes.yMin)
+          << "," << (origin[0] + attributes.xMax) << "," << (origin[1] + attributes.yMax)
+          << "," << attributes.minValue << "," << attributes.GetMeanValue() << "," << (truncated ? 1 : 0)
+          << std::endl;
+      }
+  }
+
+  void DoExecute()
+  {
+
+    // Distributed job
+    const int jobMode = GetParameterInt("mode");
+    const unsigned int coarseLevel = GetParameterInt("coarse.level");
+    const double sigmaMultiplier = GetParameterFloat("sigma");
+    const double noDataValue = DeltaNDVIFunctorType().GetNoDataValue();
+
+    // Stats filter
+    m_StatsFilter = StatsFilterType::New();
+    m_StatsFilter->SetIgnoreUserDefinedValue(true);
+    m_StatsFilter->SetUserIgnoredValue(noDataValue);
+    m_StatsFilter->SetBlockSize(PartRowsAlignment);
+
+    // Job cache
+    std::string cacheDir("");
+    if (HasValue("cache"))
+      {
+      if (jobMode == full && coarseLevel == 0)
+        cacheDir = GetCacheDirectory();
+      else
+        otbAppLogINFO("The job cache is only used with mode.full, without coarse-to-fine processing");
+      }
+
+    // Delta NDVI
+    FloatImageType * deltaNDVIImage = NULL;
+    if (!cacheDir.empty())
+      {
+      deltaNDVIImage = ReadCachedDeltaNDVI(cacheDir);
+      }
+    const bool isCached = (deltaNDVIImage != NULL);
+    if (!isCached)
+      {
+      // Input images with their quality bands, restricted to their vector data masks
+      FloatVectorImageType* t0 = ApplyInputMask(
+          AppendQualityBand(GetParameterImage("inb"), "inbqa", m_QualityT0), "inbmask", m_MaskT0);
+      FloatVectorImageType* t1 = ApplyInputMask(
+          AppendQualityBand(GetParameterImage("ina"), "inaqa", m_QualityT1), "inamask", m_MaskT1);
+
+      deltaNDVIImage = CreateDeltaNDVIPipeline(t0, t1, m_Pipeline, m_QualityT0.channel, m_QualityT1.channel);
+      if (!cacheDir.empty())
+        {
+        deltaNDVIImage = WriteCachedDeltaNDVI(cacheDir, deltaNDVIImage);
+        }
+      }
+
+    // Coarse-to-fine processing: statistics and candidate blocks from an overview level
+    if (coarseLevel > 0)
+      {
+      if (jobMode != full)
+        {
+        otbAppLogFATAL("Coarse-to-fine processing is only available with mode.full");
+        }
+      if (HasValue("inbqa") || HasValue("inaqa"))
+        {
+        otbAppLogFATAL("Quality masks can not be resampled on overview levels: "
+            "they are not available with coarse-to-fine processing");
+        }
+      otbAppLogINFO("Coarse pass on overview level " << coarseLevel);
+
+      FloatVectorImageType * coarseT0 = ApplyInputMask(
+          CreateCoarseReader("inb", coarseLevel, m_CoarseReaderT0), "inbmask", m_CoarseMaskT0);
+      FloatVectorImageType * coarseT1 = ApplyInputMask(
+          CreateCoarseReader("ina", coarseLevel, m_CoarseReaderT1), "inamask", m_CoarseMaskT1);
+      FloatImageType * coarseDeltaNDVIImage = CreateDeltaNDVIPipeline(coarseT0, coarseT1, m_CoarsePipeline);
+
+      m_StatsFilter->SetInput(coarseDeltaNDVIImage);
+      m_StatsFilter->SetBlockAlignedStreaming(GetParameterInt("ram"));
+      AddProcess(m_StatsFilter->GetStreamer(),"Computing coarse dNDVI statistics");
+      m_StatsFilter->Update();
+
+      const double mean = m_StatsFilter->GetMeanOutput()->Get();
+      const double sigma = m_StatsFilter->GetSigmaOutput()->Get();
+      const double relaxedThreshold = mean - (sigmaMultiplier - GetParameterFloat("coarse.relax")) * sigma;
+      otbAppLogINFO("Coarse dNDVI mean: " << mean << " sigma: " << sigma);
+
+      m_CandidateBlocksFilter = CandidateBlocksFilterType::New();
+      m_CandidateBlocksFilter->SetInput(deltaNDVIImage);
+      m_CandidateBlocksFilter->SetBlockSize(GetParameterInt("coarse.blocksize"));
+      m_CandidateBlocksFilter->SetOutsideValue(noDataValue);
+      m_CandidateBlocksFilter->UpdateOutputInformation();
+      ComputeCandidateBlocks(coarseDeltaNDVIImage, relaxedThreshold, GetParameterInt("coarse.margin"));
+
+      // Thresholds of the full resolution pass
+      if (GetParameterInt("coarse.stats") == coarse_stats_full)
+        {
+        m_StatsFilter->SetInput(deltaNDVIImage);
+        m_StatsFilter->SetBlockAlignedStreaming(GetParameterInt("ram"));
+        AddProcess(m_StatsFilter->GetStreamer(),"Computing full resolution dNDVI statistics");
+        m_StatsFilter->Update();
+        }
+      else
+        {
+        otbAppLogWARNING("The thresholds are computed from the coarse dNDVI statistics: this is an "
+            "approximation of the full resolution ones, since the decimation smooths the dNDVI");
+        }
+      deltaNDVIImage = m_CandidateBlocksFilter->GetOutput();
+      }
+
+    // Pipelined streaming: the RAM is shared between the in-flight tiles.
+    // The cached dNDVI is mapped in memory: there is nothing to prefetch.
+    const unsigned int queueDepth = isCached ? 0 : GetParameterInt("prefetch");
+    const unsigned int streamingRAM = GetParameterInt("ram") / (queueDepth + 1);
+    if (queueDepth > 0)
+      {
+      otbAppLogINFO("Prefetching " << queueDepth << " dNDVI tile(s)");
+      m_PrefetchFilter = PrefetchFilterType::New();
+      m_PrefetchFilter->SetInput(deltaNDVIImage);
+      m_PrefetchFilter->SetQueueDepth(queueDepth);
+      deltaNDVIImage = m_PrefetchFilter->GetOutput();
+      }
+
+    if (jobMode != stats && !HasValue("outvec"))
+      {
+      otbAppLogFATAL("Output vector layer (outvec) is required");
+      }
+    deltaNDVIImage->UpdateOutputInformation();
+    FloatImageType::RegionType partRegion = deltaNDVIImage->GetLargestPossibleRegion();
+    if (jobMode != full)
+      {
+      partRegion = ComputePartRegion(deltaNDVIImage->GetLargestPossibleRegion());
+      }
+
+    RealObjectType * meanObject;
+    RealObjectType * sigmaObject;
+    if (!cacheDir.empty())
+      {
+      // Statistics of the cached dNDVI
+      meanObject = m_MeanObject;
+      sigmaObject = m_SigmaObject;
+      }
+    else if (coarseLevel > 0)
+      {
+      // Statistics of the full resolution dNDVI, or of the coarse one (coarse.stats)
+      meanObject = m_StatsFilter->GetMeanOutput();
+      sigmaObject = m_StatsFilter->GetSigmaOutput();
+      }
+    else if (jobMode == detect)
+      {
+      // Global statistics from the partial ones
+      DeltaNDVIStatistics statistics = MergePartialStatistics(deltaNDVIImage->GetLargestPossibleRegion());
+      m_MeanObject = RealObjectType::New();
+      m_MeanObject->Set(statistics.GetMean());
+      m_SigmaObject = RealObjectType::New();
+      m_SigmaObject->Set(statistics.GetSigma());
+      meanObject = m_MeanObject;
+      sigmaObject = m_SigmaObject;
+      }
+    else
+      {
+      // Wire stats filter
+      FloatImageType * statsInputImage = deltaNDVIImage;
+      if (jobMode == stats)
+        {
+        m_PartExtractFilter = PartExtractROIFilterType::New();
+        m_PartExtractFilter->SetInput(deltaNDVIImage);
+        m_PartExtractFilter->SetExtractionRegion(partRegion);
+        statsInputImage = m_PartExtractFilter->GetOutput();
+        }
+      m_StatsFilter->SetInput(statsInputImage);
+      m_StatsFilter->SetBlockAlignedStreaming(streamingRAM);
+      PrefetchSplits(m_StatsFilter->GetStreamer()->GetStreamingManager());
+
+      // Compute stats
+      AddProcess(m_StatsFilter->GetStreamer(),"Computing dNDVI statistics");
+      m_StatsFilter->Update();
+      meanObject = m_StatsFilter->GetMeanOutput();
+      sigmaObject = m_StatsFilter->GetSigmaOutput();
+
+      if (jobMode == stats)
+        {
+        DeltaNDVIStatistics statistics = m_StatsFilter->GetStatistics();
+        statistics.SetPartId(GetParameterInt("part.id"));
+        statistics.SetPartCount(GetParameterInt("part.count"));
+        statistics.Write(GetParameterString("mode.stats.out"));
+        otbAppLogINFO("Partial statistics written (" << statistics.GetCount() << " pixels)");
+        return;
+        }
+      }
+    otbAppLogINFO("dNDVI mean: " << meanObject->Get() << " sigma: " << sigmaObject->Get());
+
     // Label image
     m_NDVILabelFilter = NDVILabelImageFilterType::New();
     m_NDVILabelFilter->SetInput(deltaNDVIImage);
-    m_NDVILabelFilter->SetInputMeanObject(m_StatsFilter->GetMeanOutput());
-    m_NDVILabelFilter->SetInputSigmaObject(m_StatsFilter->GetSigmaOutput());
+    m_NDVILabelFilter->SetInputMeanObject(meanObject);
+    m_NDVILabelFilter->SetInputSigmaObject(sigmaObject);
     m_NDVILabelFilter->SetNumberOfClasses(2); // 2 classes
     m_NDVILabelFilter->SetFirstClassValue(0); // Label 0: no (... t enough) change, Label 1: clear cut
-    m_NDVILabelFilter->SetFirstClassStart(3); // Label 0 is [mu-3*std, +inf[, Label 1 is ]-inf, mu-3*std[,
-    m_NDVILabelFilter->SetInputNoDataValue(m_DeltaNDVIFilter->GetFunctor().GetNoDataValue());
+    m_NDVILabelFilter->SetFirstClassStart(sigmaMultiplier); // Label 0 is [mu-sigma*std, +inf[, Label 1 is ]-inf, mu-sigma*std[,
+    m_NDVILabelFilter->SetInputNoDataValue(noDataValue);
     m_NDVILabelFilter->SetOutputNoDataValue(0);
 
     // Clean label image
-    m_CleanFilter = ConnectedLabelsFilterType::New();
-    m_CleanFilter->SetInput(m_NDVILabelFilter->GetOutput());
-    m_CleanFilter->SetNoDataPixel(m_NDVILabelFilter->GetOutputNoDataValue());
-    m_CleanFilter->SetMinNumberOfComponents(GetParameterInt("filt"));
-    m_CleanFilter->UpdateOutputInformation();
+    const int connectivity = GetParameterInt("connectivity");
+    if (connectivity != 4 && connectivity != 8)
+      {
+      otbAppLogFATAL("Connectivity must be 4 or 8");
+      }
+    const bool fullyConnected = (connectivity == 8);
+    const int componentsMethod = GetParameterInt("cc");
+    const RunTableType * runTable = NULL;
+    const FloatImageType * runTableImage = NULL;
+    MaskImageType::IndexType runTableOrigin;
+    runTableOrigin.Fill(0);
+    MaskImageType * labelImage;
+    if (componentsMethod == table || componentsMethod == sparse)
+      {
+      // Components are computed over the rows of the part, plus the margin
+      // the connected components filter would use
+      MaskImageType * componentsInputImage = m_NDVILabelFilter->GetOutput();
+      FloatImageType * componentsValueImage = deltaNDVIImage;
+      MaskImageType::IndexType componentsOrigin;
+      componentsOrigin.Fill(0);
+      FloatImageType::RegionType componentsRegion(partRegion);
+      bool cutFirstRow = false;
+      bool cutLastRow = false;
+      if (jobMode == detect)
+        {
+        const FloatImageType::RegionType largestRegion = deltaNDVIImage->GetLargestPossibleRegion();
+        componentsRegion.PadByRadius(GetParameterInt("filt"));
+        componentsRegion.Crop(largestRegion);
+        cutFirstRow = componentsRegion.GetIndex(1) > largestRegion.GetIndex(1);
+        cutLastRow = componentsRegion.GetUpperIndex()[1] < largestRegion.GetUpperIndex()[1];
+        m_ComponentsValueExtractFilter = PartExtractROIFilterType::New();
+        m_ComponentsValueExtractFilter->SetInput(componentsValueImage);
+        m_ComponentsValueExtractFilter->SetExtractionRegion(componentsRegion);
+        componentsValueImage = m_ComponentsValueExtractFilter->GetOutput();
+        if (componentsMethod == table)
+          {
+          m_ComponentsExtractFilter = LabelExtractROIFilterType::New();
+          m_ComponentsExtractFilter->SetInput(componentsInputImage);
+          m_ComponentsExtractFilter->SetExtractionRegion(componentsRegion);
+          componentsInputImage = m_ComponentsExtractFilter->GetOutput();
+          }
+
+        // The extracted image starts at index 0
+        componentsOrigin = componentsRegion.GetIndex();
+        runTableOrigin = componentsOrigin;
+        partRegion.SetIndex(1, partRegion.GetIndex(1) - componentsRegion.GetIndex(1));
+        }
+
+      if (componentsMethod == sparse)
+        {
+        // Runs of candidates, straight from the dNDVI
+        m_RunsFilter = RunsFilterType::New();
+        m_RunsFilter->SetInput(componentsValueImage);
+        m_RunsFilter->SetInputMeanObject(meanObject);
+        m_RunsFilter->SetInputSigmaObject(sigmaObject);
+        m_RunsFilter->SetFirstClassStart(sigmaMultiplier);
+        m_RunsFilter->SetInputNoDataValue(noDataValue);
+        m_RunsFilter->SetRunValue(1);
+        m_RunsFilter->SetFullyConnected(fullyConnected);
+        m_RunsFilter->GetStreamer()->SetAutomaticAdaptativeStreaming(streamingRAM);
+        PrefetchSplits(m_RunsFilter->GetStreamer()->GetStreamingManager());
+        AddProcess(m_RunsFilter->GetStreamer(), "Computing candidate runs");
+        m_RunsFilter->Update();
+        runTable = &m_RunsFilter->GetRunTable();
+        runTableImage = componentsValueImage;
+        otbAppLogINFO("Candidate runs: " << runTable->GetNumberOfRuns()
+            << ", connected components: " << runTable->GetNumberOfComponents());
+        }
+      else
+        {
+        m_ComponentsFilter = ComponentsFilterType::New();
+        m_ComponentsFilter->SetInput(componentsInputImage);
+        m_ComponentsFilter->SetValueImage(componentsValueImage);
+        m_ComponentsFilter->SetNoDataPixel(m_NDVILabelFilter->GetOutputNoDataValue());
+        m_ComponentsFilter->SetFullyConnected(fullyConnected);
+        m_ComponentsFilter->GetStreamer()->SetAutomaticAdaptativeStreaming(streamingRAM);
+        PrefetchSplits(m_ComponentsFilter->GetStreamer()->GetStreamingManager());
+        AddProcess(m_ComponentsFilter->GetStreamer(), "Computing connected components");
+        m_ComponentsFilter->Update();
+        runTable = &m_ComponentsFilter->GetRunTable();
+        runTableImage = componentsValueImage;
+        otbAppLogINFO("Connected components: " << runTable->GetNumberOfComponents());
+
+        if (HasValue("cc.table.outattr"))
+          {
+          WriteComponentsAttributes(*runTable, componentsOrigin, partRegion, componentsRegion,
+              cutFirstRow, cutLastRow, GetParameterString("cc.table.outattr"));
+          }
+        if (HasValue("cc.table.outids"))
+          {
+          m_ComponentIdsImageSource = ComponentIdsImageSourceType::New();
+          m_ComponentIdsImageSource->SetRunTable(runTable);
+          m_ComponentIdsImageSource->SetReferenceImage(componentsInputImage);
+          m_ComponentIdsImageSource->SetNoDataPixel(0);
+          m_ComponentIdsImageSource->SetMinNumberOfComponents(0);
+          m_ComponentIdsImageSource->SetOutputComponentIds(true);
+          m_ComponentIdsWriter = ComponentIdsWriterType::New();
+          m_ComponentIdsWriter->SetInput(m_ComponentIdsImageSource->GetOutput());
+          m_ComponentIdsWriter->SetFileName(GetParameterString("cc.table.outids"));
+          m_ComponentIdsWriter->SetAvailableRAM(streamingRAM);
+          AddProcess(m_ComponentIdsWriter, "Writing component IDs image");
+          m_ComponentIdsWriter->Update();
+          }
+        }
+
+      // Only computed when the label image is written, or vectorized
+      m_ComponentsImageSource = ComponentsImageSourceType::New();
+      m_ComponentsImageSource->SetRunTable(runTable);
+      m_ComponentsImageSource->SetReferenceImage(runTableImage);
+      m_ComponentsImageSource->SetNoDataPixel(m_NDVILabelFilter->GetOutputNoDataValue());
+      m_ComponentsImageSource->SetMinNumberOfComponents(GetParameterInt("filt"));
+      m_ComponentsImageSource->UpdateOutputInformation();
+      labelImage = m_ComponentsImageSource->GetOutput();
+      }
+    else
+      {
+      m_CleanFilter = ConnectedLabelsFilterType::New();
+      m_CleanFilter->SetInput(m_NDVILabelFilter->GetOutput());
+      m_CleanFilter->SetNoDataPixel(m_NDVILabelFilter->GetOutputNoDataValue());
+      m_CleanFilter->SetMinNumberOfComponents(GetParameterInt("filt"));
+      m_CleanFilter->SetFullyConnected(fullyConnected);
+      m_CleanFilter->UpdateOutputInformation();
+      labelImage = m_CleanFilter->GetOutput();
+      }
+
+    // Restrict to the rows of the part: the connected components
+    // still use their neighborhood beyond them
+    if (jobMode == detect)
+      {
+      m_LabelExtractFilter = LabelExtractROIFilterType::New();
+      m_LabelExtractFilter->SetInput(labelImage);
+      m_LabelExtractFilter->SetExtractionRegion(partRegion);
+      labelImage = m_LabelExtractFilter->GetOutput();
+      }
+
+    // Label image, in the label pixel type. The sparse pipeline has no label
+    // image pass: the label image is computed from the runs for this file only.
+    if (HasValue("outlabels") && componentsMethod == sparse)
+      {
+      m_LabelWriter = LabelWriterType::New();
+      m_LabelWriter->SetInput(labelImage);
+      m_LabelWriter->SetFileName(GetParameterString("outlabels"));
+      m_LabelWriter->SetAvailableRAM(streamingRAM);
+      AddProcess(m_LabelWriter, "Writing label image");
+      m_LabelWriter->Update();
+      }
 
     // Vectorize higher class
-    m_VectorizeFilter = VectorizationFilterType::New();
-    m_VectorizeFilter->SetInput(m_CleanFilter->GetOutput());
-    m_VectorizeFilter->SetAutomaticAdaptativeStreaming(GetParameterInt("ram"));
-    AddProcess(m_VectorizeFilter, "Computing layer");
-    SetParameterOutputVectorData("outvec", m_VectorizeFilter->GetOutput());
+    if (componentsMethod == sparse)
+      {
+      // Polygons traced from the runs, in the rows of the part. Their
+      // vertices are computed in the geometry of the whole overlap, as in
+      // mode.full (not from the origin of the extracted part).
+      m_PolygonsFilter = PolygonsFilterType::New();
+      m_PolygonsFilter->SetRunTable(runTable);
+      m_PolygonsFilter->SetReferenceImage(deltaNDVIImage);
+      m_PolygonsFilter->SetIndexOffset(runTableOrigin);
+      m_PolygonsFilter->SetMinNumberOfComponents(GetParameterInt("filt"));
+      m_PolygonsFilter->SetRegion(partRegion);
+      AddProcess(m_PolygonsFilter, "Computing layer");
+      SetParameterOutputVectorData("outvec", m_PolygonsFilter->GetOutput());
+      }
+    else
+      {
+      // Label image, written by the vectorization pass
+      MaskImageType * vectorizeInputImage = labelImage;
+      if (HasValue("outlabels"))
+        {
+        m_LabelTeeFilter = LabelTeeFilterType::New();
+        m_LabelTeeFilter->SetInput(labelImage);
+        m_LabelTeeFilter->SetFileName(GetParameterString("outlabels"));
+        vectorizeInputImage = m_LabelTeeFilter->GetOutput();
+        }
+
+      m_VectorizeFilter = VectorizationFilterType::New();
+      m_VectorizeFilter->SetInput(vectorizeInputImage);
+      m_VectorizeFilter->SetAutomaticAdaptativeStreaming(streamingRAM);
+
+      // The vectorization streams the label image with the same splits
+      // (it is updated when the output is written, after DoExecute)
+      if (m_PrefetchFilter.IsNotNull() && componentsMethod == halo)
+        {
+        labelImage->UpdateOutputInformation();
+        m_VectorizeStreamingManager = LabelStreamingManagerType::New();
+        m_VectorizeStreamingManager->SetAvailableRAMInMB(streamingRAM);
+        m_VectorizeStreamingManager->PrepareStreaming(labelImage, labelImage->GetLargestPossibleRegion());
+        PrefetchSplits(m_VectorizeStreamingManager.GetPointer());
+        }
+      AddProcess(m_VectorizeFilter, "Computing layer");
+      SetParameterOutputVectorData("outvec", m_VectorizeFilter->GetOutput());
+      }
+  }
+
+  void AfterExecuteAndWriteOutputs()
+  {
+    // The label image has been written by the vectorization
+    if (m_LabelTeeFilter.IsNotNull())
+      {
+      m_LabelTeeFilter->Close();
+      otbAppLogINFO("Label image written in " << GetParameterString("outlabels"));
+      }
   }
 
-  ResampleImageFilterType::Pointer      m_ResampleFilter;
-  ExtractROIFilterType::Pointer         m_ExtractROIFilter;
-  DeltaNDVIFilterType::Pointer          m_DeltaNDVIFilter;
-  MaskImageFilterType::Pointer          m_MaskImageFilter;
+  DeltaNDVIPipeline                     m_Pipeline;
+  DeltaNDVIPipeline                     m_CoarsePipeline;
   NDVILabelImageFilterType::Pointer     m_NDVILabelFilter;
   StatsFilterType::Pointer              m_StatsFilter;
-  MaskHandlerType::Pointer              m_MaskHandler;
   ConnectedLabelsFilterType::Pointer    m_CleanFilter;
+  ComponentsFilterType::Pointer         m_ComponentsFilter;
+  ComponentsImageSourceType::Pointer    m_ComponentsImageSource;
+  LabelExtractROIFilterType::Pointer    m_ComponentsExtractFilter;
+  PartExtractROIFilterType::Pointer     m_ComponentsValueExtractFilter;
+  ComponentIdsImageSourceType::Pointer  m_ComponentIdsImageSource;
+  ComponentIdsWriterType::Pointer       m_ComponentIdsWriter;
+  LabelWriterType::Pointer              m_LabelWriter;
+  LabelTeeFilterType::Pointer           m_LabelTeeFilter;
   VectorizationFilterType::Pointer      m_VectorizeFilter;
+  RunsFilterType::Pointer               m_RunsFilter;
+  PolygonsFilterType::Pointer           m_PolygonsFilter;
+  PrefetchFilterType::Pointer           m_PrefetchFilter;
+  LabelStreamingManagerType::Pointer    m_VectorizeStreamingManager;
+  PartExtractROIFilterType::Pointer     m_PartExtractFilter;
+  LabelExtractROIFilterType::Pointer    m_LabelExtractFilter;
+  RealObjectType::Pointer               m_MeanObject;
+  RealObjectType::Pointer               m_SigmaObject;
+  ReaderType::Pointer                   m_CoarseReaderT0;
+  ReaderType::Pointer                   m_CoarseReaderT1;
+  CandidateBlocksFilterType::Pointer    m_CandidateBlocksFilter;
+  CoarseCandidatesFilterType::Pointer   m_CoarseCandidatesFilter;
+  QualityBand                           m_QualityT0;
+  QualityBand                           m_QualityT1;
+  VectorMask                            m_MaskT0;
+  VectorMask                            m_MaskT1;
+  VectorMask                            m_CoarseMaskT0;
+  VectorMask                            m_CoarseMaskT1;
+  DeltaNDVIWriterType::Pointer          m_DeltaNDVIWriter;
+  DeltaNDVISourceType::Pointer          m_DeltaNDVISource;
 };
 }
 }
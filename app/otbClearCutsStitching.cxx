@@ -0,0 +1,486 @@
+/*=========================================================================
+
+  Copyright (c) Remi Cresson (IRSTEA). All rights reserved.
+
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#include "itkObjectFactory.h"
+
+// Application engine
+#include "otbWrapperApplicationFactory.h"
+
+// OGR
+#include "otbOGRDataSourceWrapper.h"
+#include "otbOGRFeatureWrapper.h"
+#include "ogr_geometry.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace otb
+{
+
+namespace Wrapper
+{
+
+class ClearCutsStitching : public Application
+{
+public:
+  /** Standard class typedefs. */
+  typedef ClearCutsStitching            Self;
+  typedef Application                   Superclass;
+  typedef itk::SmartPointer<Self>       Pointer;
+  typedef itk::SmartPointer<const Self> ConstPointer;
+
+  /** Standard macro */
+  itkNewMacro(Self);
+  itkTypeMacro(ClearCutsStitching, Application);
+
+private:
+
+  /*
+   * A polygon of a partial layer
+   */
+  struct PartFeature
+  {
+    unsigned int      part;
+    ogr::Feature      feature;
+    OGREnvelope       envelope;
+  };
+
+  /*
+   * Orders polygons by the xmin of their envelope
+   */
+  struct EnvelopeMinXComparator
+  {
+    EnvelopeMinXComparator(const std::vector<PartFeature> & features) : m_Features(features) {}
+    bool operator()(unsigned int i, unsigned int j) const
+    {
+      return m_Features[i].envelope.MinX < m_Features[j].envelope.MinX;
+    }
+    const std::vector<PartFeature> & m_Features;
+  };
+
+  /*
+   * Raster order of the pixel corners, as the run tracer sorts them: by
+   * row, then by column. The directions of the rows and of the columns are
+   * read on the exterior ring of a traced polygon, which starts at the top
+   * left corner of its first pixel, goes along the row first, and comes
+   * back from the next row.
+   */
+  class CornerOrder
+  {
+  public:
+    CornerOrder() : m_ColumnSign(1.0), m_RowSign(-1.0) {}
+
+    void SetFromRing(const OGRLinearRing * ring)
+    {
+      if (ring->getNumPoints() < 4)
+        return;
+      m_ColumnSign = (ring->getX(1) > ring->getX(0)) ? 1.0 : -1.0;
+      m_RowSign = (ring->getY(ring->getNumPoints() - 2) > ring->getY(0)) ? 1.0 : -1.0;
+    }
+
+    bool operator()(const OGRRawPoint & a, const OGRRawPoint & b) const
+    {
+      if (a.y != b.y)
+        return a.y * m_RowSign < b.y * m_RowSign;
+      return a.x * m_ColumnSign < b.x * m_ColumnSign;
+    }
+
+  private:
+    double m_ColumnSign;
+    double m_RowSign;
+  };
+
+  /*
+   * Orders rings by their first vertex
+   */
+  struct RingOrder
+  {
+    RingOrder(const CornerOrder & order) : m_Order(order) {}
+    bool operator()(const std::vector<OGRRawPoint> & a, const std::vector<OGRRawPoint> & b) const
+    {
+      return m_Order(a.front(), b.front());
+    }
+    const CornerOrder & m_Order;
+  };
+
+  /*
+   * Orders the output polygons by the first vertex of their exterior ring,
+   * i.e. in raster order of their first pixel
+   */
+  struct FirstPixelOrder
+  {
+    FirstPixelOrder(const std::vector<OGRRawPoint> & firstVertices, const CornerOrder & order) :
+      m_FirstVertices(firstVertices), m_Order(order) {}
+    bool operator()(unsigned int i, unsigned int j) const
+    {
+      return m_Order(m_FirstVertices[i], m_FirstVertices[j]);
+    }
+    const std::vector<OGRRawPoint> & m_FirstVertices;
+    const CornerOrder & m_Order;
+  };
+
+  /*
+   * Vertices of a ring where the direction changes (the edges are along the
+   * rows and the columns), with the given orientation, starting at the first
+   * corner in raster order
+   */
+  std::vector<OGRRawPoint> GetRingCorners(const OGRLinearRing * ring, bool clockwise, const CornerOrder & order)
+  {
+    std::vector<OGRRawPoint> points;
+    for (int i = 0 ; i < ring->getNumPoints() ; i++)
+      {
+      OGRRawPoint point(ring->getX(i), ring->getY(i));
+      if (points.empty() || points.back().x != point.x || points.back().y != point.y)
+        points.push_back(point);
+      }
+    while (points.size() > 1 && points.back().x == points.front().x && points.back().y == points.front().y)
+      points.pop_back();
+
+    std::vector<OGRRawPoint> corners;
+    const size_t nbOfPoints = points.size();
+    for (size_t i = 0 ; i < nbOfPoints ; i++)
+      {
+      const OGRRawPoint & previous = points[(i + nbOfPoints - 1) % nbOfPoints];
+      const OGRRawPoint & next = points[(i + 1) % nbOfPoints];
+      const bool collinear = (previous.x == points[i].x && points[i].x == next.x)
+          || (previous.y == points[i].y && points[i].y == next.y);
+      if (!collinear)
+        corners.push_back(points[i]);
+      }
+    if (corners.empty())
+      return corners;
+
+    double area = 0.0;
+    for (size_t i = 0 ; i < corners.size() ; i++)
+      {
+      const OGRRawPoint & a = corners[i];
+      const OGRRawPoint & b = corners[(i + 1) % corners.size()];
+      area += a.x * b.y - b.x * a.y;
+      }
+    if ((area < 0.0) != clockwise)
+      std::reverse(corners.begin(), corners.end());
+
+    std::rotate(corners.begin(), std::min_element(corners.begin(), corners.end(), order), corners.end());
+    return corners;
+  }
+
+  OGRLinearRing * CreateRing(const std::vector<OGRRawPoint> & corners)
+  {
+    OGRLinearRing * ring = new OGRLinearRing;
+    for (size_t i = 0 ; i < corners.size() ; i++)
+      ring->addPoint(corners[i].x, corners[i].y);
+    ring->closeRings();
+    return ring;
+  }
+
+  /*
+   * Rings of a merged polygon, built as the run tracer builds them: corner
+   * vertices only, exterior ring in the orientation of the traced ones and
+   * holes in the other one, each ring starting at its first corner in
+   * raster order, and holes sorted by this corner. Geometries which are
+   * not polygons are returned unchanged.
+   */
+  OGRGeometry * NormalizePolygon(OGRGeometry * geometry, bool clockwise, const CornerOrder & order)
+  {
+    if (wkbFlatten(geometry->getGeometryType()) != wkbPolygon)
+      return geometry;
+
+    OGRPolygon * polygon = static_cast<OGRPolygon *>(geometry);
+    std::vector<OGRRawPoint> exterior = GetRingCorners(polygon->getExteriorRing(), clockwise, order);
+    std::vector<std::vector<OGRRawPoint> > holes;
+    for (int i = 0 ; i < polygon->getNumInteriorRings() ; i++)
+      holes.push_back(GetRingCorners(polygon->getInteriorRing(i), !clockwise, order));
+    std::sort(holes.begin(), holes.end(), RingOrder(order));
+
+    OGRPolygon * normalized = new OGRPolygon;
+    normalized->addRingDirectly(CreateRing(exterior));
+    for (size_t i = 0 ; i < holes.size() ; i++)
+      normalized->addRingDirectly(CreateRing(holes[i]));
+    OGRGeometryFactory::destroyGeometry(geometry);
+    return normalized;
+  }
+
+  /*
+   * First vertex of the exterior ring of a polygon
+   */
+  OGRRawPoint GetFirstVertex(const OGRGeometry * geometry)
+  {
+    OGRRawPoint vertex;
+    if (wkbFlatten(geometry->getGeometryType()) == wkbPolygon)
+      {
+      const OGRLinearRing * ring = static_cast<const OGRPolygon *>(geometry)->getExteriorRing();
+      if (ring != NULL && ring->getNumPoints() > 0)
+        vertex = OGRRawPoint(ring->getX(0), ring->getY(0));
+      }
+    return vertex;
+  }
+
+  /*
+   * Union-find root, with path compression
+   */
+  unsigned int FindRoot(std::vector<unsigned int> & parents, unsigned int i)
+  {
+    while (parents[i] != i)
+      {
+      parents[i] = parents[parents[i]];
+      i = parents[i];
+      }
+    return i;
+  }
+
+  /*
+   * Two polygons of adjacent parts must be merged if they share an edge
+   * (a single common vertex is a diagonal connection, which is not one)
+   */
+  bool ShareAnEdge(const PartFeature & a, const PartFeature & b)
+  {
+    if (!a.envelope.Intersects(b.envelope))
+      return false;
+
+    OGRGeometry * intersection = a.feature.GetGeometry()->Intersection(b.feature.GetGeometry());
+    if (intersection == NULL)
+      return false;
+
+    const bool shareEdge = !intersection->IsEmpty() && intersection->getDimension() >= 1;
+    OGRGeometryFactory::destroyGeometry(intersection);
+    return shareEdge;
+  }
+
+  /*
+   * Polygons of a part which intersect the extent of another part, sorted by
+   * increasing xmin
+   */
+  std::vector<unsigned int> GetBoundaryFeatures(const std::vector<PartFeature> & features,
+      const std::vector<unsigned int> & partStart, unsigned int part, unsigned int otherPart)
+  {
+    std::vector<unsigned int> boundaryFeatures;
+    if (partStart[otherPart] == partStart[otherPart+1])
+      return boundaryFeatures;
+
+    OGREnvelope otherExtent;
+    for (unsigned int j = partStart[otherPart] ; j < partStart[otherPart+1] ; j++)
+      otherExtent.Merge(features[j].envelope);
+
+    for (unsigned int i = partStart[part] ; i < partStart[part+1] ; i++)
+      {
+      if (features[i].envelope.Intersects(otherExtent))
+        boundaryFeatures.push_back(i);
+      }
+
+    std::sort(boundaryFeatures.begin(), boundaryFeatures.end(), EnvelopeMinXComparator(features));
+    return boundaryFeatures;
+  }
+
+  void DoInit()
+  {
+
+    SetName("ClearCutsStitching");
+    SetDescription("Stitch the partial vector layers of a distributed clear cuts detection");
+
+    // Documentation
+    SetDocName("ClearCutsStitching");
+    SetDocLongDescription("This application merges the partial vector layers produced by "
+        "ClearCutsDetection in distributed mode (mode.detect), one for each part of the job. "
+        "Polygons of adjacent parts which share an edge along the parts boundary are merged. "
+        "The merged polygons keep their corner vertices only, and their rings start at their "
+        "first corner in raster order, as the polygons traced from the runs (cc.sparse). The "
+        "polygons are written in raster order of their first pixel. "
+        "Layers must be given in the order of the parts ids.");
+    SetDocLimitations("The stitched layer is identical to the layer of a single-process run "
+        "with cc.sparse only. With the other connected components methods, the polygons are "
+        "built by GDALPolygonize, whose rings start on other vertices: the polygons cover the "
+        "same pixels, but their vertices can be listed in another order.");
+    SetDocAuthors("Remi Cresson");
+    SetDocSeeAlso("ClearCutsDetection");
+
+    AddDocTag(Tags::ChangeDetection);
+    AddDocTag(Tags::Vector);
+
+    // Input vectors
+    AddParameter(ParameterType_InputFilenameList, "il", "Input partial vector layers");
+    SetParameterDescription("il", "Partial vector layers, sorted by part id");
+
+    // Output vector
+    AddParameter(ParameterType_OutputFilename, "out", "Output vector layer");
+    SetParameterDescription("out", "Stitched vector layer");
+
+  }
+
+  void DoUpdateParameters()
+  {
+    // Nothing to do here : all parameters are independent
+  }
+
+  void DoExecute()
+  {
+
+    std::vector<std::string> inputFilenames = GetParameterStringList("il");
+    if (inputFilenames.size() == 0)
+      {
+      otbAppLogFATAL("No input vector layer");
+      }
+
+    // Read all partial layers
+    std::vector<ogr::DataSource::Pointer> inputSources;
+    std::vector<PartFeature> features;
+    std::vector<unsigned int> partStart;
+    for (unsigned int part = 0 ; part < inputFilenames.size() ; part++)
+      {
+      ogr::DataSource::Pointer source = ogr::DataSource::New(inputFilenames[part], ogr::DataSource::Modes::Read);
+      inputSources.push_back(source);
+      partStart.push_back(features.size());
+
+      ogr::Layer layer = source->GetLayer(0);
+      for (ogr::Layer::const_iterator it = layer.cbegin() ; it != layer.cend() ; ++it)
+        {
+        if (it->GetGeometry() == NULL)
+          continue;
+
+        PartFeature partFeature = {part, it->Clone(), OGREnvelope()};
+        partFeature.feature.GetGeometry()->getEnvelope(&partFeature.envelope);
+        features.push_back(partFeature);
+        }
+      otbAppLogINFO("Part " << part << ": " << (features.size() - partStart.back()) << " polygons");
+      }
+    partStart.push_back(features.size());
+
+    // Link the polygons which share an edge across the boundary of adjacent parts
+    std::vector<unsigned int> parents(features.size());
+    for (unsigned int i = 0 ; i < features.size() ; i++)
+      parents[i] = i;
+
+    unsigned int nbOfLinks = 0;
+    for (unsigned int part = 0 ; part + 1 < inputFilenames.size() ; part++)
+      {
+      // Parts are disjoint bands of rows: the polygons of a part which reach
+      // the extent of the next part are the ones touching their shared
+      // boundary row. Only them are compared, sorted by their x-extent.
+      const unsigned int nextPart = part + 1;
+      std::vector<unsigned int> boundaryFeatures = GetBoundaryFeatures(features, partStart, part, nextPart);
+      std::vector<unsigned int> nextBoundaryFeatures = GetBoundaryFeatures(features, partStart, nextPart, part);
+
+      unsigned int first = 0;
+      for (unsigned int k = 0 ; k < boundaryFeatures.size() ; k++)
+        {
+        const unsigned int i = boundaryFeatures[k];
+
+        // Skip the polygons of the next part which end before this one
+        while (first < nextBoundaryFeatures.size() &&
+            features[nextBoundaryFeatures[first]].envelope.MaxX < features[i].envelope.MinX)
+          first++;
+
+        for (unsigned int l = first ; l < nextBoundaryFeatures.size() ; l++)
+          {
+          const unsigned int j = nextBoundaryFeatures[l];
+          if (features[j].envelope.MinX > features[i].envelope.MaxX)
+            break;
+          if (features[j].envelope.MaxX < features[i].envelope.MinX)
+            continue;
+
+          if (ShareAnEdge(features[i], features[j]))
+            {
+            unsigned int rootI = FindRoot(parents, i);
+            unsigned int rootJ = FindRoot(parents, j);
+            if (rootI != rootJ)
+              {
+              // The root is always the first polygon of the group
+              parents[std::max(rootI, rootJ)] = std::min(rootI, rootJ);
+              nbOfLinks++;
+              }
+            }
+          }
+        }
+      }
+    otbAppLogINFO("Stitching " << nbOfLinks << " polygons across parts boundaries");
+
+    // Orientation and corners order of the traced polygons
+    CornerOrder order;
+    bool clockwise = true;
+    for (unsigned int i = 0 ; i < features.size() ; i++)
+      {
+      OGRGeometry * geometry = features[i].feature.GetGeometry();
+      if (wkbFlatten(geometry->getGeometryType()) == wkbPolygon)
+        {
+        const OGRLinearRing * ring = static_cast<OGRPolygon *>(geometry)->getExteriorRing();
+        order.SetFromRing(ring);
+        clockwise = ring->isClockwise();
+        break;
+        }
+      }
+
+    // Union of the groups, in the order of the polygons
+    std::vector<OGRGeometry*> geometries(features.size(), static_cast<OGRGeometry*>(NULL));
+    std::vector<bool> merged(features.size(), false);
+    for (unsigned int i = 0 ; i < features.size() ; i++)
+      {
+      const unsigned int root = FindRoot(parents, i);
+      if (geometries[root] == NULL)
+        {
+        geometries[root] = features[i].feature.GetGeometry()->clone();
+        }
+      else
+        {
+        OGRGeometry * unionGeometry = geometries[root]->Union(features[i].feature.GetGeometry());
+        OGRGeometryFactory::destroyGeometry(geometries[root]);
+        geometries[root] = unionGeometry;
+        merged[root] = true;
+        }
+      }
+
+    // Merged polygons are rebuilt as the single-process run traces them,
+    // and all the polygons are sorted in raster order of their first pixel
+    std::vector<unsigned int> outputFeatures;
+    std::vector<OGRRawPoint> firstVertices(features.size());
+    for (unsigned int i = 0 ; i < features.size() ; i++)
+      {
+      if (geometries[i] == NULL)
+        continue;
+      if (merged[i])
+        geometries[i] = NormalizePolygon(geometries[i], clockwise, order);
+      firstVertices[i] = GetFirstVertex(geometries[i]);
+      outputFeatures.push_back(i);
+      }
+    std::stable_sort(outputFeatures.begin(), outputFeatures.end(), FirstPixelOrder(firstVertices, order));
+
+    // Create the output layer, with the fields of the first partial layer
+    ogr::Layer firstLayer = inputSources[0]->GetLayer(0);
+    ogr::DataSource::Pointer outputSource = ogr::DataSource::New(GetParameterString("out"),
+        ogr::DataSource::Modes::Overwrite);
+    ogr::Layer outputLayer = outputSource->CreateLayer(firstLayer.GetName(),
+        const_cast<OGRSpatialReference*>(firstLayer.GetSpatialRef()), firstLayer.GetGeomType());
+    OGRFeatureDefn & layerDefn = firstLayer.GetLayerDefn();
+    for (int k = 0 ; k < layerDefn.GetFieldCount() ; k++)
+      {
+      outputLayer.CreateField(*layerDefn.GetFieldDefn(k));
+      }
+
+    // Write the polygons
+    unsigned int nbOfPolygons = 0;
+    for (unsigned int k = 0 ; k < outputFeatures.size() ; k++)
+      {
+      const unsigned int i = outputFeatures[k];
+      ogr::Feature outputFeature(outputLayer.GetLayerDefn());
+      outputFeature.SetFrom(features[i].feature);
+      outputFeature.SetGeometry(geometries[i]);
+      outputLayer.CreateFeature(outputFeature);
+      OGRGeometryFactory::destroyGeometry(geometries[i]);
+      nbOfPolygons++;
+      }
+    outputSource->SyncToDisk();
+
+    otbAppLogINFO("Number of output polygons: " << nbOfPolygons);
+
+  }
+
+};
+}
+}
+
+OTB_APPLICATION_EXPORT( otb::Wrapper::ClearCutsStitching )
@@ -0,0 +1,76 @@
+/*=========================================================================
+
+  Copyright (c) Remi Cresson (IRSTEA). All rights reserved.
+
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef BlockAlignedStrippedStreamingManager_H_
+#define BlockAlignedStrippedStreamingManager_H_
+
+#include "otbRAMDrivenStrippedStreamingManager.h"
+
+namespace otb
+{
+
+/**
+ * \class BlockAlignedStrippedStreamingManager
+ * \brief RAM driven strips made of whole rows of blocks
+ *
+ * The number of rows of the strips estimated from the available RAM is
+ * rounded down to a multiple of the block size (one row of blocks at
+ * least). Strips start at the first row of the streamed region, so a
+ * filter whose blocks grid is anchored on the same region does not need
+ * to request more than the strip: the RAM estimate holds.
+ *
+ * \ingroup ClearCutsDetection
+ */
+template <class TImage>
+class ITK_EXPORT BlockAlignedStrippedStreamingManager : public RAMDrivenStrippedStreamingManager<TImage>
+{
+public:
+  /** Standard class typedefs. */
+  typedef BlockAlignedStrippedStreamingManager      Self;
+  typedef RAMDrivenStrippedStreamingManager<TImage> Superclass;
+  typedef itk::SmartPointer<Self>                   Pointer;
+  typedef itk::SmartPointer<const Self>             ConstPointer;
+
+  typedef TImage                          ImageType;
+  typedef typename Superclass::RegionType RegionType;
+
+  /** Creation through object factory macro */
+  itkNewMacro(Self);
+
+  /** Type macro */
+  itkTypeMacro(BlockAlignedStrippedStreamingManager, RAMDrivenStrippedStreamingManager);
+
+  /** Number of rows of the blocks */
+  itkSetMacro(BlockSize, unsigned int);
+  itkGetMacro(BlockSize, unsigned int);
+
+  /** Actually computes the stream divisions */
+  virtual void PrepareStreaming(itk::DataObject * input, const RegionType &region);
+
+  /** Get a region definition that represents the ith piece a specified region. */
+  virtual RegionType GetSplit(unsigned int i);
+
+protected:
+  BlockAlignedStrippedStreamingManager();
+  virtual ~BlockAlignedStrippedStreamingManager() {}
+
+private:
+  BlockAlignedStrippedStreamingManager(const BlockAlignedStrippedStreamingManager &); //purposely not implemented
+  void operator =(const BlockAlignedStrippedStreamingManager&); //purposely not implemented
+
+  unsigned int m_BlockSize;
+  unsigned int m_RowsPerSplit;
+};
+
+} // End namespace otb
+
+#include "otbBlockAlignedStrippedStreamingManager.hxx"
+
+#endif /* BlockAlignedStrippedStreamingManager_H_ */
@@ -0,0 +1,63 @@
+/*=========================================================================
+
+  Copyright (c) Remi Cresson (IRSTEA). All rights reserved.
+
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef __BlockAlignedStrippedStreamingManager_hxx
+#define __BlockAlignedStrippedStreamingManager_hxx
+
+#include "otbBlockAlignedStrippedStreamingManager.h"
+
+#include <algorithm>
+
+namespace otb
+{
+
+template <class TImage>
+BlockAlignedStrippedStreamingManager<TImage>
+::BlockAlignedStrippedStreamingManager()
+ {
+  m_BlockSize = 256;
+  m_RowsPerSplit = 0;
+ }
+
+/*
+ * Strips of the RAM driven manager, rounded down to whole rows of blocks
+ */
+template <class TImage>
+void
+BlockAlignedStrippedStreamingManager<TImage>
+::PrepareStreaming(itk::DataObject * input, const RegionType &region)
+ {
+  Superclass::PrepareStreaming(input, region);
+
+  const unsigned long nbOfRows = region.GetSize(1);
+  const unsigned long nbOfSplits = std::max(this->m_ComputedNumberOfSplits, 1U);
+  unsigned long rowsPerSplit = (nbOfRows + nbOfSplits - 1) / nbOfSplits;
+  rowsPerSplit = std::max(rowsPerSplit / m_BlockSize, 1UL) * m_BlockSize;
+
+  m_RowsPerSplit = rowsPerSplit;
+  this->m_ComputedNumberOfSplits = (nbOfRows + rowsPerSplit - 1) / rowsPerSplit;
+  this->m_Region = region;
+ }
+
+template <class TImage>
+typename BlockAlignedStrippedStreamingManager<TImage>::RegionType
+BlockAlignedStrippedStreamingManager<TImage>
+::GetSplit(unsigned int i)
+ {
+  RegionType split(this->m_Region);
+  split.SetIndex(1, this->m_Region.GetIndex(1) + static_cast<long>(i) * m_RowsPerSplit);
+  split.SetSize(1, m_RowsPerSplit);
+  split.Crop(this->m_Region);
+  return split;
+ }
+
+} // End namespace otb
+
+#endif
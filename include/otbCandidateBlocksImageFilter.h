@@ -0,0 +1,115 @@
+/*=========================================================================
+
+  Copyright (c) Remi Cresson (IRSTEA). All rights reserved.
+
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef CandidateBlocksImageFilter_H_
+#define CandidateBlocksImageFilter_H_
+
+#include "itkImageToImageFilter.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionIterator.h"
+
+#include <vector>
+
+namespace otb
+{
+
+/**
+ * \class CandidateBlocksImageFilter
+ * \brief Restrict the processing of an image to a set of candidate blocks
+ *
+ * The image is divided in square blocks of m_BlockSize pixels. Pixels of
+ * candidate blocks are copied from the input, other pixels are set to
+ * m_OutsideValue. Only the bounding box of the candidate blocks of the
+ * requested region is requested to the input, hence the upstream pipeline
+ * is not computed (nor read) over the non-candidate blocks.
+ *
+ * Candidate blocks are typically the ones where a coarse resolution
+ * processing has found something.
+ *
+ * \ingroup ClearCutsDetection
+ */
+template <class TImage>
+class ITK_EXPORT CandidateBlocksImageFilter :
+public itk::ImageToImageFilter<TImage, TImage>
+{
+
+public:
+
+  /** Standard class typedefs. */
+  typedef CandidateBlocksImageFilter              Self;
+  typedef itk::ImageToImageFilter<TImage, TImage> Superclass;
+  typedef itk::SmartPointer<Self>                 Pointer;
+  typedef itk::SmartPointer<const Self>           ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(CandidateBlocksImageFilter, itk::ImageToImageFilter);
+
+  /** Image typedefs */
+  typedef TImage                                         ImageType;
+  typedef typename ImageType::RegionType                 ImageRegionType;
+  typedef typename ImageType::IndexType                  ImageIndexType;
+  typedef typename ImageType::SizeType                   ImageSizeType;
+  typedef typename ImageType::PixelType                  ImagePixelType;
+  typedef typename itk::ImageRegionConstIterator<TImage> InputImageIteratorType;
+  typedef typename itk::ImageRegionIterator<TImage>      OutputImageIteratorType;
+  typedef std::vector<bool>                              BooleanListType;
+
+  itkSetMacro(BlockSize, unsigned int);
+  itkGetMacro(BlockSize, unsigned int);
+
+  itkSetMacro(OutsideValue, ImagePixelType);
+  itkGetMacro(OutsideValue, ImagePixelType);
+
+  /** Mark all the blocks intersecting the region (input indices) as candidates.
+   * The input information must be up to date. */
+  void AddCandidateRegion(const ImageRegionType & region);
+
+  /** Number of candidate blocks, and total number of blocks */
+  unsigned int GetNumberOfCandidateBlocks() const;
+  unsigned int GetNumberOfBlocks() const { return m_Candidates.size(); }
+
+protected:
+  CandidateBlocksImageFilter();
+  virtual ~CandidateBlocksImageFilter() {};
+
+  /** Blocks covering the region */
+  void GetBlocksRange(const ImageRegionType & region, unsigned int & bx0, unsigned int & by0,
+      unsigned int & bx1, unsigned int & by1) const;
+
+  virtual void GenerateInputRequestedRegion();
+
+  virtual void ThreadedGenerateData(const ImageRegionType& outputRegionForThread,
+      itk::ThreadIdType threadId);
+
+private:
+  CandidateBlocksImageFilter(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+  unsigned int    m_BlockSize;
+  ImagePixelType  m_OutsideValue;
+
+  // Candidate blocks grid
+  ImageRegionType m_GridRegion;
+  unsigned int    m_NumberOfBlocksX;
+  unsigned int    m_NumberOfBlocksY;
+  BooleanListType m_Candidates;
+
+};
+
+
+} // end namespace otb
+
+#include "otbCandidateBlocksImageFilter.hxx"
+
+
+#endif /* CandidateBlocksImageFilter_H_ */
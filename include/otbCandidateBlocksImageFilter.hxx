@@ -0,0 +1,210 @@
+/*=========================================================================
+
+  Copyright (c) Remi Cresson (IRSTEA). All rights reserved.
+
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef __CandidateBlocksImageFilter_hxx
+#define __CandidateBlocksImageFilter_hxx
+
+#include "otbCandidateBlocksImageFilter.h"
+#include "itkProgressReporter.h"
+
+namespace otb
+{
+/**
+ *
+ */
+template <class TImage>
+CandidateBlocksImageFilter<TImage>
+::CandidateBlocksImageFilter()
+ {
+  m_BlockSize = 256;
+  m_OutsideValue = itk::NumericTraits<ImagePixelType>::Zero;
+  m_NumberOfBlocksX = 0;
+  m_NumberOfBlocksY = 0;
+ }
+
+/*
+ * Blocks covering the region (the region must be inside the grid region)
+ */
+template <class TImage>
+void
+CandidateBlocksImageFilter<TImage>
+::GetBlocksRange(const ImageRegionType & region, unsigned int & bx0, unsigned int & by0,
+    unsigned int & bx1, unsigned int & by1) const
+ {
+  const ImageIndexType origin = m_GridRegion.GetIndex();
+  bx0 = (region.GetIndex(0) - origin[0]) / m_BlockSize;
+  by0 = (region.GetIndex(1) - origin[1]) / m_BlockSize;
+  bx1 = (region.GetIndex(0) + region.GetSize(0) - 1 - origin[0]) / m_BlockSize;
+  by1 = (region.GetIndex(1) + region.GetSize(1) - 1 - origin[1]) / m_BlockSize;
+ }
+
+template <class TImage>
+void
+CandidateBlocksImageFilter<TImage>
+::AddCandidateRegion(const ImageRegionType & region)
+ {
+  // Initialize the grid
+  const ImageRegionType largestRegion = this->GetInput()->GetLargestPossibleRegion();
+  if (m_Candidates.empty() || m_GridRegion != largestRegion)
+    {
+    m_GridRegion = largestRegion;
+    m_NumberOfBlocksX = (largestRegion.GetSize(0) + m_BlockSize - 1) / m_BlockSize;
+    m_NumberOfBlocksY = (largestRegion.GetSize(1) + m_BlockSize - 1) / m_BlockSize;
+    m_Candidates.assign(m_NumberOfBlocksX * m_NumberOfBlocksY, false);
+    }
+
+  ImageRegionType candidateRegion(region);
+  if (!candidateRegion.Crop(m_GridRegion))
+    return;
+
+  unsigned int bx0, by0, bx1, by1;
+  GetBlocksRange(candidateRegion, bx0, by0, bx1, by1);
+  for (unsigned int by = by0 ; by <= by1 ; by++)
+    for (unsigned int bx = bx0 ; bx <= bx1 ; bx++)
+      m_Candidates[by * m_NumberOfBlocksX + bx] = true;
+
+  this->Modified();
+ }
+
+template <class TImage>
+unsigned int
+CandidateBlocksImageFilter<TImage>
+::GetNumberOfCandidateBlocks() const
+ {
+  unsigned int nbOfCandidates = 0;
+  for (unsigned int i = 0 ; i < m_Candidates.size() ; i++)
+    if (m_Candidates[i])
+      nbOfCandidates++;
+  return nbOfCandidates;
+ }
+
+/*
+ * Request the bounding box of the candidate blocks only
+ */
+template <class TImage>
+void
+CandidateBlocksImageFilter<TImage>
+::GenerateInputRequestedRegion()
+ {
+  const ImageRegionType outRegion = this->GetOutput()->GetRequestedRegion();
+  ImageType * inputImage = static_cast<ImageType * >(
+      Superclass::ProcessObject::GetInput(0) );
+
+  ImageIndexType lower;
+  ImageIndexType upper;
+  bool hasCandidate = false;
+  if (!m_Candidates.empty())
+    {
+    unsigned int bx0, by0, bx1, by1;
+    GetBlocksRange(outRegion, bx0, by0, bx1, by1);
+    for (unsigned int by = by0 ; by <= by1 ; by++)
+      {
+      for (unsigned int bx = bx0 ; bx <= bx1 ; bx++)
+        {
+        if (!m_Candidates[by * m_NumberOfBlocksX + bx])
+          continue;
+
+        ImageIndexType blockLower, blockUpper;
+        blockLower[0] = m_GridRegion.GetIndex(0) + bx * m_BlockSize;
+        blockLower[1] = m_GridRegion.GetIndex(1) + by * m_BlockSize;
+        blockUpper[0] = blockLower[0] + m_BlockSize - 1;
+        blockUpper[1] = blockLower[1] + m_BlockSize - 1;
+        if (!hasCandidate)
+          {
+          lower = blockLower;
+          upper = blockUpper;
+          hasCandidate = true;
+          }
+        for (unsigned int dim = 0 ; dim < 2 ; dim++)
+          {
+          lower[dim] = std::min(lower[dim], blockLower[dim]);
+          upper[dim] = std::max(upper[dim], blockUpper[dim]);
+          }
+        }
+      }
+    }
+
+  ImageRegionType inRegion;
+  if (hasCandidate)
+    {
+    ImageSizeType size;
+    size[0] = upper[0] - lower[0] + 1;
+    size[1] = upper[1] - lower[1] + 1;
+    inRegion.SetIndex(lower);
+    inRegion.SetSize(size);
+    inRegion.Crop(outRegion);
+    }
+  else
+    {
+    // Nothing to compute upstream: request a single pixel
+    ImageSizeType size;
+    size.Fill(1);
+    inRegion.SetIndex(outRegion.GetIndex());
+    inRegion.SetSize(size);
+    }
+  inputImage->SetRequestedRegion(inRegion);
+ }
+
+/**
+ *
+ */
+template <class TImage>
+void
+CandidateBlocksImageFilter<TImage>
+::ThreadedGenerateData(const ImageRegionType& outputRegionForThread, itk::ThreadIdType threadId)
+ {
+
+  // Debug info
+  itkDebugMacro(<<"Actually executing thread " << threadId << " in region " << outputRegionForThread);
+
+  // Support progress methods/callbacks
+  itk::ProgressReporter progress(this, threadId, outputRegionForThread.GetSize(1) );
+
+  const ImageIndexType origin = m_GridRegion.GetIndex();
+  const long xEnd = outputRegionForThread.GetIndex(0) + outputRegionForThread.GetSize(0);
+
+  // Process each row by spans of blocks
+  ImageRegionType span;
+  span.SetSize(1, 1);
+  for (unsigned int y = 0 ; y < outputRegionForThread.GetSize(1) ; y++)
+    {
+    const long row = outputRegionForThread.GetIndex(1) + y;
+    const unsigned int by = (row - origin[1]) / m_BlockSize;
+
+    long x = outputRegionForThread.GetIndex(0);
+    while (x < xEnd)
+      {
+      const unsigned int bx = (x - origin[0]) / m_BlockSize;
+      const long blockEnd = std::min(xEnd, static_cast<long>(origin[0] + (bx + 1) * m_BlockSize));
+      span.SetIndex(0, x);
+      span.SetIndex(1, row);
+      span.SetSize(0, blockEnd - x);
+
+      OutputImageIteratorType outputIt(this->GetOutput(), span);
+      if (!m_Candidates.empty() && m_Candidates[by * m_NumberOfBlocksX + bx])
+        {
+        InputImageIteratorType inputIt(this->GetInput(), span);
+        for ( outputIt.GoToBegin(), inputIt.GoToBegin(); !outputIt.IsAtEnd(); ++outputIt, ++inputIt )
+          outputIt.Set(inputIt.Get());
+        }
+      else
+        {
+        for ( outputIt.GoToBegin(); !outputIt.IsAtEnd(); ++outputIt )
+          outputIt.Set(m_OutsideValue);
+        }
+
+      x = blockEnd;
+      }
+
+    progress.CompletedPixel();
+    } // Next row
+ }
+}
+#endif
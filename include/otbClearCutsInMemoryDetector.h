@@ -0,0 +1,195 @@
+/*=========================================================================
+
+  Copyright (c) Remi Cresson (IRSTEA). All rights reserved.
+
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef ClearCutsInMemoryDetector_H_
+#define ClearCutsInMemoryDetector_H_
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+#include "itkBinaryFunctorImageFilter.h"
+#include "itkMaskImageFilter.h"
+#include "otbImage.h"
+#include "otbVectorImage.h"
+#include "otbVectorData.h"
+
+#include "otbDeltaNDVIFunctor.h"
+#include "otbStreamingDeltaNDVIStatisticsFilter.h"
+#include "otbStreamingDeltaNDVIRunsFilter.h"
+#include "otbConnectedComponentsRunTableToVectorDataFilter.h"
+
+#include <string>
+
+namespace otb
+{
+
+/**
+ * \class ClearCutsInMemoryDetector
+ * \brief Clear cuts detection over caller-owned buffers
+ *
+ * Library entry point of the detection chain (dNDVI, statistics,
+ * threshold, components filtering and polygons) for callers which already
+ * hold two co-registered images in memory, e.g. after their own
+ * preprocessing. No file is read nor written.
+ *
+ * Input buffers are pixel interleaved (rows, columns, bands), which is the
+ * layout of C-contiguous NumPy arrays. They are not copied: the images of
+ * the pipeline point to them, so they must stay valid during Execute().
+ * The geometry is given by a GDAL geotransform (north-up images only) and
+ * a WKT projection.
+ *
+ * The polygons are the ones of ClearCutsDetection with the sparse
+ * pipeline: the candidates are thresholded in runs, and the components
+ * larger than m_MinNumberOfComponents are traced from their runs. Their
+ * attributes (area, bounding box, min/mean dNDVI) are in the run table.
+ *
+ * \ingroup ClearCutsDetection
+ */
+template <class TInputValue>
+class ITK_EXPORT ClearCutsInMemoryDetector : public itk::Object
+{
+
+public:
+
+  /** Standard class typedefs. */
+  typedef ClearCutsInMemoryDetector     Self;
+  typedef itk::Object                   Superclass;
+  typedef itk::SmartPointer<Self>       Pointer;
+  typedef itk::SmartPointer<const Self> ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(ClearCutsInMemoryDetector, itk::Object);
+
+  /** Images typedefs */
+  typedef TInputValue                                                InputValueType;
+  typedef otb::VectorImage<InputValueType, 2>                        InputImageType;
+  typedef otb::Image<float, 2>                                       FloatImageType;
+  typedef otb::Image<unsigned char, 2>                               MaskImageType;
+
+  /** Filters typedefs */
+  typedef Functor::DeltaNDVIFromChannels<typename InputImageType::PixelType,
+      FloatImageType::PixelType>                                     DeltaNDVIFunctorType;
+  typedef itk::BinaryFunctorImageFilter<InputImageType, InputImageType,
+      FloatImageType, DeltaNDVIFunctorType>                          DeltaNDVIFilterType;
+  typedef itk::MaskImageFilter<FloatImageType, MaskImageType,
+      FloatImageType>                                                MaskImageFilterType;
+  typedef StreamingDeltaNDVIStatisticsFilter<FloatImageType>         StatsFilterType;
+  typedef StreamingDeltaNDVIRunsFilter<FloatImageType,
+      MaskImageType::PixelType>                                      RunsFilterType;
+  typedef typename RunsFilterType::RunTableType                      RunTableType;
+  typedef otb::VectorData<double, 2>                                 VectorDataType;
+  typedef ConnectedComponentsRunTableToVectorDataFilter<RunTableType,
+      VectorDataType>                                                PolygonsFilterType;
+
+  /** Input buffers (width x height pixels of nbBands values), not copied */
+  void SetInputBuffers(const InputValueType * bufferT0, unsigned int nbBandsT0,
+      const InputValueType * bufferT1, unsigned int nbBandsT1,
+      unsigned int width, unsigned int height);
+
+  /** Optional validity mask (width x height, 0 where pixels are not valid), not copied */
+  void SetMaskBuffer(const unsigned char * buffer) { m_MaskBuffer = buffer; this->Modified(); }
+
+  /** GDAL geotransform of the buffers (north-up only) */
+  void SetGeoTransform(const double geoTransform[6]);
+
+  itkSetStringMacro(ProjectionRef);
+  itkGetStringMacro(ProjectionRef);
+
+  /** Bands (starting at 1) */
+  itkSetMacro(NIRBandT0, unsigned int);
+  itkGetMacro(NIRBandT0, unsigned int);
+  itkSetMacro(RedBandT0, unsigned int);
+  itkGetMacro(RedBandT0, unsigned int);
+  itkSetMacro(NIRBandT1, unsigned int);
+  itkGetMacro(NIRBandT1, unsigned int);
+  itkSetMacro(RedBandT1, unsigned int);
+  itkGetMacro(RedBandT1, unsigned int);
+
+  /** dNDVI threshold, in standard deviations below the mean */
+  itkSetMacro(Sigma, double);
+  itkGetMacro(Sigma, double);
+
+  /** Components of at most this number of pixels are removed */
+  itkSetMacro(MinNumberOfComponents, unsigned int);
+  itkGetMacro(MinNumberOfComponents, unsigned int);
+
+  /** 8-connectivity (true) or 4-connectivity (false, default) */
+  itkSetMacro(FullyConnected, bool);
+  itkGetMacro(FullyConnected, bool);
+
+  /** Memory of the processed tiles (Mb) */
+  itkSetMacro(AvailableRAM, unsigned int);
+  itkGetMacro(AvailableRAM, unsigned int);
+
+  /** Run the detection */
+  void Execute();
+
+  /** Results (valid after Execute()) */
+  VectorDataType * GetPolygons() { return m_PolygonsFilter->GetOutput(); }
+  const DeltaNDVIStatistics & GetStatistics() const { return m_StatsFilter->GetStatistics(); }
+  double GetMean() const { return m_StatsFilter->GetStatistics().GetMean(); }
+  double GetSigma() const { return m_StatsFilter->GetStatistics().GetSigma(); }
+  const RunTableType & GetRunTable() const { return m_RunsFilter->GetRunTable(); }
+
+protected:
+  ClearCutsInMemoryDetector();
+  virtual ~ClearCutsInMemoryDetector() {};
+
+  /** Image pointing to a buffer */
+  template <class TImage>
+  typename TImage::Pointer CreateImage(const typename TImage::InternalPixelType * buffer,
+      unsigned int nbBands) const;
+
+private:
+  ClearCutsInMemoryDetector(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+  // Inputs
+  const InputValueType * m_BufferT0;
+  const InputValueType * m_BufferT1;
+  const unsigned char *  m_MaskBuffer;
+  unsigned int           m_NbBandsT0;
+  unsigned int           m_NbBandsT1;
+  unsigned int           m_Width;
+  unsigned int           m_Height;
+  double                 m_GeoTransform[6];
+  std::string            m_ProjectionRef;
+
+  // Parameters
+  unsigned int           m_NIRBandT0;
+  unsigned int           m_RedBandT0;
+  unsigned int           m_NIRBandT1;
+  unsigned int           m_RedBandT1;
+  double                 m_Sigma;
+  unsigned int           m_MinNumberOfComponents;
+  bool                   m_FullyConnected;
+  unsigned int           m_AvailableRAM;
+
+  // Pipeline
+  typename InputImageType::Pointer       m_ImageT0;
+  typename InputImageType::Pointer       m_ImageT1;
+  typename MaskImageType::Pointer        m_MaskImage;
+  typename DeltaNDVIFilterType::Pointer  m_DeltaNDVIFilter;
+  typename MaskImageFilterType::Pointer  m_MaskImageFilter;
+  typename StatsFilterType::Pointer      m_StatsFilter;
+  typename RunsFilterType::Pointer       m_RunsFilter;
+  typename PolygonsFilterType::Pointer   m_PolygonsFilter;
+
+};
+
+
+} // end namespace otb
+
+#include "otbClearCutsInMemoryDetector.hxx"
+
+
+#endif /* ClearCutsInMemoryDetector_H_ */
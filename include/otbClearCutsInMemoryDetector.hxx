@@ -0,0 +1,181 @@
+/*=========================================================================
+
+  Copyright (c) Remi Cresson (IRSTEA). All rights reserved.
+
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef __ClearCutsInMemoryDetector_hxx
+#define __ClearCutsInMemoryDetector_hxx
+
+#include "otbClearCutsInMemoryDetector.h"
+
+#include <algorithm>
+
+namespace otb
+{
+/**
+ *
+ */
+template <class TInputValue>
+ClearCutsInMemoryDetector<TInputValue>
+::ClearCutsInMemoryDetector()
+ {
+  m_BufferT0 = NULL;
+  m_BufferT1 = NULL;
+  m_MaskBuffer = NULL;
+  m_NbBandsT0 = 0;
+  m_NbBandsT1 = 0;
+  m_Width = 0;
+  m_Height = 0;
+  const double geoTransform[6] = {0.0, 1.0, 0.0, 0.0, 0.0, 1.0};
+  std::copy(geoTransform, geoTransform + 6, m_GeoTransform);
+
+  m_NIRBandT0 = 4;
+  m_RedBandT0 = 1;
+  m_NIRBandT1 = 4;
+  m_RedBandT1 = 1;
+  m_Sigma = 3.0;
+  m_MinNumberOfComponents = 10;
+  m_FullyConnected = false;
+  m_AvailableRAM = 128;
+ }
+
+template <class TInputValue>
+void
+ClearCutsInMemoryDetector<TInputValue>
+::SetInputBuffers(const InputValueType * bufferT0, unsigned int nbBandsT0,
+    const InputValueType * bufferT1, unsigned int nbBandsT1,
+    unsigned int width, unsigned int height)
+ {
+  m_BufferT0 = bufferT0;
+  m_NbBandsT0 = nbBandsT0;
+  m_BufferT1 = bufferT1;
+  m_NbBandsT1 = nbBandsT1;
+  m_Width = width;
+  m_Height = height;
+  this->Modified();
+ }
+
+template <class TInputValue>
+void
+ClearCutsInMemoryDetector<TInputValue>
+::SetGeoTransform(const double geoTransform[6])
+ {
+  if (geoTransform[2] != 0.0 || geoTransform[4] != 0.0)
+    {
+    itkExceptionMacro("Rotated geotransforms are not supported");
+    }
+  std::copy(geoTransform, geoTransform + 6, m_GeoTransform);
+  this->Modified();
+ }
+
+/*
+ * The pixel container imports the buffer, without managing its memory
+ */
+template <class TInputValue>
+template <class TImage>
+typename TImage::Pointer
+ClearCutsInMemoryDetector<TInputValue>
+::CreateImage(const typename TImage::InternalPixelType * buffer, unsigned int nbBands) const
+ {
+  typename TImage::RegionType region;
+  region.SetSize(0, m_Width);
+  region.SetSize(1, m_Height);
+
+  // Origin is the center of the first pixel
+  typename TImage::PointType origin;
+  origin[0] = m_GeoTransform[0] + 0.5 * m_GeoTransform[1];
+  origin[1] = m_GeoTransform[3] + 0.5 * m_GeoTransform[5];
+  typename TImage::SpacingType spacing;
+  spacing[0] = m_GeoTransform[1];
+  spacing[1] = m_GeoTransform[5];
+
+  typename TImage::Pointer image = TImage::New();
+  image->SetRegions(region);
+  image->SetNumberOfComponentsPerPixel(nbBands);
+  image->SetOrigin(origin);
+  image->SetSignedSpacing(spacing);
+  image->GetPixelContainer()->SetImportPointer(
+      const_cast<typename TImage::InternalPixelType *>(buffer),
+      static_cast<itk::SizeValueType>(m_Width) * m_Height * nbBands, false);
+  return image;
+ }
+
+/**
+ *
+ */
+template <class TInputValue>
+void
+ClearCutsInMemoryDetector<TInputValue>
+::Execute()
+ {
+  if (m_BufferT0 == NULL || m_BufferT1 == NULL || m_Width == 0 || m_Height == 0)
+    {
+    itkExceptionMacro("Input buffers must be set");
+    }
+  if (std::max(m_NIRBandT0, m_RedBandT0) > m_NbBandsT0 || std::max(m_NIRBandT1, m_RedBandT1) > m_NbBandsT1 ||
+      std::min(std::min(m_NIRBandT0, m_RedBandT0), std::min(m_NIRBandT1, m_RedBandT1)) == 0)
+    {
+    itkExceptionMacro("Band index out of range");
+    }
+
+  // Images pointing to the buffers
+  m_ImageT0 = CreateImage<InputImageType>(m_BufferT0, m_NbBandsT0);
+  m_ImageT1 = CreateImage<InputImageType>(m_BufferT1, m_NbBandsT1);
+
+  // Delta NDVI
+  m_DeltaNDVIFilter = DeltaNDVIFilterType::New();
+  m_DeltaNDVIFilter->SetInput1(m_ImageT0);
+  m_DeltaNDVIFilter->SetInput2(m_ImageT1);
+  m_DeltaNDVIFilter->GetFunctor().SetNIRChannelT0(m_NIRBandT0);
+  m_DeltaNDVIFilter->GetFunctor().SetRedChannelT0(m_RedBandT0);
+  m_DeltaNDVIFilter->GetFunctor().SetNIRChannelT1(m_NIRBandT1);
+  m_DeltaNDVIFilter->GetFunctor().SetRedChannelT1(m_RedBandT1);
+  const double noDataValue = m_DeltaNDVIFilter->GetFunctor().GetNoDataValue();
+  FloatImageType * deltaNDVIImage = m_DeltaNDVIFilter->GetOutput();
+
+  // Validity mask
+  if (m_MaskBuffer != NULL)
+    {
+    m_MaskImage = CreateImage<MaskImageType>(m_MaskBuffer, 1);
+    m_MaskImageFilter = MaskImageFilterType::New();
+    m_MaskImageFilter->SetInput(deltaNDVIImage);
+    m_MaskImageFilter->SetMaskImage(m_MaskImage);
+    m_MaskImageFilter->SetOutsideValue(noDataValue);
+    deltaNDVIImage = m_MaskImageFilter->GetOutput();
+    }
+
+  // Statistics
+  m_StatsFilter = StatsFilterType::New();
+  m_StatsFilter->SetInput(deltaNDVIImage);
+  m_StatsFilter->SetIgnoreUserDefinedValue(true);
+  m_StatsFilter->SetUserIgnoredValue(noDataValue);
+  m_StatsFilter->SetBlockAlignedStreaming(m_AvailableRAM);
+  m_StatsFilter->Update();
+
+  // Runs of candidates, and their connected components
+  m_RunsFilter = RunsFilterType::New();
+  m_RunsFilter->SetInput(deltaNDVIImage);
+  m_RunsFilter->SetInputMeanObject(m_StatsFilter->GetMeanOutput());
+  m_RunsFilter->SetInputSigmaObject(m_StatsFilter->GetSigmaOutput());
+  m_RunsFilter->SetFirstClassStart(m_Sigma);
+  m_RunsFilter->SetInputNoDataValue(noDataValue);
+  m_RunsFilter->SetRunValue(1);
+  m_RunsFilter->SetFullyConnected(m_FullyConnected);
+  m_RunsFilter->GetStreamer()->SetAutomaticAdaptativeStreaming(m_AvailableRAM);
+  m_RunsFilter->Update();
+
+  // Polygons
+  m_PolygonsFilter = PolygonsFilterType::New();
+  m_PolygonsFilter->SetRunTable(&m_RunsFilter->GetRunTable());
+  m_PolygonsFilter->SetReferenceImage(deltaNDVIImage);
+  m_PolygonsFilter->SetMinNumberOfComponents(m_MinNumberOfComponents);
+  m_PolygonsFilter->Update();
+  m_PolygonsFilter->GetOutput()->SetProjectionRef(m_ProjectionRef);
+ }
+}
+#endif
@@ -25,6 +25,9 @@ namespace otb
  * The behavior of the filter is to put layers in the same order
  * as they are in input
  *
+ * The aggregation is performed by a reducer (see otbClearCutsReducers.h),
+ * which gives the number of output bands.
+ *
  * \ingroup ClearCutsDetection
  */
 template <class TInputImage, class TOutputImage, class TInternalValueType, class TFunctorType>
@@ -63,6 +66,11 @@ public:
   typedef typename Superclass::InternalValueType InternalValueType;
   typedef typename Superclass::InternalPixelType InternalPixelType;
 
+  /** Reducer */
+  typedef TFunctorType FunctorType;
+  FunctorType & GetFunctor() { return m_Functor; }
+  const FunctorType & GetFunctor() const { return m_Functor; }
+
 protected:
   ClearCutsMosaicingFilter() {}
 
@@ -70,6 +78,7 @@ protected:
   }
 
   /** Overrided methods */
+  virtual void GenerateOutputInformation();
   virtual void ThreadedGenerateData(const OutputImageRegionType& outputRegionForThread, itk::ThreadIdType threadId );
 
 private:
@@ -15,6 +15,19 @@
 
 namespace otb {
 
+/**
+ * The number of output bands is the one of the reducer
+ */
+template <class TInputImage, class TOutputImage, class TInternalValueType, class TFunctorType>
+void
+ClearCutsMosaicingFilter<TInputImage, TOutputImage, TInternalValueType, TFunctorType>
+::GenerateOutputInformation()
+ {
+  Superclass::GenerateOutputInformation();
+
+  this->GetOutput()->SetNumberOfComponentsPerPixel(TFunctorType::NumberOfBands);
+ }
+
 /**
  * Processing
  */
@@ -52,14 +65,18 @@ ClearCutsMosaicingFilter<TInputImage, TOutputImage, TInternalValueType, TFunctor
   // Container for geo coordinates
   OutputImagePointType geoPoint;
 
+  // Reducer, which is DEDICATED TO THE THREAD (it holds the pixel state)
+  TFunctorType functor(m_Functor);
+
+  // Prepare output pixel
+  OutputImagePixelType outputPixel;
+  outputPixel.SetSize(TFunctorType::NumberOfBands);
+
   for ( outputIt.GoToBegin(); !outputIt.IsAtEnd(); ++outputIt )
     {
 
-    // Init. pixel stack
-    std::vector<OutputImagePixelType> pixelStack;
-
-    // Prepare output pixel
-    OutputImagePixelType outputPixel(Superclass::GetNoDataOutputPixel() );
+    // Init. reducer
+    functor.Reset();
 
     // Current pixel --> Geographical point
     mosaicImage->TransformIndexToPhysicalPoint (outputIt.GetIndex(), geoPoint) ;
@@ -80,11 +97,9 @@ ClearCutsMosaicingFilter<TInputImage, TOutputImage, TInternalValueType, TFunctor
         // Check that interpolated pixel is not empty
         if (Superclass::IsPixelNotEmpty(interpolatedPixel) )
           {
-          // Update the output pixel
-          outputPixel[0] = static_cast<OutputImageInternalPixelType>(interpolatedPixel[0]);
-
-          // Add the pixel to the stack
-          pixelStack.push_back(outputPixel);
+          // Add the pixel value to the reducer
+          functor.Push(static_cast<OutputImageInternalPixelType>(interpolatedPixel[0]),
+              Superclass::GetUsedInputImageIndice(i));
 
           } // Interpolated pixel is not empty
         }   // point inside buffer
@@ -92,7 +107,8 @@ ClearCutsMosaicingFilter<TInputImage, TOutputImage, TInternalValueType, TFunctor
 
 
     // Update output pixel value
-    outputIt.Set(m_Functor(pixelStack));
+    functor.Fill(outputPixel, 0);
+    outputIt.Set(outputPixel);
 
     // Update progress
     progress.CompletedPixel();
@@ -0,0 +1,344 @@
+/*=========================================================================
+
+  Copyright (c) Remi Cresson (IRSTEA). All rights reserved.
+
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef __otbClearCutsReducers_h
+#define __otbClearCutsReducers_h
+
+#include "itkNumericTraits.h"
+#include <vector>
+#include <utility>
+
+namespace otb
+{
+
+namespace Functor
+{
+
+/*
+ * Reducers are the functors of the ClearCutsMosaicingFilter. For each output
+ * pixel, the filter calls Reset(), then Push() the (non empty) value of each
+ * input image, then Fill() the output pixel bands, starting at a given band.
+ * Each thread works on its own copy of the reducer.
+ *
+ * Reducers can be chained at compile time (ReducerChain) to compute several
+ * aggregations in a single pass, each one in its own band(s).
+ */
+
+/** \class ReducerBase
+ *  \brief Default (ignored) inputs dates and weights
+ *
+ *  \ingroup ClearCutsDetection
+ */
+class ReducerBase
+{
+public:
+  void SetInputDates(const std::vector<double> &) {}
+  void SetInputWeights(const std::vector<double> &) {}
+};
+
+/** \class MaxCC
+ *  \brief Maximum of the clear cuts label value
+ *
+ *  \ingroup ClearCutsDetection
+ */
+template< class TValue>
+class MaxCC : public ReducerBase
+{
+public:
+  typedef TValue ValueType;
+  static const unsigned int NumberOfBands = 1;
+
+  MaxCC() { Reset(); }
+  ~MaxCC() {}
+
+  bool operator!=( const MaxCC & ) const {
+    return false;
+  }
+
+  bool operator==( const MaxCC & other ) const {
+    return !(*this != other);
+  }
+
+  inline void Reset() { m_Max = itk::NumericTraits<TValue>::Zero; }
+
+  inline void Push(const TValue & value, unsigned int)
+  {
+    if (m_Max < value)
+      m_Max = value;
+  }
+
+  template<class TPixel>
+  inline void Fill(TPixel & output, unsigned int band) const { output[band] = m_Max; }
+
+private:
+  TValue m_Max;
+};
+
+/** \class MeanCC
+ *  \brief Mean of the clear cuts label value
+ *
+ *  \ingroup ClearCutsDetection
+ */
+template< class TValue>
+class MeanCC : public ReducerBase
+{
+public:
+  typedef TValue ValueType;
+  static const unsigned int NumberOfBands = 1;
+
+  MeanCC() { Reset(); }
+  ~MeanCC() {}
+
+  bool operator!=( const MeanCC & ) const {
+    return false;
+  }
+
+  bool operator==( const MeanCC & other ) const {
+    return !(*this != other);
+  }
+
+  inline void Reset() { m_Sum = 0.0; m_Count = 0; }
+
+  inline void Push(const TValue & value, unsigned int)
+  {
+    m_Sum += value;
+    m_Count++;
+  }
+
+  template<class TPixel>
+  inline void Fill(TPixel & output, unsigned int band) const
+  {
+    output[band] = static_cast<TValue>(m_Count > 0 ? m_Sum / static_cast<double>(m_Count) : 0.0);
+  }
+
+private:
+  double       m_Sum;
+  unsigned int m_Count;
+};
+
+/** \class CountCC
+ *  \brief Number of inputs where a clear cut is detected (label > 0)
+ *
+ *  \ingroup ClearCutsDetection
+ */
+template< class TValue>
+class CountCC : public ReducerBase
+{
+public:
+  typedef TValue ValueType;
+  static const unsigned int NumberOfBands = 1;
+
+  CountCC() { Reset(); }
+  ~CountCC() {}
+
+  bool operator!=( const CountCC & ) const {
+    return false;
+  }
+
+  bool operator==( const CountCC & other ) const {
+    return !(*this != other);
+  }
+
+  inline void Reset() { m_Count = 0; }
+
+  inline void Push(const TValue & value, unsigned int)
+  {
+    if (value > itk::NumericTraits<TValue>::Zero)
+      m_Count++;
+  }
+
+  template<class TPixel>
+  inline void Fill(TPixel & output, unsigned int band) const { output[band] = static_cast<TValue>(m_Count); }
+
+private:
+  unsigned int m_Count;
+};
+
+/** \class LastDateCC
+ *  \brief Most recent date of the inputs where a clear cut is detected
+ *
+ *  The date of the input i is the i-th input date, or (i+1) when no dates
+ *  are set. The output is 0 where no clear cut is detected.
+ *
+ *  \ingroup ClearCutsDetection
+ */
+template< class TValue>
+class LastDateCC : public ReducerBase
+{
+public:
+  typedef TValue ValueType;
+  static const unsigned int NumberOfBands = 1;
+
+  LastDateCC() { Reset(); }
+  ~LastDateCC() {}
+
+  bool operator!=( const LastDateCC & ) const {
+    return false;
+  }
+
+  bool operator==( const LastDateCC & other ) const {
+    return !(*this != other);
+  }
+
+  void SetInputDates(const std::vector<double> & dates) { m_Dates = dates; }
+
+  inline void Reset() { m_LastDate = 0.0; }
+
+  inline void Push(const TValue & value, unsigned int inputIndex)
+  {
+    if (value > itk::NumericTraits<TValue>::Zero)
+      {
+      const double date = (inputIndex < m_Dates.size()) ? m_Dates[inputIndex] : inputIndex + 1.0;
+      if (m_LastDate < date)
+        m_LastDate = date;
+      }
+  }
+
+  template<class TPixel>
+  inline void Fill(TPixel & output, unsigned int band) const { output[band] = static_cast<TValue>(m_LastDate); }
+
+private:
+  std::vector<double> m_Dates;
+  double              m_LastDate;
+};
+
+/** \class WeightedModeCC
+ *  \brief Label with the largest total weight among the inputs
+ *
+ *  The weight of the input i is the i-th input weight, or 1 when no weights
+ *  are set (the output is then the majority label). Ties are broken by the
+ *  lowest label.
+ *
+ *  \ingroup ClearCutsDetection
+ */
+template< class TValue, bool VUseWeights>
+class WeightedModeCC : public ReducerBase
+{
+public:
+  typedef TValue ValueType;
+  static const unsigned int NumberOfBands = 1;
+
+  WeightedModeCC() { Reset(); }
+  ~WeightedModeCC() {}
+
+  bool operator!=( const WeightedModeCC & ) const {
+    return false;
+  }
+
+  bool operator==( const WeightedModeCC & other ) const {
+    return !(*this != other);
+  }
+
+  void SetInputWeights(const std::vector<double> & weights) { if (VUseWeights) m_Weights = weights; }
+
+  inline void Reset() { m_Votes.clear(); }
+
+  inline void Push(const TValue & value, unsigned int inputIndex)
+  {
+    const double weight = (inputIndex < m_Weights.size()) ? m_Weights[inputIndex] : 1.0;
+    for (unsigned int i = 0 ; i < m_Votes.size() ; i++)
+      {
+      if (m_Votes[i].first == value)
+        {
+        m_Votes[i].second += weight;
+        return;
+        }
+      }
+    m_Votes.push_back(std::make_pair(value, weight));
+  }
+
+  template<class TPixel>
+  inline void Fill(TPixel & output, unsigned int band) const
+  {
+    TValue label = itk::NumericTraits<TValue>::Zero;
+    double bestWeight = 0.0;
+    for (unsigned int i = 0 ; i < m_Votes.size() ; i++)
+      {
+      if (bestWeight < m_Votes[i].second ||
+          (bestWeight == m_Votes[i].second && m_Votes[i].first < label))
+        {
+        label = m_Votes[i].first;
+        bestWeight = m_Votes[i].second;
+        }
+      }
+    output[band] = label;
+  }
+
+private:
+  // The capacity of the votes is kept between pixels
+  std::vector<std::pair<TValue, double> > m_Votes;
+  std::vector<double>                     m_Weights;
+};
+
+/** \class ReducerChain
+ *  \brief Compile-time concatenation of two reducers
+ *
+ *  The bands of THead come first, then the bands of TTail.
+ *
+ *  \ingroup ClearCutsDetection
+ */
+template< class THead, class TTail>
+class ReducerChain
+{
+public:
+  typedef typename THead::ValueType ValueType;
+  static const unsigned int NumberOfBands = THead::NumberOfBands + TTail::NumberOfBands;
+
+  ReducerChain() {}
+  ~ReducerChain() {}
+
+  bool operator!=( const ReducerChain & other ) const {
+    return m_Head != other.m_Head || m_Tail != other.m_Tail;
+  }
+
+  bool operator==( const ReducerChain & other ) const {
+    return !(*this != other);
+  }
+
+  void SetInputDates(const std::vector<double> & dates)
+  {
+    m_Head.SetInputDates(dates);
+    m_Tail.SetInputDates(dates);
+  }
+
+  void SetInputWeights(const std::vector<double> & weights)
+  {
+    m_Head.SetInputWeights(weights);
+    m_Tail.SetInputWeights(weights);
+  }
+
+  inline void Reset()
+  {
+    m_Head.Reset();
+    m_Tail.Reset();
+  }
+
+  inline void Push(const ValueType & value, unsigned int inputIndex)
+  {
+    m_Head.Push(value, inputIndex);
+    m_Tail.Push(value, inputIndex);
+  }
+
+  template<class TPixel>
+  inline void Fill(TPixel & output, unsigned int band) const
+  {
+    m_Head.Fill(output, band);
+    m_Tail.Fill(output, band + THead::NumberOfBands);
+  }
+
+private:
+  THead m_Head;
+  TTail m_Tail;
+};
+
+} // namespace Functor
+} // namespace otb
+
+#endif
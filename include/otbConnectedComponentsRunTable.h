@@ -0,0 +1,252 @@
+/*=========================================================================
+
+  Copyright (c) Remi Cresson (IRSTEA). All rights reserved.
+
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef __otbConnectedComponentsRunTable_h
+#define __otbConnectedComponentsRunTable_h
+
+#include <algorithm>
+#include <map>
+#include <vector>
+
+namespace otb
+{
+
+/**
+ * \class ConnectedComponentsRunTable
+ * \brief Global connected components of a label image, as runs of pixels
+ *
+ * A run is a horizontal segment of pixels of the same label value. Runs can
+ * be added in any order (e.g. tile by tile, from several threads in
+ * sequence): each new run is merged (union-find) with the touching runs of
+ * the same value in its row and in the rows above and below, so components
+ * spanning several tiles are resolved without any overlap between tiles.
+ *
+ * Runs of two adjacent rows touch when they share a column (4-connectivity),
+ * or a corner (8-connectivity, when m_FullyConnected is true).
+ *
+ * Once all runs are added, Finalize() numbers the components in raster
+ * order (the order of their first pixel), whatever the order of the runs,
+ * and computes their attributes: area, bounding box, and min/mean of the
+ * values (e.g. dNDVI) given with the runs. Attributes are accumulated in
+ * raster order too, so they do not depend on the order of the runs.
+ *
+ * \ingroup ClearCutsDetection
+ */
+template <class TValue>
+class ConnectedComponentsRunTable
+{
+public:
+  typedef TValue        ValueType;
+  typedef long          IndexValueType;
+  typedef unsigned long RunIdType;
+
+  /** A run of pixels, from start to end (included), with the min and sum of its values */
+  struct Run
+  {
+    IndexValueType row;
+    IndexValueType start;
+    IndexValueType end;
+    ValueType      value;
+    double         minValue;
+    double         sumValue;
+  };
+
+  /** Attributes of a component */
+  struct ComponentAttributes
+  {
+    ValueType      label;
+    unsigned long  area;
+    IndexValueType xMin;
+    IndexValueType yMin;
+    IndexValueType xMax;
+    IndexValueType yMax;
+    double         minValue;
+    double         sumValue;
+
+    double GetMeanValue() const { return area > 0 ? sumValue / static_cast<double>(area) : 0.0; }
+  };
+
+  typedef std::vector<RunIdType>                 RunIdListType;
+  typedef std::map<IndexValueType, RunIdListType> RowMapType;
+
+  ConnectedComponentsRunTable() : m_FullyConnected(false) {}
+  ~ConnectedComponentsRunTable() {}
+
+  /** 8-connectivity (true) or 4-connectivity (false, default). Set before adding runs. */
+  void SetFullyConnected(bool flag) { m_FullyConnected = flag; }
+  bool GetFullyConnected() const { return m_FullyConnected; }
+
+  void Clear()
+  {
+    m_Runs.clear();
+    m_Rows.clear();
+    m_Parent.clear();
+    m_ComponentIds.clear();
+    m_Components.clear();
+  }
+
+  /** Add a run, and merge it with the runs it touches */
+  void AddRun(IndexValueType row, IndexValueType start, IndexValueType end, ValueType value,
+      double minValue = 0.0, double sumValue = 0.0)
+  {
+    const RunIdType id = m_Runs.size();
+    Run run = {row, start, end, value, minValue, sumValue};
+    m_Runs.push_back(run);
+    m_Parent.push_back(id);
+
+    // Insert the run in its row, sorted by start
+    RunIdListType & rowRuns = m_Rows[row];
+    typename RunIdListType::iterator it = std::lower_bound(rowRuns.begin(), rowRuns.end(), start,
+        StartLowerThan(m_Runs));
+    it = rowRuns.insert(it, id);
+
+    // Same row: runs ending just before, or starting just after
+    if (it != rowRuns.begin() && m_Runs[*(it - 1)].end + 1 == start && m_Runs[*(it - 1)].value == value)
+      Union(id, *(it - 1));
+    if (it + 1 != rowRuns.end() && m_Runs[*(it + 1)].start == end + 1 && m_Runs[*(it + 1)].value == value)
+      Union(id, *(it + 1));
+
+    // Rows above and below: overlapping runs
+    MergeWithRow(id, row - 1);
+    MergeWithRow(id, row + 1);
+  }
+
+  /** Number the components in raster order, and compute their attributes */
+  void Finalize()
+  {
+    const RunIdType undefined = m_Runs.size();
+    std::vector<RunIdType> rootComponent(m_Runs.size(), undefined);
+    m_ComponentIds.assign(m_Runs.size(), 0);
+    m_Components.clear();
+    for (typename RowMapType::const_iterator rowIt = m_Rows.begin() ; rowIt != m_Rows.end() ; ++rowIt)
+      {
+      for (unsigned int i = 0 ; i < rowIt->second.size() ; i++)
+        {
+        const RunIdType id = rowIt->second[i];
+        const Run & run = m_Runs[id];
+        const RunIdType root = Find(id);
+        if (rootComponent[root] == undefined)
+          {
+          rootComponent[root] = m_Components.size();
+          ComponentAttributes attributes = {run.value, 0, run.start, run.row, run.end, run.row,
+              run.minValue, 0.0};
+          m_Components.push_back(attributes);
+          }
+        m_ComponentIds[id] = rootComponent[root];
+
+        ComponentAttributes & attributes = m_Components[rootComponent[root]];
+        attributes.area += run.end - run.start + 1;
+        attributes.xMin = std::min(attributes.xMin, run.start);
+        attributes.xMax = std::max(attributes.xMax, run.end);
+        attributes.yMax = run.row;
+        attributes.minValue = std::min(attributes.minValue, run.minValue);
+        attributes.sumValue += run.sumValue;
+        }
+      }
+  }
+
+  /** Runs of a row overlapping [start, end], sorted by start */
+  void GetRuns(IndexValueType row, IndexValueType start, IndexValueType end, RunIdListType & runs) const
+  {
+    runs.clear();
+    typename RowMapType::const_iterator rowIt = m_Rows.find(row);
+    if (rowIt == m_Rows.end())
+      return;
+    const RunIdListType & rowRuns = rowIt->second;
+    for (typename RunIdListType::const_iterator it = FirstOverlapping(rowRuns, start) ;
+        it != rowRuns.end() && m_Runs[*it].start <= end ; ++it)
+      {
+      runs.push_back(*it);
+      }
+  }
+
+  const Run & GetRun(RunIdType id) const { return m_Runs[id]; }
+  RunIdType GetNumberOfRuns() const { return m_Runs.size(); }
+
+  /** Runs of each row, sorted by start, rows in ascending order */
+  const RowMapType & GetRows() const { return m_Rows; }
+
+  /** Components (valid after Finalize()) */
+  RunIdType GetComponentId(RunIdType id) const { return m_ComponentIds[id]; }
+  unsigned long GetComponentSize(RunIdType componentId) const { return m_Components[componentId].area; }
+  const ComponentAttributes & GetComponentAttributes(RunIdType componentId) const { return m_Components[componentId]; }
+  unsigned long GetNumberOfComponents() const { return m_Components.size(); }
+
+private:
+
+  /** Compare a run start with a value */
+  class StartLowerThan
+  {
+  public:
+    StartLowerThan(const std::vector<Run> & runs) : m_RunsRef(runs) {}
+    bool operator()(RunIdType id, IndexValueType start) const { return m_RunsRef[id].start < start; }
+  private:
+    const std::vector<Run> & m_RunsRef;
+  };
+
+  /** First run of a row ending at or after start (runs of a row do not overlap) */
+  typename RunIdListType::const_iterator FirstOverlapping(const RunIdListType & rowRuns, IndexValueType start) const
+  {
+    typename RunIdListType::const_iterator it = std::lower_bound(rowRuns.begin(), rowRuns.end(), start,
+        StartLowerThan(m_Runs));
+    if (it != rowRuns.begin() && m_Runs[*(it - 1)].end >= start)
+      --it;
+    return it;
+  }
+
+  void MergeWithRow(RunIdType id, IndexValueType row)
+  {
+    typename RowMapType::const_iterator rowIt = m_Rows.find(row);
+    if (rowIt == m_Rows.end())
+      return;
+    // With 8-connectivity, runs touching by a corner are connected
+    const IndexValueType reach = m_FullyConnected ? 1 : 0;
+    const Run & run = m_Runs[id];
+    const RunIdListType & rowRuns = rowIt->second;
+    for (typename RunIdListType::const_iterator it = FirstOverlapping(rowRuns, run.start - reach) ;
+        it != rowRuns.end() && m_Runs[*it].start <= run.end + reach ; ++it)
+      {
+      if (m_Runs[*it].value == run.value)
+        Union(id, *it);
+      }
+  }
+
+  RunIdType Find(RunIdType id)
+  {
+    while (m_Parent[id] != id)
+      {
+      m_Parent[id] = m_Parent[m_Parent[id]];
+      id = m_Parent[id];
+      }
+    return id;
+  }
+
+  void Union(RunIdType a, RunIdType b)
+  {
+    RunIdType rootA = Find(a);
+    RunIdType rootB = Find(b);
+    if (rootA == rootB)
+      return;
+    if (rootB < rootA)
+      std::swap(rootA, rootB);
+    m_Parent[rootB] = rootA;
+  }
+
+  bool                             m_FullyConnected;
+  std::vector<Run>                 m_Runs;
+  RowMapType                       m_Rows;
+  std::vector<RunIdType>           m_Parent;
+  std::vector<RunIdType>           m_ComponentIds;
+  std::vector<ComponentAttributes> m_Components;
+};
+
+} // namespace otb
+
+#endif
@@ -0,0 +1,109 @@
+/*=========================================================================
+
+  Copyright (c) Remi Cresson (IRSTEA). All rights reserved.
+
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef ConnectedComponentsRunTableToImageFilter_H_
+#define ConnectedComponentsRunTableToImageFilter_H_
+
+#include "itkImageSource.h"
+#include "itkImageRegionIterator.h"
+#include "otbConnectedComponentsRunTable.h"
+
+namespace otb
+{
+
+/**
+ * \class ConnectedComponentsRunTableToImageFilter
+ * \brief Filtered label image from the global connected components
+ *
+ * Pixels of the components having more than m_MinNumberOfComponents pixels
+ * keep their label, other pixels are set to m_NoDataPixel (same output as
+ * ConnectedLabelsImageFilter). When m_OutputComponentIds is true, pixels
+ * are set to (id + 1) of their component instead, which indexes the
+ * components attributes of the run table.
+ *
+ * The image is generated from the run table only: nothing is requested
+ * upstream.
+ *
+ * The output geometry is the one of the reference image (typically, the
+ * label image the run table was computed from).
+ *
+ * \ingroup ClearCutsDetection
+ */
+template <class TImage, class TLabelValue = typename TImage::PixelType>
+class ITK_EXPORT ConnectedComponentsRunTableToImageFilter :
+public itk::ImageSource<TImage>
+{
+
+public:
+
+  /** Standard class typedefs. */
+  typedef ConnectedComponentsRunTableToImageFilter Self;
+  typedef itk::ImageSource<TImage>                 Superclass;
+  typedef itk::SmartPointer<Self>                  Pointer;
+  typedef itk::SmartPointer<const Self>            ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(ConnectedComponentsRunTableToImageFilter, itk::ImageSource);
+
+  /** Image typedefs */
+  typedef TImage                                         ImageType;
+  typedef itk::ImageBase<ImageType::ImageDimension>      ReferenceImageType;
+  typedef typename ImageType::RegionType                 ImageRegionType;
+  typedef typename ImageType::IndexType                  ImageIndexType;
+  typedef typename ImageType::PixelType                  ImagePixelType;
+  typedef typename itk::ImageRegionIterator<TImage>      OutputImageIteratorType;
+  typedef ConnectedComponentsRunTable<TLabelValue>       RunTableType;
+
+  itkSetMacro(NoDataPixel, ImagePixelType);
+  itkGetMacro(NoDataPixel, ImagePixelType);
+
+  itkSetMacro(MinNumberOfComponents, unsigned int);
+  itkGetMacro(MinNumberOfComponents, unsigned int);
+
+  itkSetMacro(OutputComponentIds, bool);
+  itkGetMacro(OutputComponentIds, bool);
+
+  /** Finalized run table */
+  void SetRunTable(const RunTableType * table) { m_RunTable = table; this->Modified(); }
+
+  /** Image giving the output geometry */
+  void SetReferenceImage(const ReferenceImageType * image) { m_ReferenceImage = image; this->Modified(); }
+
+protected:
+  ConnectedComponentsRunTableToImageFilter();
+  virtual ~ConnectedComponentsRunTableToImageFilter() {};
+
+  virtual void GenerateOutputInformation();
+
+  virtual void ThreadedGenerateData(const ImageRegionType& outputRegionForThread,
+      itk::ThreadIdType threadId);
+
+private:
+  ConnectedComponentsRunTableToImageFilter(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+  unsigned int         m_MinNumberOfComponents;
+  ImagePixelType       m_NoDataPixel;
+  bool                 m_OutputComponentIds;
+  const RunTableType * m_RunTable;
+  typename ReferenceImageType::ConstPointer m_ReferenceImage;
+
+};
+
+
+} // end namespace otb
+
+#include "otbConnectedComponentsRunTableToImageFilter.hxx"
+
+
+#endif /* ConnectedComponentsRunTableToImageFilter_H_ */
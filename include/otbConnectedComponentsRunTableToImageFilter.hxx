@@ -0,0 +1,98 @@
+/*=========================================================================
+
+  Copyright (c) Remi Cresson (IRSTEA). All rights reserved.
+
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef __ConnectedComponentsRunTableToImageFilter_hxx
+#define __ConnectedComponentsRunTableToImageFilter_hxx
+
+#include "otbConnectedComponentsRunTableToImageFilter.h"
+#include "itkProgressReporter.h"
+
+namespace otb
+{
+/**
+ *
+ */
+template <class TImage, class TLabelValue>
+ConnectedComponentsRunTableToImageFilter<TImage, TLabelValue>
+::ConnectedComponentsRunTableToImageFilter()
+ {
+  m_MinNumberOfComponents = 5;
+  m_NoDataPixel = 0;
+  m_OutputComponentIds = false;
+  m_RunTable = NULL;
+ }
+
+template <class TImage, class TLabelValue>
+void
+ConnectedComponentsRunTableToImageFilter<TImage, TLabelValue>
+::GenerateOutputInformation()
+ {
+  if (m_ReferenceImage.IsNull())
+    {
+    itkExceptionMacro("No reference image");
+    }
+  this->GetOutput()->CopyInformation(m_ReferenceImage);
+  this->GetOutput()->SetLargestPossibleRegion(m_ReferenceImage->GetLargestPossibleRegion());
+ }
+
+/**
+ *
+ */
+template <class TImage, class TLabelValue>
+void
+ConnectedComponentsRunTableToImageFilter<TImage, TLabelValue>
+::ThreadedGenerateData(const ImageRegionType& outputRegionForThread, itk::ThreadIdType threadId)
+ {
+
+  // Debug info
+  itkDebugMacro(<<"Actually executing thread " << threadId << " in region " << outputRegionForThread);
+
+  if (m_RunTable == NULL)
+    {
+    itkExceptionMacro("No run table");
+    }
+
+  // Support progress methods/callbacks
+  itk::ProgressReporter progress(this, threadId, outputRegionForThread.GetSize(1) );
+
+  ImageType * outputImage = this->GetOutput();
+
+  // No-data everywhere
+  OutputImageIteratorType outputIt(outputImage, outputRegionForThread);
+  for ( outputIt.GoToBegin(); !outputIt.IsAtEnd(); ++outputIt )
+    outputIt.Set(m_NoDataPixel);
+
+  // Then the runs of the large enough components
+  const long xStart = outputRegionForThread.GetIndex(0);
+  const long xEnd = xStart + outputRegionForThread.GetSize(0) - 1;
+  typename RunTableType::RunIdListType runs;
+  for (unsigned int y = 0 ; y < outputRegionForThread.GetSize(1) ; y++)
+    {
+    ImageIndexType index = outputRegionForThread.GetIndex();
+    index[1] += y;
+    m_RunTable->GetRuns(index[1], xStart, xEnd, runs);
+    for (unsigned int i = 0 ; i < runs.size() ; i++)
+      {
+      const unsigned long componentId = m_RunTable->GetComponentId(runs[i]);
+      if (m_RunTable->GetComponentSize(componentId) <= m_MinNumberOfComponents)
+        continue;
+
+      const typename RunTableType::Run & run = m_RunTable->GetRun(runs[i]);
+      const ImagePixelType value = m_OutputComponentIds ?
+          static_cast<ImagePixelType>(componentId + 1) : static_cast<ImagePixelType>(run.value);
+      for (index[0] = std::max(run.start, xStart) ; index[0] <= std::min(run.end, xEnd) ; index[0]++)
+        outputImage->SetPixel(index, value);
+      }
+
+    progress.CompletedPixel();
+    } // Next row
+ }
+}
+#endif
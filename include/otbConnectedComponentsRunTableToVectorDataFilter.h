@@ -0,0 +1,148 @@
+/*=========================================================================
+
+  Copyright (c) Remi Cresson (IRSTEA). All rights reserved.
+
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef ConnectedComponentsRunTableToVectorDataFilter_H_
+#define ConnectedComponentsRunTableToVectorDataFilter_H_
+
+#include "otbVectorDataSource.h"
+#include "otbVectorData.h"
+#include "itkImageBase.h"
+#include "otbConnectedComponentsRunTable.h"
+
+#include <utility>
+#include <vector>
+
+namespace otb
+{
+
+/**
+ * \class ConnectedComponentsRunTableToVectorDataFilter
+ * \brief Polygons of the global connected components, traced from their runs
+ *
+ * The components having more than m_MinNumberOfComponents pixels are
+ * restricted to m_Region (when set), then split in 4-connected polygons
+ * (as GDALPolygonize does on the filtered label image). The boundary of each
+ * polygon is traced on the pixel corners from the runs only: the edges of
+ * a run are its left and right sides, and the parts of its top and bottom
+ * sides that are not covered by the runs of the adjacent rows. At a corner
+ * shared by two diagonal pixels, the boundary turns around the current
+ * pixel, which keeps the polygons 4-connected.
+ *
+ * A 4-connected set of pixels has a single exterior ring; the other rings
+ * are its holes. The rings keep the corner vertices only, and start at
+ * their first corner in raster order (the top left corner of the first
+ * pixel, for the exterior ring); the holes are sorted by this corner. The
+ * polygons are sorted in raster order of their first pixel. The label of
+ * the component is written in the m_FieldName field. Nothing is read from any image: the cost is proportional to the
+ * number of runs, not to the area of the image.
+ *
+ * The geometry is the one of the reference image (typically, the image the
+ * run table was computed from). When the run table was computed from an
+ * extract of the reference image, m_IndexOffset is the index of the
+ * extract in the reference image.
+ *
+ * \ingroup ClearCutsDetection
+ */
+template <class TRunTable, class TVectorData = otb::VectorData<double, 2> >
+class ITK_EXPORT ConnectedComponentsRunTableToVectorDataFilter :
+public VectorDataSource<TVectorData>
+{
+
+public:
+
+  /** Standard class typedefs. */
+  typedef ConnectedComponentsRunTableToVectorDataFilter Self;
+  typedef VectorDataSource<TVectorData>                 Superclass;
+  typedef itk::SmartPointer<Self>                       Pointer;
+  typedef itk::SmartPointer<const Self>                 ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(ConnectedComponentsRunTableToVectorDataFilter, VectorDataSource);
+
+  /** Run table typedefs */
+  typedef TRunTable                                    RunTableType;
+  typedef typename RunTableType::IndexValueType        IndexValueType;
+  typedef typename RunTableType::RunIdType             RunIdType;
+  typedef typename RunTableType::RunIdListType         RunIdListType;
+  typedef typename RunTableType::RowMapType            RowMapType;
+
+  /** Vector data typedefs */
+  typedef TVectorData                                  VectorDataType;
+  typedef typename VectorDataType::DataTreeType        DataTreeType;
+  typedef typename VectorDataType::DataNodeType        DataNodeType;
+  typedef typename DataNodeType::Pointer               DataNodePointerType;
+  typedef typename DataNodeType::PolygonType           PolygonType;
+  typedef typename DataNodeType::PolygonListType       PolygonListType;
+  typedef typename PolygonType::VertexType             VertexType;
+
+  /** Image typedefs */
+  typedef itk::ImageBase<2>                            ReferenceImageType;
+  typedef ReferenceImageType::RegionType               RegionType;
+  typedef ReferenceImageType::IndexType                IndexType;
+
+  /** A vertex on the pixel corners, and a ring */
+  typedef std::pair<IndexValueType, IndexValueType>    CornerType;
+  typedef std::vector<CornerType>                      RingType;
+
+  itkSetMacro(MinNumberOfComponents, unsigned int);
+  itkGetMacro(MinNumberOfComponents, unsigned int);
+
+  itkSetStringMacro(FieldName);
+  itkGetStringMacro(FieldName);
+
+  /** Region of the polygons (the whole table if empty) */
+  itkSetMacro(Region, RegionType);
+  itkGetMacro(Region, RegionType);
+
+  /** Index of the first pixel of the run table in the reference image */
+  itkSetMacro(IndexOffset, IndexType);
+  itkGetMacro(IndexOffset, IndexType);
+
+  /** Finalized run table */
+  void SetRunTable(const RunTableType * table) { m_RunTable = table; this->Modified(); }
+
+  /** Image giving the output geometry */
+  void SetReferenceImage(const ReferenceImageType * image) { m_ReferenceImage = image; this->Modified(); }
+
+protected:
+  ConnectedComponentsRunTableToVectorDataFilter();
+  virtual ~ConnectedComponentsRunTableToVectorDataFilter() {};
+
+  /** Rings of a 4-connected polygon, from its runs in raster order */
+  void TraceRings(const RunTableType & table, const RunIdListType & runIds, std::vector<RingType> & rings) const;
+
+  /** Ring in the reference image geometry */
+  typename PolygonType::Pointer CreatePolygon(const RingType & ring) const;
+
+  virtual void GenerateData();
+
+private:
+  ConnectedComponentsRunTableToVectorDataFilter(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+  unsigned int         m_MinNumberOfComponents;
+  std::string          m_FieldName;
+  RegionType           m_Region;
+  IndexType            m_IndexOffset;
+  const RunTableType * m_RunTable;
+  ReferenceImageType::ConstPointer m_ReferenceImage;
+
+};
+
+
+} // end namespace otb
+
+#include "otbConnectedComponentsRunTableToVectorDataFilter.hxx"
+
+
+#endif /* ConnectedComponentsRunTableToVectorDataFilter_H_ */
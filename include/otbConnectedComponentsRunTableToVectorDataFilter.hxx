@@ -0,0 +1,316 @@
+/*=========================================================================
+
+  Copyright (c) Remi Cresson (IRSTEA). All rights reserved.
+
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef __ConnectedComponentsRunTableToVectorDataFilter_hxx
+#define __ConnectedComponentsRunTableToVectorDataFilter_hxx
+
+#include "otbConnectedComponentsRunTableToVectorDataFilter.h"
+#include "otbMetaDataKey.h"
+#include "itkMetaDataObject.h"
+#include "itkContinuousIndex.h"
+
+#include <algorithm>
+
+namespace otb
+{
+/**
+ *
+ */
+template <class TRunTable, class TVectorData>
+ConnectedComponentsRunTableToVectorDataFilter<TRunTable, TVectorData>
+::ConnectedComponentsRunTableToVectorDataFilter()
+ {
+  m_MinNumberOfComponents = 5;
+  m_FieldName = "DN";
+  m_RunTable = NULL;
+  m_IndexOffset.Fill(0);
+ }
+
+/*
+ * Parts of [start, end] not covered by the (sorted) intervals, starting the
+ * search at the interval pos
+ */
+template <class TIntervalList>
+static void GetUncoveredIntervals(long start, long end, const TIntervalList * intervals,
+    unsigned int & pos, TIntervalList & uncovered)
+{
+  uncovered.clear();
+  long x = start;
+  if (intervals != NULL)
+    {
+    while (pos < intervals->size() && (*intervals)[pos].second < start)
+      pos++;
+    for (unsigned int i = pos ; i < intervals->size() && (*intervals)[i].first <= end ; i++)
+      {
+      if (x < (*intervals)[i].first)
+        uncovered.push_back(std::make_pair(x, (*intervals)[i].first - 1));
+      x = std::max(x, (*intervals)[i].second + 1);
+      }
+    }
+  if (x <= end)
+    uncovered.push_back(std::make_pair(x, end));
+}
+
+/*
+ * Raster order of the pixel corners (x, y): by row, then by column
+ */
+template <class TCorner>
+static bool CornerRasterLowerThan(const TCorner & a, const TCorner & b)
+{
+  return a.second < b.second || (a.second == b.second && a.first < b.first);
+}
+
+/*
+ * Raster order of the rings, by their first corner
+ */
+template <class TRing>
+static bool RingRasterLowerThan(const TRing & a, const TRing & b)
+{
+  return CornerRasterLowerThan(a.front(), b.front());
+}
+
+template <class TRunTable, class TVectorData>
+void
+ConnectedComponentsRunTableToVectorDataFilter<TRunTable, TVectorData>
+::TraceRings(const RunTableType & table, const RunIdListType & runIds, std::vector<RingType> & rings) const
+ {
+  typedef std::pair<IndexValueType, IndexValueType> IntervalType;
+  typedef std::vector<IntervalType>                 IntervalListType;
+  typedef std::pair<CornerType, CornerType>         EdgeType;
+
+  // Runs merged in intervals, row by row
+  std::vector<IndexValueType> rows;
+  std::vector<IntervalListType> intervals;
+  for (unsigned int i = 0 ; i < runIds.size() ; i++)
+    {
+    const typename RunTableType::Run & run = table.GetRun(runIds[i]);
+    if (rows.empty() || rows.back() != run.row)
+      {
+      rows.push_back(run.row);
+      intervals.push_back(IntervalListType());
+      }
+    IntervalListType & rowIntervals = intervals.back();
+    if (!rowIntervals.empty() && rowIntervals.back().second + 1 == run.start)
+      rowIntervals.back().second = run.end;
+    else
+      rowIntervals.push_back(std::make_pair(run.start, run.end));
+    }
+
+  // Boundary edges, with the polygon on their right (y axis downwards)
+  std::vector<EdgeType> edges;
+  IntervalListType uncovered;
+  for (unsigned int k = 0 ; k < rows.size() ; k++)
+    {
+    const IndexValueType row = rows[k];
+    const IntervalListType * above = (k > 0 && rows[k - 1] == row - 1) ? &intervals[k - 1] : NULL;
+    const IntervalListType * below = (k + 1 < rows.size() && rows[k + 1] == row + 1) ? &intervals[k + 1] : NULL;
+    unsigned int abovePos = 0;
+    unsigned int belowPos = 0;
+    for (unsigned int i = 0 ; i < intervals[k].size() ; i++)
+      {
+      const IndexValueType start = intervals[k][i].first;
+      const IndexValueType end = intervals[k][i].second;
+
+      // Top: eastwards
+      GetUncoveredIntervals(start, end, above, abovePos, uncovered);
+      for (unsigned int j = 0 ; j < uncovered.size() ; j++)
+        edges.push_back(EdgeType(CornerType(uncovered[j].first, row), CornerType(uncovered[j].second + 1, row)));
+
+      // Bottom: westwards
+      GetUncoveredIntervals(start, end, below, belowPos, uncovered);
+      for (unsigned int j = 0 ; j < uncovered.size() ; j++)
+        edges.push_back(EdgeType(CornerType(uncovered[j].second + 1, row + 1), CornerType(uncovered[j].first, row + 1)));
+
+      // Left: northwards, right: southwards
+      edges.push_back(EdgeType(CornerType(start, row + 1), CornerType(start, row)));
+      edges.push_back(EdgeType(CornerType(end + 1, row), CornerType(end + 1, row + 1)));
+      }
+    }
+
+  // Edges sorted by their first corner
+  std::vector<std::pair<CornerType, unsigned int> > starts(edges.size());
+  for (unsigned int i = 0 ; i < edges.size() ; i++)
+    starts[i] = std::make_pair(edges[i].first, i);
+  std::sort(starts.begin(), starts.end());
+
+  // Chain the edges in rings
+  rings.clear();
+  std::vector<bool> used(edges.size(), false);
+  std::vector<unsigned int> ringEdges;
+  for (unsigned int first = 0 ; first < edges.size() ; first++)
+    {
+    if (used[first])
+      continue;
+
+    ringEdges.clear();
+    unsigned int current = first;
+    while (!used[current])
+      {
+      used[current] = true;
+      ringEdges.push_back(current);
+
+      const CornerType & from = edges[current].first;
+      const CornerType & to = edges[current].second;
+      const IndexValueType dx = (to.first > from.first) - (to.first < from.first);
+      const IndexValueType dy = (to.second > from.second) - (to.second < from.second);
+
+      // Next edge: at a corner shared by two diagonal pixels, turn right
+      typename std::vector<std::pair<CornerType, unsigned int> >::const_iterator it = std::lower_bound(
+          starts.begin(), starts.end(), std::make_pair(to, 0u));
+      current = it->second;
+      for ( ; it != starts.end() && it->first == to ; ++it)
+        {
+        const CornerType & next = edges[it->second].second;
+        if ((next.first - to.first > 0) - (next.first - to.first < 0) == -dy &&
+            (next.second - to.second > 0) - (next.second - to.second < 0) == dx)
+          current = it->second;
+        }
+      }
+
+    // Vertices where the direction changes
+    RingType ring;
+    for (unsigned int i = 0 ; i < ringEdges.size() ; i++)
+      {
+      const EdgeType & edge = edges[ringEdges[i]];
+      const EdgeType & previous = edges[ringEdges[(i + ringEdges.size() - 1) % ringEdges.size()]];
+      const bool horizontal = (edge.first.second == edge.second.second);
+      const bool previousHorizontal = (previous.first.second == previous.second.second);
+      if (horizontal != previousHorizontal)
+        ring.push_back(edge.first);
+      }
+
+    // Start at the first corner in raster order
+    std::rotate(ring.begin(), std::min_element(ring.begin(), ring.end(),
+        CornerRasterLowerThan<CornerType>), ring.end());
+    rings.push_back(ring);
+    }
+  std::sort(rings.begin(), rings.end(), RingRasterLowerThan<RingType>);
+ }
+
+template <class TRunTable, class TVectorData>
+typename ConnectedComponentsRunTableToVectorDataFilter<TRunTable, TVectorData>::PolygonType::Pointer
+ConnectedComponentsRunTableToVectorDataFilter<TRunTable, TVectorData>
+::CreatePolygon(const RingType & ring) const
+ {
+  typename PolygonType::Pointer polygon = PolygonType::New();
+  for (unsigned int i = 0 ; i <= ring.size() ; i++)
+    {
+    // Pixel corners are half a pixel away from the pixel centers
+    const CornerType & corner = ring[i % ring.size()];
+    itk::ContinuousIndex<double, 2> index;
+    index[0] = corner.first + m_IndexOffset[0] - 0.5;
+    index[1] = corner.second + m_IndexOffset[1] - 0.5;
+    typename ReferenceImageType::PointType point;
+    m_ReferenceImage->TransformContinuousIndexToPhysicalPoint(index, point);
+
+    VertexType vertex;
+    vertex[0] = point[0];
+    vertex[1] = point[1];
+    polygon->AddVertex(vertex);
+    }
+  return polygon;
+ }
+
+/**
+ *
+ */
+template <class TRunTable, class TVectorData>
+void
+ConnectedComponentsRunTableToVectorDataFilter<TRunTable, TVectorData>
+::GenerateData()
+ {
+  if (m_RunTable == NULL)
+    {
+    itkExceptionMacro("No run table");
+    }
+  if (m_ReferenceImage.IsNull())
+    {
+    itkExceptionMacro("No reference image");
+    }
+
+  // Runs of the components large enough, in the region, as 4-connected polygons
+  const bool restrict = (m_Region.GetNumberOfPixels() > 0);
+  const IndexValueType x0 = m_Region.GetIndex(0);
+  const IndexValueType x1 = x0 + static_cast<IndexValueType>(m_Region.GetSize(0)) - 1;
+  const IndexValueType y0 = m_Region.GetIndex(1);
+  const IndexValueType y1 = y0 + static_cast<IndexValueType>(m_Region.GetSize(1)) - 1;
+  RunTableType polygonsTable;
+  const RowMapType & rows = m_RunTable->GetRows();
+  for (typename RowMapType::const_iterator rowIt = rows.begin() ; rowIt != rows.end() ; ++rowIt)
+    {
+    if (restrict && (rowIt->first < y0 || rowIt->first > y1))
+      continue;
+    for (unsigned int i = 0 ; i < rowIt->second.size() ; i++)
+      {
+      const RunIdType id = rowIt->second[i];
+      if (m_RunTable->GetComponentSize(m_RunTable->GetComponentId(id)) <= m_MinNumberOfComponents)
+        continue;
+      const typename RunTableType::Run & run = m_RunTable->GetRun(id);
+      const IndexValueType start = restrict ? std::max(run.start, x0) : run.start;
+      const IndexValueType end = restrict ? std::min(run.end, x1) : run.end;
+      if (start <= end)
+        polygonsTable.AddRun(run.row, start, end, run.value);
+      }
+    }
+  polygonsTable.Finalize();
+
+  // Runs of each polygon, in raster order
+  std::vector<RunIdListType> polygonsRuns(polygonsTable.GetNumberOfComponents());
+  const RowMapType & polygonsRows = polygonsTable.GetRows();
+  for (typename RowMapType::const_iterator rowIt = polygonsRows.begin() ; rowIt != polygonsRows.end() ; ++rowIt)
+    for (unsigned int i = 0 ; i < rowIt->second.size() ; i++)
+      polygonsRuns[polygonsTable.GetComponentId(rowIt->second[i])].push_back(rowIt->second[i]);
+
+  // Output tree
+  VectorDataType * output = this->GetOutput();
+  std::string projectionRef;
+  itk::ExposeMetaData<std::string>(m_ReferenceImage->GetMetaDataDictionary(),
+      MetaDataKey::ProjectionRefKey, projectionRef);
+  output->SetProjectionRef(projectionRef);
+
+  typename DataTreeType::Pointer tree = output->GetDataTree();
+  DataNodePointerType root = tree->GetRoot()->Get();
+  DataNodePointerType document = DataNodeType::New();
+  document->SetNodeType(DOCUMENT);
+  tree->Add(document, root);
+  DataNodePointerType folder = DataNodeType::New();
+  folder->SetNodeType(FOLDER);
+  tree->Add(folder, document);
+
+  std::vector<RingType> rings;
+  for (unsigned int id = 0 ; id < polygonsRuns.size() ; id++)
+    {
+    TraceRings(polygonsTable, polygonsRuns[id], rings);
+
+    // The exterior ring is clockwise (y axis downwards), holes are counterclockwise
+    DataNodePointerType node = DataNodeType::New();
+    node->SetNodeType(FEATURE_POLYGON);
+    typename PolygonListType::Pointer holes = PolygonListType::New();
+    for (unsigned int r = 0 ; r < rings.size() ; r++)
+      {
+      double area = 0.0;
+      for (unsigned int i = 0 ; i < rings[r].size() ; i++)
+        {
+        const CornerType & a = rings[r][i];
+        const CornerType & b = rings[r][(i + 1) % rings[r].size()];
+        area += static_cast<double>(a.first) * b.second - static_cast<double>(b.first) * a.second;
+        }
+      if (area > 0)
+        node->SetPolygonExteriorRing(CreatePolygon(rings[r]));
+      else
+        holes->PushBack(CreatePolygon(rings[r]));
+      }
+    node->SetPolygonInteriorRings(holes);
+    node->SetFieldAsInt(m_FieldName, static_cast<int>(polygonsTable.GetComponentAttributes(id).label));
+    tree->Add(node, folder);
+    }
+ }
+}
+#endif
@@ -28,6 +28,10 @@ namespace otb
  * \class ConnectedLabelsImageFilter
  * \brief Filter an input image label
  *
+ * Pixels of the connected components (4-connectivity, or 8-connectivity
+ * when m_FullyConnected is true) having at most m_MinNumberOfComponents
+ * pixels are set to m_NoDataPixel.
+ *
  * Output: Filtered label image
  *
  * \ingroup ClearCutsDetection
@@ -69,6 +73,10 @@ public:
   itkSetMacro(MinNumberOfComponents, unsigned int);
   itkGetMacro(MinNumberOfComponents, unsigned int);
 
+  itkSetMacro(FullyConnected, bool);
+  itkGetMacro(FullyConnected, bool);
+  itkBooleanMacro(FullyConnected);
+
 protected:
   ConnectedLabelsImageFilter();
   virtual ~ConnectedLabelsImageFilter() {};
@@ -88,6 +96,7 @@ private:
 
   unsigned int    m_MinNumberOfComponents;
   ImagePixelType  m_NoDataPixel;
+  bool            m_FullyConnected;
 
 };
 
@@ -25,6 +25,7 @@ ConnectedLabelsImageFilter<TImage>
  {
   m_MinNumberOfComponents = 5;
   m_NoDataPixel = 0;
+  m_FullyConnected = false;
 
  }
 
@@ -58,6 +59,11 @@ ConnectedLabelsImageFilter<TImage>
   // Grab input image
   const ImageType * inputImage = const_cast<ImageType *>(this->GetInput());
 
+  // Neighbors offsets: 4-connectivity first, then the diagonals
+  static const long offsets[8][2] = {{0, 1}, {0, -1}, {1, 0}, {-1, 0},
+      {1, 1}, {1, -1}, {-1, 1}, {-1, -1}};
+  const unsigned int nbOfNeighbors = m_FullyConnected ? 8 : 4;
+
   // Loop over pixels in the list
   for (unsigned int i = 0 ; i < indexList.size() ; i++)
     {
@@ -67,21 +73,12 @@ ConnectedLabelsImageFilter<TImage>
       // Get current index
       ImageIndexType currentIndex = indexList[i];
 
-      // Build neighborhood index list of this pixel
-      ImageIndexListType relativeNeighborhood;
-      ImageIndexType north = {currentIndex[0], currentIndex[1]+1};
-      relativeNeighborhood.push_back(north);
-      ImageIndexType south = {currentIndex[0],currentIndex[1]-1};
-      relativeNeighborhood.push_back(south);
-      ImageIndexType east  = {currentIndex[0]+1,currentIndex[1]};
-      relativeNeighborhood.push_back(east);
-      ImageIndexType west = {currentIndex[0]-1,currentIndex[1]};
-      relativeNeighborhood.push_back(west);
-
-      // Check the validity of these neighbors
-      for (unsigned int k = 0 ; k < 4 ; k++)
+      // Check the validity of the neighbors of this pixel
+      for (unsigned int k = 0 ; k < nbOfNeighbors ; k++)
         {
-        ImageIndexType neighbor = relativeNeighborhood[k];
+        ImageIndexType neighbor = currentIndex;
+        neighbor[0] += offsets[k][0];
+        neighbor[1] += offsets[k][1];
 
         // Does the neighbor lean inside the image?
         if (inputImage->GetLargestPossibleRegion().IsInside(neighbor))
@@ -29,7 +29,8 @@ template< class TPixel, class TOutputValue>
 class DeltaNDVIFromChannels
 {
 public:
-  DeltaNDVIFromChannels() {noData=3.0; nirChannelT0=0; nirChannelT1=0; redChannelT0=0; redChannelT1=0;}
+  DeltaNDVIFromChannels() {noData=3.0; nirChannelT0=0; nirChannelT1=0; redChannelT0=0; redChannelT1=0;
+    qaChannelT0=0; qaChannelT1=0; qaMask=0; qaClasses=false;}
   ~DeltaNDVIFromChannels() {}
   bool operator!=(const DeltaNDVIFromChannels &) const{
     return false;
@@ -42,6 +43,10 @@ public:
   inline TOutputValue operator()(const TPixel & T0,
       const TPixel & T1) const
   {
+    if (!IsValid(T0, qaChannelT0) || !IsValid(T1, qaChannelT1))
+      {
+        return static_cast< TOutputValue >( noData );
+      }
     double nir_t0 = static_cast< double >( T0[nirChannelT0]);
     double nir_t1 = static_cast< double >( T1[nirChannelT1]);
     double red_t0 = static_cast< double >( T0[redChannelT0]);
@@ -70,12 +75,33 @@ public:
   unsigned int GetNIRChannelT1() {return nirChannelT1 ;}
   unsigned int GetRedChannelT1() {return redChannelT1 ;}
 
+  /* Quality bands (0: no quality band). A pixel is not valid when its
+   * quality value has a bit in common with the mask. With classes (e.g.
+   * Sentinel-2 SCL), the class c is tested as the bit (1 << c). */
+  void SetQAChannelT0(unsigned int number) {qaChannelT0 = number;}
+  void SetQAChannelT1(unsigned int number) {qaChannelT1 = number;}
+  void SetQAMask(unsigned int mask) {qaMask = mask;}
+  void SetQAClasses(bool classes) {qaClasses = classes;}
+
+  inline bool IsValid(const TPixel & pixel, unsigned int qaChannel) const
+  {
+    if (qaChannel == 0)
+      return true;
+    const unsigned int qa = static_cast< unsigned int >( pixel[qaChannel - 1] );
+    const unsigned int bits = qaClasses ? (qa < 32 ? 1u << qa : 0u) : qa;
+    return (bits & qaMask) == 0;
+  }
+
 
 private:
   unsigned int nirChannelT0;
   unsigned int redChannelT0;
   unsigned int nirChannelT1;
   unsigned int redChannelT1;
+  unsigned int qaChannelT0;
+  unsigned int qaChannelT1;
+  unsigned int qaMask;
+  bool qaClasses;
   double noData;
 
 };
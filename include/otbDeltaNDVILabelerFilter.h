@@ -94,8 +94,8 @@ public:
 	/** Threshold Getters/Setters */
 	itkGetMacro(NumberOfClasses, unsigned int);
 	itkSetMacro(NumberOfClasses, unsigned int);
-	itkGetMacro(FirstClassStart, int);
-	itkSetMacro(FirstClassStart, int);
+	itkGetMacro(FirstClassStart, double);
+	itkSetMacro(FirstClassStart, double);
 	itkGetMacro(FirstClassValue, LabelImagePixelType);
 	itkSetMacro(FirstClassValue, LabelImagePixelType);
 
@@ -130,7 +130,7 @@ private:
 
 	// Classes parameters
 	unsigned int m_NumberOfClasses;
-	int m_FirstClassStart;
+	double m_FirstClassStart;
 	LabelImagePixelType m_FirstClassValue;
 
 	vnl_vector<NDVIImagePixelType> inputThresholds;
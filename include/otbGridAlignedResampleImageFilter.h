@@ -0,0 +1,114 @@
+/*=========================================================================
+
+  Copyright (c) Remi Cresson (IRSTEA). All rights reserved.
+
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef GridAlignedResampleImageFilter_H_
+#define GridAlignedResampleImageFilter_H_
+
+#include "itkImageToImageFilter.h"
+
+#include <vector>
+
+namespace otb
+{
+
+/**
+ * \class GridAlignedResampleImageFilter
+ * \brief Nearest neighbor resampling between two grids of the same CRS
+ *
+ * When the input and output grids share the same projection (and are both
+ * north up), the nearest input pixel of an output pixel only depends on its
+ * column for x, and on its row for y. The filter computes, for the
+ * requested region, the table of the source column of each output column
+ * and the table of the source row of each output row, then gathers the
+ * pixels from the input buffer: no transform nor interpolator is called
+ * per pixel.
+ *
+ * Source indices are rounded like itk::NearestNeighborInterpolateImageFunction
+ * (half integers up). Output pixels outside the input are set to zero, like
+ * otb::StreamingResampleImageFilter.
+ *
+ * \ingroup ClearCutsDetection
+ */
+template <class TImage>
+class ITK_EXPORT GridAlignedResampleImageFilter :
+public itk::ImageToImageFilter<TImage, TImage>
+{
+
+public:
+
+  /** Standard class typedefs. */
+  typedef GridAlignedResampleImageFilter          Self;
+  typedef itk::ImageToImageFilter<TImage, TImage> Superclass;
+  typedef itk::SmartPointer<Self>                 Pointer;
+  typedef itk::SmartPointer<const Self>           ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(GridAlignedResampleImageFilter, itk::ImageToImageFilter);
+
+  /** Image typedefs */
+  typedef TImage                                  ImageType;
+  typedef typename ImageType::RegionType          ImageRegionType;
+  typedef typename ImageType::IndexType           ImageIndexType;
+  typedef typename ImageType::SizeType            ImageSizeType;
+  typedef typename ImageType::PointType           ImagePointType;
+  typedef typename ImageType::SpacingType         ImageSpacingType;
+  typedef typename ImageType::InternalPixelType   InternalPixelType;
+  typedef typename ImageIndexType::IndexValueType IndexValueType;
+  typedef std::vector<IndexValueType>             IndexTableType;
+
+  /** Output grid */
+  itkSetMacro(OutputOrigin, ImagePointType);
+  itkGetMacro(OutputOrigin, ImagePointType);
+  itkSetMacro(OutputSpacing, ImageSpacingType);
+  itkGetMacro(OutputSpacing, ImageSpacingType);
+  itkSetMacro(OutputSize, ImageSizeType);
+  itkGetMacro(OutputSize, ImageSizeType);
+
+protected:
+  GridAlignedResampleImageFilter();
+  virtual ~GridAlignedResampleImageFilter() {};
+
+  /** Source index of each output index of [start, start + size[ along dim
+   * (a value out of the input largest region means no source) */
+  void ComputeIndexTable(unsigned int dim, IndexValueType start, unsigned long size,
+      IndexTableType & table) const;
+
+  virtual void GenerateOutputInformation();
+
+  virtual void GenerateInputRequestedRegion();
+
+  virtual void ThreadedGenerateData(const ImageRegionType& outputRegionForThread,
+      itk::ThreadIdType threadId);
+
+private:
+  GridAlignedResampleImageFilter(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+  ImagePointType   m_OutputOrigin;
+  ImageSpacingType m_OutputSpacing;
+  ImageSizeType    m_OutputSize;
+
+  // Index tables of the requested region
+  ImageRegionType  m_TablesRegion;
+  IndexTableType   m_ColumnTable;
+  IndexTableType   m_RowTable;
+
+};
+
+
+} // end namespace otb
+
+#include "otbGridAlignedResampleImageFilter.hxx"
+
+
+#endif /* GridAlignedResampleImageFilter_H_ */
@@ -0,0 +1,181 @@
+/*=========================================================================
+
+  Copyright (c) Remi Cresson (IRSTEA). All rights reserved.
+
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef __GridAlignedResampleImageFilter_hxx
+#define __GridAlignedResampleImageFilter_hxx
+
+#include "otbGridAlignedResampleImageFilter.h"
+#include "itkProgressReporter.h"
+#include "itkMath.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace otb
+{
+/**
+ *
+ */
+template <class TImage>
+GridAlignedResampleImageFilter<TImage>
+::GridAlignedResampleImageFilter()
+ {
+  m_OutputOrigin.Fill(0.0);
+  m_OutputSpacing.Fill(1.0);
+  m_OutputSize.Fill(0);
+ }
+
+template <class TImage>
+void
+GridAlignedResampleImageFilter<TImage>
+::ComputeIndexTable(unsigned int dim, IndexValueType start, unsigned long size, IndexTableType & table) const
+ {
+  const ImageType * inputImage = this->GetInput();
+  const double inputOrigin = inputImage->GetOrigin()[dim];
+  const double inputSpacing = inputImage->GetSignedSpacing()[dim];
+
+  table.resize(size);
+  for (unsigned long i = 0 ; i < size ; i++)
+    {
+    const double point = m_OutputOrigin[dim] + static_cast<double>(start + i) * m_OutputSpacing[dim];
+    table[i] = itk::Math::RoundHalfIntegerUp<IndexValueType>((point - inputOrigin) / inputSpacing);
+    }
+ }
+
+template <class TImage>
+void
+GridAlignedResampleImageFilter<TImage>
+::GenerateOutputInformation()
+ {
+  Superclass::GenerateOutputInformation();
+
+  ImageType * outputImage = this->GetOutput();
+  ImageRegionType largestRegion;
+  largestRegion.SetSize(m_OutputSize);
+  outputImage->SetLargestPossibleRegion(largestRegion);
+  outputImage->SetOrigin(m_OutputOrigin);
+  outputImage->SetSignedSpacing(m_OutputSpacing);
+ }
+
+/*
+ * Compute the index tables of the requested region, and request the input
+ * pixels they point to
+ */
+template <class TImage>
+void
+GridAlignedResampleImageFilter<TImage>
+::GenerateInputRequestedRegion()
+ {
+  const ImageRegionType outRegion = this->GetOutput()->GetRequestedRegion();
+  ImageType * inputImage = static_cast<ImageType * >(
+      Superclass::ProcessObject::GetInput(0) );
+  const ImageRegionType inputLargestRegion = inputImage->GetLargestPossibleRegion();
+
+  m_TablesRegion = outRegion;
+  ComputeIndexTable(0, outRegion.GetIndex(0), outRegion.GetSize(0), m_ColumnTable);
+  ComputeIndexTable(1, outRegion.GetIndex(1), outRegion.GetSize(1), m_RowTable);
+
+  // Bounding box of the source indices (tables are monotonic)
+  ImageRegionType inRegion;
+  for (unsigned int dim = 0 ; dim < 2 ; dim++)
+    {
+    const IndexTableType & table = (dim == 0) ? m_ColumnTable : m_RowTable;
+    const IndexValueType lower = std::min(table.front(), table.back());
+    const IndexValueType upper = std::max(table.front(), table.back());
+    inRegion.SetIndex(dim, lower);
+    inRegion.SetSize(dim, upper - lower + 1);
+    }
+
+  if (!inRegion.Crop(inputLargestRegion))
+    {
+    // No source pixel: request a single pixel
+    inRegion.SetIndex(inputLargestRegion.GetIndex());
+    inRegion.SetSize(0, 1);
+    inRegion.SetSize(1, 1);
+    }
+  inputImage->SetRequestedRegion(inRegion);
+ }
+
+/**
+ *
+ */
+template <class TImage>
+void
+GridAlignedResampleImageFilter<TImage>
+::ThreadedGenerateData(const ImageRegionType& outputRegionForThread, itk::ThreadIdType threadId)
+ {
+
+  // Debug info
+  itkDebugMacro(<<"Actually executing thread " << threadId << " in region " << outputRegionForThread);
+
+  // Support progress methods/callbacks
+  itk::ProgressReporter progress(this, threadId, outputRegionForThread.GetSize(1) );
+
+  const ImageType * inputImage = this->GetInput();
+  ImageType * outputImage = this->GetOutput();
+  const unsigned int nbOfComponents = outputImage->GetNumberOfComponentsPerPixel();
+  const ImageRegionType inputRegion = inputImage->GetBufferedRegion();
+  const ImageRegionType inputLargestRegion = inputImage->GetLargestPossibleRegion();
+  const InternalPixelType * inputBuffer = inputImage->GetBufferPointer();
+
+  // Input buffer offset of each output column (-1 outside the input)
+  const unsigned long width = outputRegionForThread.GetSize(0);
+  const IndexValueType columnOffset = outputRegionForThread.GetIndex(0) - m_TablesRegion.GetIndex(0);
+  std::vector<long> inputColumnOffsets(width);
+  for (unsigned long x = 0 ; x < width ; x++)
+    {
+    const IndexValueType sourceColumn = m_ColumnTable[columnOffset + x];
+    if (sourceColumn < inputLargestRegion.GetIndex(0) ||
+        sourceColumn >= inputLargestRegion.GetIndex(0) + static_cast<IndexValueType>(inputLargestRegion.GetSize(0)))
+      inputColumnOffsets[x] = -1;
+    else
+      inputColumnOffsets[x] = (sourceColumn - inputRegion.GetIndex(0)) * nbOfComponents;
+    }
+
+  const IndexValueType rowOffset = outputRegionForThread.GetIndex(1) - m_TablesRegion.GetIndex(1);
+  for (unsigned long y = 0 ; y < outputRegionForThread.GetSize(1) ; y++)
+    {
+    ImageIndexType outputIndex = outputRegionForThread.GetIndex();
+    outputIndex[1] += y;
+    InternalPixelType * outputPtr = outputImage->GetBufferPointer()
+        + outputImage->ComputeOffset(outputIndex) * nbOfComponents;
+
+    const IndexValueType sourceRow = m_RowTable[rowOffset + y];
+    if (sourceRow < inputLargestRegion.GetIndex(1) ||
+        sourceRow >= inputLargestRegion.GetIndex(1) + static_cast<IndexValueType>(inputLargestRegion.GetSize(1)))
+      {
+      // Whole row outside the input
+      for (unsigned long k = 0 ; k < width * nbOfComponents ; k++)
+        outputPtr[k] = itk::NumericTraits<InternalPixelType>::Zero;
+      }
+    else
+      {
+      // Gather
+      const InternalPixelType * inputRowPtr = inputBuffer
+          + (sourceRow - inputRegion.GetIndex(1)) * inputRegion.GetSize(0) * nbOfComponents;
+      for (unsigned long x = 0 ; x < width ; x++, outputPtr += nbOfComponents)
+        {
+        if (inputColumnOffsets[x] < 0)
+          {
+          for (unsigned int band = 0 ; band < nbOfComponents ; band++)
+            outputPtr[band] = itk::NumericTraits<InternalPixelType>::Zero;
+          }
+        else
+          {
+          std::memcpy(outputPtr, inputRowPtr + inputColumnOffsets[x], nbOfComponents * sizeof(InternalPixelType));
+          }
+        }
+      }
+
+    progress.CompletedPixel();
+    } // Next row
+ }
+}
+#endif
@@ -0,0 +1,197 @@
+/*=========================================================================
+
+  Copyright (c) Remi Cresson (IRSTEA). All rights reserved.
+
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef __otbMappedRasterFile_h
+#define __otbMappedRasterFile_h
+
+#include "itkMacro.h"
+
+#include <cstring>
+#include <string>
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace otb
+{
+
+/**
+ * \class MappedRasterFile
+ * \brief Native raster format of the intermediate rasters (".ccr" files)
+ *
+ * The file starts with a fixed header, followed by the projection (WKT),
+ * then the pixels, uncompressed, pixel interleaved, row by row. The pixels
+ * start at a multiple of 64 kB, so they are aligned on the memory pages
+ * whatever the page size: once the file is mapped, any band of full rows
+ * is a valid image buffer.
+ *
+ * Pixels are stored in the native byte order.
+ *
+ * \ingroup ClearCutsDetection
+ */
+class MappedRasterFile
+{
+public:
+
+  /** Alignment of the pixels in the file */
+  static const uint64_t DataAlignment = 65536;
+
+  struct Header
+  {
+    char     magic[8];
+    uint32_t componentType;     // itk::ImageIOBase::IOComponentType
+    uint32_t componentSize;     // bytes
+    uint32_t nbOfComponents;    // bands
+    uint32_t reserved;
+    uint64_t width;
+    uint64_t height;
+    double   origin[2];         // center of the first pixel
+    double   spacing[2];
+    uint64_t projectionSize;
+    uint64_t dataOffset;
+  };
+
+  MappedRasterFile() : m_Data(NULL), m_MappedSize(0), m_Shared(false) { std::memset(&m_Header, 0, sizeof(Header)); }
+  ~MappedRasterFile() { Unmap(); }
+
+  /** Fill the header, and compute the offset of the pixels */
+  void SetHeader(uint32_t componentType, uint32_t componentSize, uint32_t nbOfComponents,
+      uint64_t width, uint64_t height, const double origin[2], const double spacing[2],
+      const std::string & projection)
+  {
+    std::memset(&m_Header, 0, sizeof(Header));
+    std::memcpy(m_Header.magic, "OTBCCR1", 8);
+    m_Header.componentType = componentType;
+    m_Header.componentSize = componentSize;
+    m_Header.nbOfComponents = nbOfComponents;
+    m_Header.width = width;
+    m_Header.height = height;
+    for (unsigned int dim = 0 ; dim < 2 ; dim++)
+      {
+      m_Header.origin[dim] = origin[dim];
+      m_Header.spacing[dim] = spacing[dim];
+      }
+    m_Header.projectionSize = projection.size();
+    m_Header.dataOffset = DataAlignment * ((sizeof(Header) + projection.size() + DataAlignment - 1) / DataAlignment);
+    m_Projection = projection;
+  }
+
+  /** Create the file with the current header, and map it read/write */
+  void Create(const std::string & filename)
+  {
+    Close();
+    int fd = ::open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+      {
+      itkGenericExceptionMacro("Unable to create " << filename);
+      }
+    const uint64_t fileSize = m_Header.dataOffset + GetDataSize();
+    if (::ftruncate(fd, fileSize) != 0 ||
+        ::pwrite(fd, &m_Header, sizeof(Header), 0) != static_cast<ssize_t>(sizeof(Header)) ||
+        ::pwrite(fd, m_Projection.data(), m_Projection.size(), sizeof(Header)) != static_cast<ssize_t>(m_Projection.size()))
+      {
+      ::close(fd);
+      itkGenericExceptionMacro("Unable to write " << filename);
+      }
+    Map(fd, fileSize, PROT_READ | PROT_WRITE, MAP_SHARED, filename);
+  }
+
+  /** Open an existing file, and map it privately (copy on write) */
+  void Open(const std::string & filename)
+  {
+    Close();
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+      {
+      itkGenericExceptionMacro("Unable to open " << filename);
+      }
+    struct stat fileStat;
+    if (::fstat(fd, &fileStat) != 0 || static_cast<uint64_t>(fileStat.st_size) < sizeof(Header) ||
+        ::pread(fd, &m_Header, sizeof(Header), 0) != static_cast<ssize_t>(sizeof(Header)) ||
+        std::memcmp(m_Header.magic, "OTBCCR1", 8) != 0 ||
+        static_cast<uint64_t>(fileStat.st_size) < m_Header.dataOffset + GetDataSize())
+      {
+      ::close(fd);
+      itkGenericExceptionMacro(<< filename << " is not a valid .ccr file");
+      }
+    m_Projection.resize(m_Header.projectionSize);
+    if (m_Header.projectionSize > 0 &&
+        ::pread(fd, &m_Projection[0], m_Header.projectionSize, sizeof(Header)) != static_cast<ssize_t>(m_Header.projectionSize))
+      {
+      ::close(fd);
+      itkGenericExceptionMacro("Unable to read " << filename);
+      }
+    Map(fd, fileStat.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, filename);
+  }
+
+  /** Flush (when created) and unmap */
+  void Close()
+  {
+    if (m_Data != NULL && m_Shared && ::msync(m_Data, m_MappedSize, MS_SYNC) != 0)
+      {
+      Unmap();
+      itkGenericExceptionMacro("Unable to flush the mapped file");
+      }
+    Unmap();
+  }
+
+  const Header & GetHeader() const { return m_Header; }
+  const std::string & GetProjection() const { return m_Projection; }
+
+  uint64_t GetPixelSize() const { return static_cast<uint64_t>(m_Header.componentSize) * m_Header.nbOfComponents; }
+  uint64_t GetDataSize() const { return GetPixelSize() * m_Header.width * m_Header.height; }
+
+  /** Address of the pixel (x, y) in the mapping */
+  char * GetPixelPointer(uint64_t x, uint64_t y) const
+  {
+    return m_Data + m_Header.dataOffset + (y * m_Header.width + x) * GetPixelSize();
+  }
+
+private:
+  MappedRasterFile(const MappedRasterFile&); //purposely not implemented
+  void operator=(const MappedRasterFile&); //purposely not implemented
+
+  /** Unmap, without flushing */
+  void Unmap()
+  {
+    if (m_Data != NULL)
+      {
+      ::munmap(m_Data, m_MappedSize);
+      m_Data = NULL;
+      m_MappedSize = 0;
+      }
+  }
+
+  void Map(int fd, uint64_t size, int protection, int flags, const std::string & filename)
+  {
+    void * data = ::mmap(NULL, size, protection, flags, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED)
+      {
+      itkGenericExceptionMacro("Unable to map " << filename);
+      }
+    m_Data = static_cast<char *>(data);
+    m_MappedSize = size;
+    m_Shared = (flags & MAP_SHARED) != 0;
+  }
+
+  Header      m_Header;
+  std::string m_Projection;
+  char *      m_Data;
+  uint64_t    m_MappedSize;
+  bool        m_Shared;
+};
+
+} // namespace otb
+
+#endif
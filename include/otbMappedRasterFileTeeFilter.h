@@ -0,0 +1,95 @@
+/*=========================================================================
+
+  Copyright (c) Remi Cresson (IRSTEA). All rights reserved.
+
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef MappedRasterFileTeeFilter_H_
+#define MappedRasterFileTeeFilter_H_
+
+#include "itkImageToImageFilter.h"
+#include "otbMappedRasterFile.h"
+
+#include <string>
+
+namespace otb
+{
+
+/**
+ * \class MappedRasterFileTeeFilter
+ * \brief Pass-through filter which also writes its input in the native raster format
+ *
+ * Each region generated by the filter is copied in the output image, and
+ * in a MappedRasterFile (see MappedRasterFileWriter), in the pixel type of
+ * the image. The image is hence written by the streaming of the downstream
+ * consumer (e.g. a vectorization), without a second update of the upstream
+ * pipeline. The consumer must request the whole image.
+ *
+ * The file is created under a temporary name when the first region is
+ * generated, and renamed by Close(), so that a reader never sees a partial
+ * file.
+ *
+ * \ingroup ClearCutsDetection
+ */
+template <class TImage>
+class ITK_EXPORT MappedRasterFileTeeFilter :
+public itk::ImageToImageFilter<TImage, TImage>
+{
+
+public:
+
+  /** Standard class typedefs. */
+  typedef MappedRasterFileTeeFilter               Self;
+  typedef itk::ImageToImageFilter<TImage, TImage> Superclass;
+  typedef itk::SmartPointer<Self>                 Pointer;
+  typedef itk::SmartPointer<const Self>           ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(MappedRasterFileTeeFilter, itk::ImageToImageFilter);
+
+  /** Image typedefs */
+  typedef TImage                                     ImageType;
+  typedef typename ImageType::RegionType             RegionType;
+  typedef typename ImageType::IndexType              IndexType;
+  typedef typename ImageType::InternalPixelType      InternalPixelType;
+
+  /** Output file name */
+  itkSetStringMacro(FileName);
+  itkGetStringMacro(FileName);
+
+  /** Flush the file, and give it its final name */
+  void Close();
+
+protected:
+  MappedRasterFileTeeFilter();
+  virtual ~MappedRasterFileTeeFilter() {};
+
+  virtual void BeforeThreadedGenerateData();
+
+  virtual void ThreadedGenerateData(const RegionType& outputRegionForThread,
+      itk::ThreadIdType threadId);
+
+private:
+  MappedRasterFileTeeFilter(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+  std::string      m_FileName;
+  MappedRasterFile m_File;
+  bool             m_Created;
+
+};
+
+
+} // end namespace otb
+
+#include "otbMappedRasterFileTeeFilter.hxx"
+
+
+#endif /* MappedRasterFileTeeFilter_H_ */
@@ -0,0 +1,115 @@
+/*=========================================================================
+
+  Copyright (c) Remi Cresson (IRSTEA). All rights reserved.
+
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef __MappedRasterFileTeeFilter_hxx
+#define __MappedRasterFileTeeFilter_hxx
+
+#include "otbMappedRasterFileTeeFilter.h"
+#include "itkImageIOBase.h"
+#include "itkProgressReporter.h"
+
+#include <cstdio>
+
+namespace otb
+{
+/**
+ *
+ */
+template <class TImage>
+MappedRasterFileTeeFilter<TImage>
+::MappedRasterFileTeeFilter()
+ {
+  m_Created = false;
+ }
+
+/*
+ * Create the file, with the geometry of the whole image
+ */
+template <class TImage>
+void
+MappedRasterFileTeeFilter<TImage>
+::BeforeThreadedGenerateData()
+ {
+  if (m_Created)
+    return;
+  if (m_FileName.empty())
+    {
+    itkExceptionMacro("No output file name");
+    }
+
+  const ImageType * inputImage = this->GetInput();
+  const RegionType largestRegion = inputImage->GetLargestPossibleRegion();
+  double origin[2];
+  double spacing[2];
+  for (unsigned int dim = 0 ; dim < 2 ; dim++)
+    {
+    origin[dim] = inputImage->GetOrigin()[dim];
+    spacing[dim] = inputImage->GetSignedSpacing()[dim];
+    }
+  m_File.SetHeader(itk::ImageIOBase::MapPixelType<InternalPixelType>::CType, sizeof(InternalPixelType),
+      inputImage->GetNumberOfComponentsPerPixel(), largestRegion.GetSize(0), largestRegion.GetSize(1),
+      origin, spacing, inputImage->GetProjectionRef());
+  m_File.Create(m_FileName + ".tmp");
+  m_Created = true;
+ }
+
+template <class TImage>
+void
+MappedRasterFileTeeFilter<TImage>
+::Close()
+ {
+  if (!m_Created)
+    {
+    itkExceptionMacro("Nothing has been written in " << m_FileName);
+    }
+  m_File.Close();
+  m_Created = false;
+
+  const std::string tempFileName = m_FileName + ".tmp";
+  if (std::rename(tempFileName.c_str(), m_FileName.c_str()) != 0)
+    {
+    itkExceptionMacro("Unable to rename " << tempFileName << " to " << m_FileName);
+    }
+ }
+
+/*
+ * Copy the rows of the region in the output, and in the file
+ */
+template <class TImage>
+void
+MappedRasterFileTeeFilter<TImage>
+::ThreadedGenerateData(const RegionType& outputRegionForThread, itk::ThreadIdType threadId)
+ {
+  // Support progress methods/callbacks
+  itk::ProgressReporter progress(this, threadId, outputRegionForThread.GetSize(1) );
+
+  const ImageType * inputImage = this->GetInput();
+  ImageType * outputImage = this->GetOutput();
+  const IndexType origin = inputImage->GetLargestPossibleRegion().GetIndex();
+  const unsigned int nbOfComponents = inputImage->GetNumberOfComponentsPerPixel();
+  const size_t rowSize = outputRegionForThread.GetSize(0) * nbOfComponents * sizeof(InternalPixelType);
+
+  for (unsigned int y = 0 ; y < outputRegionForThread.GetSize(1) ; y++)
+    {
+    IndexType rowIndex = outputRegionForThread.GetIndex();
+    rowIndex[1] += y;
+    const InternalPixelType * inputPtr = inputImage->GetBufferPointer()
+        + inputImage->ComputeOffset(rowIndex) * nbOfComponents;
+    InternalPixelType * outputPtr = outputImage->GetBufferPointer()
+        + outputImage->ComputeOffset(rowIndex) * nbOfComponents;
+    std::memcpy(outputPtr, inputPtr, rowSize);
+    std::memcpy(m_File.GetPixelPointer(rowIndex[0] - origin[0], rowIndex[1] - origin[1]), inputPtr, rowSize);
+
+    progress.CompletedPixel();
+    }
+ }
+
+}
+#endif
@@ -0,0 +1,98 @@
+/*=========================================================================
+
+  Copyright (c) Remi Cresson (IRSTEA). All rights reserved.
+
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef MappedRasterFileWriter_H_
+#define MappedRasterFileWriter_H_
+
+#include "itkProcessObject.h"
+#include "otbRAMDrivenStrippedStreamingManager.h"
+#include "otbMappedRasterFile.h"
+
+#include <string>
+
+namespace otb
+{
+
+/**
+ * \class MappedRasterFileWriter
+ * \brief Write an image in the native raster format (see MappedRasterFile)
+ *
+ * The image is streamed in strips, which are copied in the mapped file.
+ * The file is written under a temporary name, then renamed, so that a
+ * reader never sees a partial file.
+ *
+ * \ingroup ClearCutsDetection
+ */
+template <class TInputImage>
+class ITK_EXPORT MappedRasterFileWriter : public itk::ProcessObject
+{
+
+public:
+
+  /** Standard class typedefs. */
+  typedef MappedRasterFileWriter        Self;
+  typedef itk::ProcessObject            Superclass;
+  typedef itk::SmartPointer<Self>       Pointer;
+  typedef itk::SmartPointer<const Self> ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(MappedRasterFileWriter, itk::ProcessObject);
+
+  /** Image typedefs */
+  typedef TInputImage                                InputImageType;
+  typedef typename InputImageType::RegionType        RegionType;
+  typedef typename InputImageType::IndexType         IndexType;
+  typedef typename InputImageType::InternalPixelType InternalPixelType;
+  typedef otb::RAMDrivenStrippedStreamingManager<InputImageType> StreamingManagerType;
+
+  /** Input image */
+  using Superclass::SetInput;
+  virtual void SetInput(const InputImageType * input);
+  const InputImageType * GetInput();
+
+  /** Output file name */
+  itkSetStringMacro(FileName);
+  itkGetStringMacro(FileName);
+
+  /** RAM used by the streaming (Mb) */
+  itkSetMacro(AvailableRAM, unsigned int);
+  itkGetMacro(AvailableRAM, unsigned int);
+
+  /** Streaming manager, prepared by Update() */
+  itkGetObjectMacro(StreamingManager, StreamingManagerType);
+
+  /** Write the image */
+  virtual void Update();
+
+protected:
+  MappedRasterFileWriter();
+  virtual ~MappedRasterFileWriter() {};
+
+private:
+  MappedRasterFileWriter(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+  std::string  m_FileName;
+  unsigned int m_AvailableRAM;
+
+  typename StreamingManagerType::Pointer m_StreamingManager;
+
+};
+
+
+} // end namespace otb
+
+#include "otbMappedRasterFileWriter.hxx"
+
+
+#endif /* MappedRasterFileWriter_H_ */
@@ -0,0 +1,125 @@
+/*=========================================================================
+
+  Copyright (c) Remi Cresson (IRSTEA). All rights reserved.
+
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef __MappedRasterFileWriter_hxx
+#define __MappedRasterFileWriter_hxx
+
+#include "otbMappedRasterFileWriter.h"
+#include "itkImageIOBase.h"
+
+#include <cstdio>
+#include <cstring>
+
+namespace otb
+{
+/**
+ *
+ */
+template <class TInputImage>
+MappedRasterFileWriter<TInputImage>
+::MappedRasterFileWriter()
+ {
+  this->SetNumberOfRequiredInputs(1);
+  m_AvailableRAM = 128;
+  m_StreamingManager = StreamingManagerType::New();
+ }
+
+template <class TInputImage>
+void
+MappedRasterFileWriter<TInputImage>
+::SetInput(const InputImageType * input)
+ {
+  this->itk::ProcessObject::SetNthInput(0, const_cast<InputImageType *>(input));
+ }
+
+template <class TInputImage>
+const typename MappedRasterFileWriter<TInputImage>::InputImageType *
+MappedRasterFileWriter<TInputImage>
+::GetInput()
+ {
+  return static_cast<const InputImageType *>(this->itk::ProcessObject::GetInput(0));
+ }
+
+/**
+ *
+ */
+template <class TInputImage>
+void
+MappedRasterFileWriter<TInputImage>
+::Update()
+ {
+  InputImageType * inputImage = const_cast<InputImageType *>(this->GetInput());
+  if (inputImage == NULL)
+    {
+    itkExceptionMacro("No input image");
+    }
+  if (m_FileName.empty())
+    {
+    itkExceptionMacro("No output file name");
+    }
+
+  this->InvokeEvent(itk::StartEvent());
+  this->UpdateProgress(0.0);
+
+  inputImage->UpdateOutputInformation();
+  const RegionType largestRegion = inputImage->GetLargestPossibleRegion();
+  const unsigned int nbOfComponents = inputImage->GetNumberOfComponentsPerPixel();
+
+  // Header
+  double origin[2];
+  double spacing[2];
+  for (unsigned int dim = 0 ; dim < 2 ; dim++)
+    {
+    origin[dim] = inputImage->GetOrigin()[dim];
+    spacing[dim] = inputImage->GetSignedSpacing()[dim];
+    }
+  MappedRasterFile file;
+  file.SetHeader(itk::ImageIOBase::MapPixelType<InternalPixelType>::CType, sizeof(InternalPixelType),
+      nbOfComponents, largestRegion.GetSize(0), largestRegion.GetSize(1), origin, spacing,
+      inputImage->GetProjectionRef());
+  const std::string tempFileName = m_FileName + ".tmp";
+  file.Create(tempFileName);
+
+  // Stream strips (full rows), and copy them in the mapping
+  m_StreamingManager->SetAvailableRAMInMB(m_AvailableRAM);
+  m_StreamingManager->PrepareStreaming(inputImage, largestRegion);
+  const unsigned int nbOfSplits = m_StreamingManager->GetNumberOfSplits();
+  for (unsigned int split = 0 ; split < nbOfSplits ; split++)
+    {
+    RegionType region = m_StreamingManager->GetSplit(split);
+    inputImage->SetRequestedRegion(region);
+    inputImage->PropagateRequestedRegion();
+    inputImage->UpdateOutputData();
+
+    const size_t rowSize = region.GetSize(0) * file.GetPixelSize();
+    for (unsigned int y = 0 ; y < region.GetSize(1) ; y++)
+      {
+      IndexType rowIndex = region.GetIndex();
+      rowIndex[1] += y;
+      const InternalPixelType * inputPtr = inputImage->GetBufferPointer()
+          + inputImage->ComputeOffset(rowIndex) * nbOfComponents;
+      std::memcpy(file.GetPixelPointer(rowIndex[0] - largestRegion.GetIndex(0),
+          rowIndex[1] - largestRegion.GetIndex(1)), inputPtr, rowSize);
+      }
+
+    this->UpdateProgress(static_cast<float>(split + 1) / nbOfSplits);
+    }
+
+  file.Close();
+  if (std::rename(tempFileName.c_str(), m_FileName.c_str()) != 0)
+    {
+    itkExceptionMacro("Unable to rename " << tempFileName << " to " << m_FileName);
+    }
+
+  this->InvokeEvent(itk::EndEvent());
+ }
+
+}
+#endif
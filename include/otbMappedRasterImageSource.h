@@ -0,0 +1,101 @@
+/*=========================================================================
+
+  Copyright (c) Remi Cresson (IRSTEA). All rights reserved.
+
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef MappedRasterImageSource_H_
+#define MappedRasterImageSource_H_
+
+#include "itkImageSource.h"
+#include "otbMappedRasterFile.h"
+
+#include <string>
+
+namespace otb
+{
+
+/**
+ * \class MappedRasterImageSource
+ * \brief Read an image in the native raster format (see MappedRasterFile)
+ *
+ * The file is mapped in memory (privately: pixels written by downstream
+ * filters are not written back). The requested regions are enlarged to
+ * full rows, so the output buffer points directly in the mapping: pixels
+ * are neither decoded nor copied, and share the page cache.
+ *
+ * When the pixel type of the file differs from the one of the output (e.g.
+ * uint8 label images read as float), the pixels of the requested region
+ * only are converted (copied) instead.
+ *
+ * \ingroup ClearCutsDetection
+ */
+template <class TOutputImage>
+class ITK_EXPORT MappedRasterImageSource : public itk::ImageSource<TOutputImage>
+{
+
+public:
+
+  /** Standard class typedefs. */
+  typedef MappedRasterImageSource        Self;
+  typedef itk::ImageSource<TOutputImage> Superclass;
+  typedef itk::SmartPointer<Self>        Pointer;
+  typedef itk::SmartPointer<const Self>  ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(MappedRasterImageSource, itk::ImageSource);
+
+  /** Image typedefs */
+  typedef TOutputImage                                OutputImageType;
+  typedef typename OutputImageType::RegionType        RegionType;
+  typedef typename OutputImageType::IndexType         IndexType;
+  typedef typename OutputImageType::SizeType          SizeType;
+  typedef typename OutputImageType::PointType         PointType;
+  typedef typename OutputImageType::SpacingType       SpacingType;
+  typedef typename OutputImageType::InternalPixelType InternalPixelType;
+
+  /** Input file name */
+  itkSetStringMacro(FileName);
+  itkGetStringMacro(FileName);
+
+  /** True when the output buffer points in the mapping */
+  bool IsZeroCopy() const;
+
+protected:
+  MappedRasterImageSource() {};
+  virtual ~MappedRasterImageSource() {};
+
+  virtual void GenerateOutputInformation();
+
+  virtual void EnlargeOutputRequestedRegion(itk::DataObject * output);
+
+  virtual void GenerateData();
+
+  /** Convert the pixels of the requested region */
+  template <class TFileValue>
+  void CopyPixels(const RegionType & region);
+
+private:
+  MappedRasterImageSource(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+  std::string      m_FileName;
+  std::string      m_MappedFileName;
+  MappedRasterFile m_File;
+
+};
+
+
+} // end namespace otb
+
+#include "otbMappedRasterImageSource.hxx"
+
+
+#endif /* MappedRasterImageSource_H_ */
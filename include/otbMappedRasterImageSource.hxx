@@ -0,0 +1,171 @@
+/*=========================================================================
+
+  Copyright (c) Remi Cresson (IRSTEA). All rights reserved.
+
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef __MappedRasterImageSource_hxx
+#define __MappedRasterImageSource_hxx
+
+#include "otbMappedRasterImageSource.h"
+#include "itkImageIOBase.h"
+#include "itkMetaDataObject.h"
+#include "otbMetaDataKey.h"
+
+namespace otb
+{
+
+template <class TOutputImage>
+bool
+MappedRasterImageSource<TOutputImage>
+::IsZeroCopy() const
+ {
+  const MappedRasterFile::Header & header = m_File.GetHeader();
+  return header.componentType == itk::ImageIOBase::MapPixelType<InternalPixelType>::CType
+      && header.componentSize == sizeof(InternalPixelType);
+ }
+
+/*
+ * Map the file, and read its geometry
+ */
+template <class TOutputImage>
+void
+MappedRasterImageSource<TOutputImage>
+::GenerateOutputInformation()
+ {
+  if (m_FileName.empty())
+    {
+    itkExceptionMacro("No input file name");
+    }
+  if (m_FileName != m_MappedFileName)
+    {
+    m_File.Open(m_FileName);
+    m_MappedFileName = m_FileName;
+    }
+  const MappedRasterFile::Header & header = m_File.GetHeader();
+
+  OutputImageType * outputImage = this->GetOutput();
+
+  RegionType largestRegion;
+  largestRegion.SetIndex(0, 0);
+  largestRegion.SetIndex(1, 0);
+  largestRegion.SetSize(0, header.width);
+  largestRegion.SetSize(1, header.height);
+  outputImage->SetLargestPossibleRegion(largestRegion);
+
+  PointType origin;
+  SpacingType spacing;
+  for (unsigned int dim = 0 ; dim < 2 ; dim++)
+    {
+    origin[dim] = header.origin[dim];
+    spacing[dim] = header.spacing[dim];
+    }
+  outputImage->SetOrigin(origin);
+  outputImage->SetSignedSpacing(spacing);
+  outputImage->SetNumberOfComponentsPerPixel(header.nbOfComponents);
+  if (outputImage->GetNumberOfComponentsPerPixel() != header.nbOfComponents)
+    {
+    itkExceptionMacro(<< m_FileName << " has " << header.nbOfComponents << " bands");
+    }
+  itk::EncapsulateMetaData<std::string>(outputImage->GetMetaDataDictionary(),
+      MetaDataKey::ProjectionRefKey, m_File.GetProjection());
+ }
+
+/*
+ * Full rows are contiguous in the file: they are mapped without copy.
+ * Converted pixels are copied for the requested region only.
+ */
+template <class TOutputImage>
+void
+MappedRasterImageSource<TOutputImage>
+::EnlargeOutputRequestedRegion(itk::DataObject * output)
+ {
+  OutputImageType * outputImage = dynamic_cast<OutputImageType *>(output);
+  if (outputImage == NULL || !IsZeroCopy())
+    return;
+
+  RegionType region = outputImage->GetRequestedRegion();
+  region.SetIndex(0, outputImage->GetLargestPossibleRegion().GetIndex(0));
+  region.SetSize(0, outputImage->GetLargestPossibleRegion().GetSize(0));
+  outputImage->SetRequestedRegion(region);
+ }
+
+template <class TOutputImage>
+template <class TFileValue>
+void
+MappedRasterImageSource<TOutputImage>
+::CopyPixels(const RegionType & region)
+ {
+  const size_t nbOfValues = region.GetSize(0) * m_File.GetHeader().nbOfComponents;
+  InternalPixelType * outputPtr = this->GetOutput()->GetBufferPointer();
+  for (unsigned int y = 0 ; y < region.GetSize(1) ; y++)
+    {
+    const TFileValue * filePtr = reinterpret_cast<const TFileValue *>(
+        m_File.GetPixelPointer(region.GetIndex(0), region.GetIndex(1) + y));
+    for (size_t i = 0 ; i < nbOfValues ; i++)
+      outputPtr[i] = static_cast<InternalPixelType>(filePtr[i]);
+    outputPtr += nbOfValues;
+    }
+ }
+
+/**
+ *
+ */
+template <class TOutputImage>
+void
+MappedRasterImageSource<TOutputImage>
+::GenerateData()
+ {
+  OutputImageType * outputImage = this->GetOutput();
+  const RegionType region = outputImage->GetRequestedRegion();
+  outputImage->SetBufferedRegion(region);
+
+  if (IsZeroCopy())
+    {
+    // Buffer in the mapping
+    InternalPixelType * ptr = reinterpret_cast<InternalPixelType *>(
+        m_File.GetPixelPointer(region.GetIndex(0), region.GetIndex(1)));
+    outputImage->GetPixelContainer()->SetImportPointer(ptr,
+        region.GetNumberOfPixels() * m_File.GetHeader().nbOfComponents, false);
+    return;
+    }
+
+  // Conversion
+  outputImage->Allocate();
+  switch (m_File.GetHeader().componentType)
+    {
+    case itk::ImageIOBase::UCHAR:
+      CopyPixels<unsigned char>(region);
+      break;
+    case itk::ImageIOBase::CHAR:
+      CopyPixels<char>(region);
+      break;
+    case itk::ImageIOBase::USHORT:
+      CopyPixels<unsigned short>(region);
+      break;
+    case itk::ImageIOBase::SHORT:
+      CopyPixels<short>(region);
+      break;
+    case itk::ImageIOBase::UINT:
+      CopyPixels<unsigned int>(region);
+      break;
+    case itk::ImageIOBase::INT:
+      CopyPixels<int>(region);
+      break;
+    case itk::ImageIOBase::FLOAT:
+      CopyPixels<float>(region);
+      break;
+    case itk::ImageIOBase::DOUBLE:
+      CopyPixels<double>(region);
+      break;
+    default:
+      itkExceptionMacro("Unsupported pixel type in " << m_FileName);
+    }
+ }
+
+}
+#endif
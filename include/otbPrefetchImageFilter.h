@@ -0,0 +1,181 @@
+/*=========================================================================
+
+  Copyright (c) Remi Cresson (IRSTEA). All rights reserved.
+
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef PrefetchImageFilter_H_
+#define PrefetchImageFilter_H_
+
+#include "itkImageToImageFilter.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionIterator.h"
+
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <algorithm>
+
+namespace otb
+{
+
+/**
+ * \class PrefetchImageFilter
+ * \brief Pass-through filter which pipelines the streaming of its input
+ *
+ * The regions requested downstream are the splits of the streaming manager
+ * of the consumer (a writer, a persistent filter streamer...), given with
+ * SetStreamingManager() before its update: once the i-th split has been
+ * requested, the splits i+1 to i+m_QueueDepth are generated in advance on a
+ * worker thread, while the downstream filters (vectorization, writer...)
+ * process the current one. Filters between the prefetch and the consumer
+ * can translate or pad the splits (extraction, neighborhood): the offsets
+ * between a split and the region actually requested are learned from the
+ * previous tiles. Each in-flight tile is an independent copy of the upstream
+ * output, hence the RAM used by the streaming should be divided by
+ * (m_QueueDepth + 1). Without a streaming manager, the filter is a
+ * synchronous pass-through.
+ *
+ * The upstream pipeline is only touched by one thread at a time, since its
+ * filters are shared between the tiles (they are multithreaded themselves):
+ * the worker reads and computes a tile while the main thread consumes the
+ * previous one. A request which does not match a prefetched tile cancels
+ * the tiles which have not started, waits for the one being computed, then
+ * falls back to the regular (synchronous) pipeline update. After two
+ * consecutive misses, the prefetch is disabled until the next streaming
+ * manager is set.
+ *
+ * \ingroup ClearCutsDetection
+ */
+template <class TImage>
+class ITK_EXPORT PrefetchImageFilter :
+public itk::ImageToImageFilter<TImage, TImage>
+{
+
+public:
+
+  /** Standard class typedefs. */
+  typedef PrefetchImageFilter                     Self;
+  typedef itk::ImageToImageFilter<TImage, TImage> Superclass;
+  typedef itk::SmartPointer<Self>                 Pointer;
+  typedef itk::SmartPointer<const Self>           ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(PrefetchImageFilter, itk::ImageToImageFilter);
+
+  /** Image typedefs */
+  typedef TImage                                         ImageType;
+  typedef typename ImageType::Pointer                    ImagePointer;
+  typedef typename ImageType::RegionType                 ImageRegionType;
+  typedef typename ImageType::IndexType                  ImageIndexType;
+  typedef typename ImageType::OffsetType                 ImageOffsetType;
+  typedef typename itk::ImageRegionConstIterator<TImage> InputImageIteratorType;
+  typedef typename itk::ImageRegionIterator<TImage>      OutputImageIteratorType;
+
+  /** Number of tiles which can be generated in advance (0 disables the prefetch) */
+  itkSetMacro(QueueDepth, unsigned int);
+  itkGetMacro(QueueDepth, unsigned int);
+
+  /** Streaming manager of the consumer, whose splits are the next requested
+   * regions. The splits are read when they are requested, i.e. after the
+   * consumer has prepared its streaming. */
+  template <class TStreamingManager>
+  void SetStreamingManager(TStreamingManager * streamingManager)
+  {
+    typename TStreamingManager::Pointer manager(streamingManager);
+    SetSplits([manager]{ return manager->GetNumberOfSplits(); },
+        [manager](unsigned int i){ return ImageRegionType(manager->GetSplit(i)); });
+  }
+
+  /** Back to a synchronous pass-through */
+  void RemoveStreamingManager();
+
+  /** Pipeline overrides: prefetched tiles are served without touching upstream */
+  virtual void UpdateOutputInformation();
+  virtual void PropagateRequestedRegion(itk::DataObject * output);
+  virtual void UpdateOutputData(itk::DataObject * output);
+
+protected:
+  PrefetchImageFilter();
+  virtual ~PrefetchImageFilter();
+
+  virtual void GenerateData();
+
+  /** A tile generated by the worker thread */
+  struct Job
+  {
+    ImageRegionType    region;
+    ImagePointer       buffer;
+    unsigned int       split;
+    bool               running;
+    bool               done;
+    std::exception_ptr error;
+  };
+  typedef std::deque<Job*> JobQueueType;
+
+  /** Copy the given region of the upstream output in a new image */
+  ImagePointer CopyInputRegion(const ImageRegionType & region);
+
+  typedef std::function<unsigned int()>             NumberOfSplitsFunctionType;
+  typedef std::function<ImageRegionType(unsigned int)> SplitFunctionType;
+
+  /** Set the splits of the streaming, and restart it */
+  void SetSplits(const NumberOfSplitsFunctionType & numberOfSplits, const SplitFunctionType & split);
+
+  /** Region requested for a split, according to the learned offsets */
+  ImageRegionType GetSplitRequestedRegion(unsigned int split);
+
+  /** Learn the offsets between a split and the region requested for it */
+  void UpdateSplitOffsets(unsigned int split, const ImageRegionType & region);
+
+  /** Enqueue the splits which follow the one just served */
+  void SchedulePrefetch(unsigned int split);
+
+  /** Cancel the tiles which have not started, wait for the running one, then drop them */
+  void DrainJobs();
+
+  /** Worker thread loop */
+  void WorkerLoop();
+
+private:
+  PrefetchImageFilter(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+  unsigned int            m_QueueDepth;
+
+  // Splits of the consumer's streaming
+  NumberOfSplitsFunctionType m_NumberOfSplitsFunction;
+  SplitFunctionType       m_SplitFunction;
+  unsigned int            m_NumberOfRequests;
+  unsigned int            m_NextScheduledSplit;
+  unsigned int            m_ConsecutiveMisses;
+  ImageOffsetType         m_LowerOffset;
+  ImageOffsetType         m_UpperOffset;
+
+  // Worker
+  JobQueueType            m_Jobs;
+  unsigned int            m_NextJob;
+  bool                    m_Stop;
+  std::thread             m_Worker;
+  std::mutex              m_Mutex;
+  std::condition_variable m_Condition;
+
+};
+
+
+} // end namespace otb
+
+#include "otbPrefetchImageFilter.hxx"
+
+
+#endif /* PrefetchImageFilter_H_ */
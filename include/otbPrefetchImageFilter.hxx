@@ -0,0 +1,366 @@
+/*=========================================================================
+
+  Copyright (c) Remi Cresson (IRSTEA). All rights reserved.
+
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef __PrefetchImageFilter_hxx
+#define __PrefetchImageFilter_hxx
+
+#include "otbPrefetchImageFilter.h"
+
+namespace otb
+{
+/**
+ *
+ */
+template <class TImage>
+PrefetchImageFilter<TImage>
+::PrefetchImageFilter()
+ {
+  m_QueueDepth = 1;
+  m_NumberOfRequests = 0;
+  m_NextScheduledSplit = 0;
+  m_ConsecutiveMisses = 0;
+  m_LowerOffset.Fill(0);
+  m_UpperOffset.Fill(0);
+  m_NextJob = 0;
+  m_Stop = false;
+ }
+
+template <class TImage>
+PrefetchImageFilter<TImage>
+::~PrefetchImageFilter()
+ {
+  {
+  std::unique_lock<std::mutex> lock(m_Mutex);
+  m_Stop = true;
+  }
+  m_Condition.notify_all();
+  if (m_Worker.joinable())
+    m_Worker.join();
+
+  for (unsigned int i = 0 ; i < m_Jobs.size() ; i++)
+    delete m_Jobs[i];
+ }
+
+/*
+ * Copy the given region of the upstream output in a new image
+ */
+template <class TImage>
+typename PrefetchImageFilter<TImage>::ImagePointer
+PrefetchImageFilter<TImage>
+::CopyInputRegion(const ImageRegionType & region)
+ {
+  const ImageType * inputImage = this->GetInput();
+
+  ImagePointer buffer = ImageType::New();
+  buffer->CopyInformation(inputImage);
+  buffer->SetRequestedRegion(region);
+  buffer->SetBufferedRegion(region);
+  buffer->Allocate();
+
+  InputImageIteratorType inputIt(inputImage, region);
+  OutputImageIteratorType outputIt(buffer, region);
+  for ( inputIt.GoToBegin(), outputIt.GoToBegin(); !outputIt.IsAtEnd(); ++outputIt, ++inputIt )
+    {
+    outputIt.Set(inputIt.Get());
+    }
+
+  return buffer;
+ }
+
+/*
+ * Worker thread: generate the queued regions one after the other.
+ * The upstream pipeline is never updated concurrently, since the main
+ * thread drains the queue before it falls back to a synchronous update.
+ */
+template <class TImage>
+void
+PrefetchImageFilter<TImage>
+::WorkerLoop()
+ {
+  std::unique_lock<std::mutex> lock(m_Mutex);
+  while (true)
+    {
+    m_Condition.wait(lock, [this]{ return m_Stop || m_NextJob < m_Jobs.size(); });
+    if (m_Stop)
+      return;
+
+    Job * job = m_Jobs[m_NextJob];
+    job->running = true;
+    lock.unlock();
+
+    try
+      {
+      ImageType * inputImage = const_cast<ImageType *>(this->GetInput());
+      inputImage->SetRequestedRegion(job->region);
+      inputImage->PropagateRequestedRegion();
+      inputImage->UpdateOutputData();
+      job->buffer = CopyInputRegion(job->region);
+      }
+    catch (...)
+      {
+      job->error = std::current_exception();
+      }
+
+    lock.lock();
+    job->running = false;
+    job->done = true;
+    m_NextJob++;
+    m_Condition.notify_all();
+    }
+ }
+
+/*
+ * Cancel the tiles which have not started, wait for the running one,
+ * then drop them
+ */
+template <class TImage>
+void
+PrefetchImageFilter<TImage>
+::DrainJobs()
+ {
+  std::unique_lock<std::mutex> lock(m_Mutex);
+  while (m_Jobs.size() > m_NextJob && !m_Jobs.back()->running)
+    {
+    delete m_Jobs.back();
+    m_Jobs.pop_back();
+    }
+  m_Condition.wait(lock, [this]{ return m_NextJob == m_Jobs.size(); });
+  for (unsigned int i = 0 ; i < m_Jobs.size() ; i++)
+    delete m_Jobs[i];
+  m_Jobs.clear();
+  m_NextJob = 0;
+ }
+
+template <class TImage>
+void
+PrefetchImageFilter<TImage>
+::SetSplits(const NumberOfSplitsFunctionType & numberOfSplits, const SplitFunctionType & split)
+ {
+  DrainJobs();
+  m_NumberOfSplitsFunction = numberOfSplits;
+  m_SplitFunction = split;
+  m_NumberOfRequests = 0;
+  m_NextScheduledSplit = 0;
+  m_ConsecutiveMisses = 0;
+  m_LowerOffset.Fill(0);
+  m_UpperOffset.Fill(0);
+ }
+
+template <class TImage>
+void
+PrefetchImageFilter<TImage>
+::RemoveStreamingManager()
+ {
+  SetSplits(NumberOfSplitsFunctionType(), SplitFunctionType());
+ }
+
+/*
+ * Region requested for a split: the split, moved by the learned offsets,
+ * and cropped to the largest possible region
+ */
+template <class TImage>
+typename PrefetchImageFilter<TImage>::ImageRegionType
+PrefetchImageFilter<TImage>
+::GetSplitRequestedRegion(unsigned int split)
+ {
+  const ImageRegionType splitRegion = m_SplitFunction(split);
+  ImageRegionType region(splitRegion);
+  for (unsigned int dim = 0 ; dim < ImageType::ImageDimension ; dim++)
+    {
+    region.SetIndex(dim, splitRegion.GetIndex(dim) - m_LowerOffset[dim]);
+    region.SetSize(dim, splitRegion.GetSize(dim) + m_LowerOffset[dim] + m_UpperOffset[dim]);
+    }
+  region.Crop(this->GetOutput()->GetLargestPossibleRegion());
+  return region;
+ }
+
+/*
+ * Offsets between a split and the region requested for it. The sides of
+ * the region cropped by the largest possible region tell nothing, and keep
+ * the offsets learned from the previous tiles.
+ */
+template <class TImage>
+void
+PrefetchImageFilter<TImage>
+::UpdateSplitOffsets(unsigned int split, const ImageRegionType & region)
+ {
+  const ImageRegionType splitRegion = m_SplitFunction(split);
+  const ImageRegionType largestRegion = this->GetOutput()->GetLargestPossibleRegion();
+  for (unsigned int dim = 0 ; dim < ImageType::ImageDimension ; dim++)
+    {
+    const itk::OffsetValueType lower = region.GetIndex(dim);
+    const itk::OffsetValueType upper = lower + region.GetSize(dim);
+    const itk::OffsetValueType splitLower = splitRegion.GetIndex(dim);
+    const itk::OffsetValueType splitUpper = splitLower + splitRegion.GetSize(dim);
+    if (lower > largestRegion.GetIndex(dim))
+      m_LowerOffset[dim] = splitLower - lower;
+    if (upper < largestRegion.GetIndex(dim) + static_cast<itk::OffsetValueType>(largestRegion.GetSize(dim)))
+      m_UpperOffset[dim] = upper - splitUpper;
+    }
+ }
+
+/*
+ * Queue the splits which follow the one just served
+ */
+template <class TImage>
+void
+PrefetchImageFilter<TImage>
+::SchedulePrefetch(unsigned int split)
+ {
+  if (m_QueueDepth == 0 || !m_SplitFunction || m_ConsecutiveMisses >= 2)
+    return;
+
+  const unsigned int nbOfSplits = m_NumberOfSplitsFunction();
+  const unsigned int lastSplit = std::min(split + m_QueueDepth, nbOfSplits - 1);
+  m_NextScheduledSplit = std::max(m_NextScheduledSplit, split + 1);
+  if (m_NextScheduledSplit > lastSplit)
+    return;
+
+  {
+  std::unique_lock<std::mutex> lock(m_Mutex);
+  for ( ; m_NextScheduledSplit <= lastSplit ; m_NextScheduledSplit++)
+    {
+    Job * job = new Job;
+    job->region = GetSplitRequestedRegion(m_NextScheduledSplit);
+    job->split = m_NextScheduledSplit;
+    job->running = false;
+    job->done = false;
+    m_Jobs.push_back(job);
+    }
+
+  if (!m_Worker.joinable())
+    m_Worker = std::thread(&Self::WorkerLoop, this);
+  }
+  m_Condition.notify_all();
+ }
+
+/*
+ * The upstream information is never updated while the worker is running
+ */
+template <class TImage>
+void
+PrefetchImageFilter<TImage>
+::UpdateOutputInformation()
+ {
+  DrainJobs();
+  Superclass::UpdateOutputInformation();
+ }
+
+template <class TImage>
+void
+PrefetchImageFilter<TImage>
+::PropagateRequestedRegion(itk::DataObject * output)
+ {
+  const ImageRegionType requestedRegion = this->GetOutput()->GetRequestedRegion();
+  {
+  std::unique_lock<std::mutex> lock(m_Mutex);
+  for (unsigned int i = 0 ; i < m_Jobs.size() ; i++)
+    {
+    if (m_Jobs[i]->region.IsInside(requestedRegion))
+      {
+      // Served from a prefetched tile: upstream filters must not be touched
+      return;
+      }
+    }
+  }
+
+  DrainJobs();
+  Superclass::PropagateRequestedRegion(output);
+ }
+
+template <class TImage>
+void
+PrefetchImageFilter<TImage>
+::UpdateOutputData(itk::DataObject * output)
+ {
+  ImageType * outputImage = this->GetOutput();
+  const ImageRegionType requestedRegion = outputImage->GetRequestedRegion();
+
+  // Look for a prefetched tile containing the requested region
+  Job * job = NULL;
+  {
+  std::unique_lock<std::mutex> lock(m_Mutex);
+  for (unsigned int i = 0 ; i < m_Jobs.size() ; i++)
+    {
+    if (m_Jobs[i]->region.IsInside(requestedRegion))
+      {
+      m_Condition.wait(lock, [this, i]{ return m_NextJob > i; });
+
+      // Drop the tiles which precede this one
+      for (unsigned int j = 0 ; j < i ; j++)
+        {
+        delete m_Jobs.front();
+        m_Jobs.pop_front();
+        }
+      job = m_Jobs.front();
+      m_Jobs.pop_front();
+      m_NextJob -= i + 1;
+      break;
+      }
+    }
+  }
+
+  // The k-th request of the streaming is the k-th split of the consumer
+  const unsigned int split = m_NumberOfRequests++;
+  const bool isSplit = m_SplitFunction && split < m_NumberOfSplitsFunction();
+
+  if (job != NULL)
+    {
+    m_ConsecutiveMisses = 0;
+    std::exception_ptr error = job->error;
+    ImagePointer buffer = job->buffer;
+    delete job;
+    if (error)
+      {
+      DrainJobs();
+      std::rethrow_exception(error);
+      }
+
+    this->InvokeEvent(itk::StartEvent());
+    buffer->SetRequestedRegion(requestedRegion);
+    this->GraftOutput(buffer);
+    this->UpdateProgress(1.0);
+    this->InvokeEvent(itk::EndEvent());
+    output->DataHasBeenGenerated();
+    }
+  else
+    {
+    if (split > 0 && m_NextScheduledSplit > split)
+      {
+      // This split was prefetched, with a wrong region
+      m_ConsecutiveMisses++;
+      }
+    DrainJobs();
+    m_NextScheduledSplit = split + 1;
+    Superclass::UpdateOutputData(output);
+    }
+
+  if (isSplit)
+    {
+    UpdateSplitOffsets(split, requestedRegion);
+    SchedulePrefetch(split);
+    }
+ }
+
+/**
+ * Synchronous path: copy the input requested region
+ */
+template <class TImage>
+void
+PrefetchImageFilter<TImage>
+::GenerateData()
+ {
+  // Copy (rather than graft) since the worker will overwrite the upstream buffer
+  ImagePointer buffer = CopyInputRegion(this->GetOutput()->GetRequestedRegion());
+  this->GraftOutput(buffer);
+ }
+
+}
+#endif
@@ -0,0 +1,159 @@
+/*=========================================================================
+
+  Copyright (c) Remi Cresson (IRSTEA). All rights reserved.
+
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef StreamingCOGWriter_H_
+#define StreamingCOGWriter_H_
+
+#include "itkProcessObject.h"
+#include "otbRAMDrivenAdaptativeStreamingManager.h"
+#include "otbTileDimensionTiledStreamingManager.h"
+
+#include <string>
+#include <vector>
+#include <map>
+#include <utility>
+
+class GDALDataset;
+
+namespace otb
+{
+
+/**
+ * \class StreamingCOGWriter
+ * \brief Write an image as a quantized, compressed, Cloud-Optimized GeoTIFF
+ *
+ * Pixels are quantized to 8 bits (value * m_Scale, rounded and clamped to
+ * [0, 255]), and streamed in tiles aligned on the GeoTIFF blocks into a
+ * temporary tiled GeoTIFF (next to the output file). The overviews
+ * (nearest neighbor decimation by powers of 2, suited to label images) are
+ * computed from each streamed tile, so no extra pass over the image is
+ * needed to build them. An overview block is accumulated in memory until
+ * all its pixels have been received, then written once. At most one row of
+ * blocks per overview level is kept in memory.
+ *
+ * In the temporary file, full resolution and overview blocks are
+ * interleaved in the order they are completed. The temporary file is then
+ * copied in the output file with the COG driver of GDAL (GDAL >= 3.1), or
+ * with the GTiff driver and COPY_SRC_OVERVIEWS=YES otherwise, which both
+ * reuse its overviews: the output has the COG layout (headers first, then
+ * the blocks from the smallest overview to the full resolution). The
+ * blocks are compressed on GDAL worker threads (NUM_THREADS=ALL_CPUS), and
+ * the temporary file is removed.
+ *
+ * \ingroup ClearCutsDetection
+ */
+template <class TInputImage>
+class ITK_EXPORT StreamingCOGWriter : public itk::ProcessObject
+{
+
+public:
+
+  /** Standard class typedefs. */
+  typedef StreamingCOGWriter            Self;
+  typedef itk::ProcessObject            Superclass;
+  typedef itk::SmartPointer<Self>       Pointer;
+  typedef itk::SmartPointer<const Self> ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(StreamingCOGWriter, itk::ProcessObject);
+
+  /** Image typedefs */
+  typedef TInputImage                              InputImageType;
+  typedef typename InputImageType::RegionType      RegionType;
+  typedef typename InputImageType::IndexType       IndexType;
+  typedef typename InputImageType::InternalPixelType InternalPixelType;
+  typedef otb::RAMDrivenAdaptativeStreamingManager<InputImageType> RAMStreamingManagerType;
+  typedef otb::TileDimensionTiledStreamingManager<InputImageType>  TileStreamingManagerType;
+
+  /** Input image */
+  using Superclass::SetInput;
+  virtual void SetInput(const InputImageType * input);
+  const InputImageType * GetInput();
+
+  /** Output file name */
+  itkSetStringMacro(FileName);
+  itkGetStringMacro(FileName);
+
+  /** GDAL compression method (DEFLATE, LZW, ZSTD...) */
+  itkSetStringMacro(Compression);
+  itkGetStringMacro(Compression);
+
+  /** Size of the GeoTIFF blocks */
+  itkSetMacro(BlockSize, unsigned int);
+  itkGetMacro(BlockSize, unsigned int);
+
+  /** Quantization scale */
+  itkSetMacro(Scale, double);
+  itkGetMacro(Scale, double);
+
+  /** RAM used by the streaming (Mb) */
+  itkSetMacro(AvailableRAM, unsigned int);
+  itkGetMacro(AvailableRAM, unsigned int);
+
+  /** Streaming manager of the tiles, prepared by Update() */
+  itkGetObjectMacro(StreamingManager, TileStreamingManagerType);
+
+  /** Write the image */
+  virtual void Update();
+
+protected:
+  StreamingCOGWriter();
+  virtual ~StreamingCOGWriter() {};
+
+  /** Number of overviews: until the smallest one fits in one block */
+  unsigned int ComputeNumberOfOverviews(const RegionType & region) const;
+
+  /** An overview block being filled by the streamed tiles */
+  struct OverviewBlock
+  {
+    std::vector<unsigned char> pixels;    // pixel interleaved
+    unsigned long              remaining; // pixels not received yet
+  };
+  typedef std::map<std::pair<long, long>, OverviewBlock> OverviewBlockMapType;
+
+  /** Quantize and write one streamed tile, and accumulate its overviews */
+  void WriteTile(GDALDataset * dataset, const RegionType & region,
+      std::vector<OverviewBlockMapType> & overviewBlocks);
+
+  /** Copy the overview pixels of a tile in the overview blocks, and write
+   * the blocks which are complete */
+  void AccumulateOverview(GDALDataset * dataset, unsigned int level, const std::vector<unsigned char> & buffer,
+      long x0, long y0, unsigned int width, unsigned int height, OverviewBlockMapType & overviewBlocks);
+
+  /** Copy the streamed file, with its overviews, in the output file */
+  void CopyToCOG(GDALDataset * dataset);
+
+  /** GDAL progress of the copy, reported as the end of the writer progress */
+  static int CopyProgress(double complete, const char * message, void * writer);
+
+private:
+  StreamingCOGWriter(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+  std::string  m_FileName;
+  std::string  m_Compression;
+  unsigned int m_BlockSize;
+  double       m_Scale;
+  unsigned int m_AvailableRAM;
+
+  typename TileStreamingManagerType::Pointer m_StreamingManager;
+
+};
+
+
+} // end namespace otb
+
+#include "otbStreamingCOGWriter.hxx"
+
+
+#endif /* StreamingCOGWriter_H_ */
@@ -0,0 +1,372 @@
+/*=========================================================================
+
+  Copyright (c) Remi Cresson (IRSTEA). All rights reserved.
+
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef __StreamingCOGWriter_hxx
+#define __StreamingCOGWriter_hxx
+
+#include "otbStreamingCOGWriter.h"
+#include "itkMacro.h"
+
+#include "gdal_priv.h"
+#include "cpl_string.h"
+#include "cpl_vsi.h"
+
+#include <cmath>
+#include <algorithm>
+#include <vector>
+#include <sstream>
+
+namespace otb
+{
+/**
+ *
+ */
+template <class TInputImage>
+StreamingCOGWriter<TInputImage>
+::StreamingCOGWriter()
+ {
+  this->SetNumberOfRequiredInputs(1);
+  m_Compression = "DEFLATE";
+  m_BlockSize = 512;
+  m_Scale = 1.0;
+  m_AvailableRAM = 128;
+  m_StreamingManager = TileStreamingManagerType::New();
+ }
+
+template <class TInputImage>
+void
+StreamingCOGWriter<TInputImage>
+::SetInput(const InputImageType * input)
+ {
+  this->itk::ProcessObject::SetNthInput(0, const_cast<InputImageType *>(input));
+ }
+
+template <class TInputImage>
+const typename StreamingCOGWriter<TInputImage>::InputImageType *
+StreamingCOGWriter<TInputImage>
+::GetInput()
+ {
+  return static_cast<const InputImageType *>(this->itk::ProcessObject::GetInput(0));
+ }
+
+template <class TInputImage>
+unsigned int
+StreamingCOGWriter<TInputImage>
+::ComputeNumberOfOverviews(const RegionType & region) const
+ {
+  unsigned int nbOfOverviews = 0;
+  unsigned long factor = 1;
+  while (region.GetSize(0) / factor > m_BlockSize || region.GetSize(1) / factor > m_BlockSize)
+    {
+    factor *= 2;
+    nbOfOverviews++;
+    }
+  return nbOfOverviews;
+ }
+
+/*
+ * Quantize a tile, write it in the full resolution level, then copy the
+ * overview pixels whose source pixel (nearest neighbor) lies in this tile
+ */
+template <class TInputImage>
+void
+StreamingCOGWriter<TInputImage>
+::WriteTile(GDALDataset * dataset, const RegionType & region,
+    std::vector<OverviewBlockMapType> & overviewBlocks)
+ {
+  const InputImageType * inputImage = this->GetInput();
+  const unsigned int nbOfBands = inputImage->GetNumberOfComponentsPerPixel();
+  const IndexType origin = inputImage->GetLargestPossibleRegion().GetIndex();
+  const unsigned int width = region.GetSize(0);
+  const unsigned int height = region.GetSize(1);
+  const long x0 = region.GetIndex(0) - origin[0];
+  const long y0 = region.GetIndex(1) - origin[1];
+
+  // Quantize (pixel interleaved)
+  std::vector<GByte> buffer(static_cast<size_t>(width) * height * nbOfBands);
+  for (unsigned int y = 0 ; y < height ; y++)
+    {
+    IndexType rowIndex = region.GetIndex();
+    rowIndex[1] += y;
+    const InternalPixelType * inputPtr = inputImage->GetBufferPointer()
+        + inputImage->ComputeOffset(rowIndex) * nbOfBands;
+    GByte * outputPtr = &buffer[static_cast<size_t>(y) * width * nbOfBands];
+    for (unsigned int k = 0 ; k < width * nbOfBands ; k++)
+      {
+      const double value = vcl_floor(static_cast<double>(inputPtr[k]) * m_Scale + 0.5);
+      outputPtr[k] = (value > 0.0) ? ((value < 255.0) ? static_cast<GByte>(value) : 255) : 0;
+      }
+    }
+
+  // Tiles are aligned on the blocks: each full resolution block is written whole
+  if (dataset->RasterIO(GF_Write, x0, y0, width, height, &buffer[0], width, height,
+      GDT_Byte, nbOfBands, NULL, nbOfBands, width * nbOfBands, 1) != CE_None)
+    {
+    itkExceptionMacro("Unable to write tile " << region << " in " << m_FileName);
+    }
+
+  for (unsigned int level = 0 ; level < overviewBlocks.size() ; level++)
+    {
+    AccumulateOverview(dataset, level, buffer, x0, y0, width, height, overviewBlocks[level]);
+    }
+ }
+
+/*
+ * Overview pixels (ox, oy) of the tile are the ones such as (ox * factor,
+ * oy * factor) is in the tile. They are copied in their overview blocks,
+ * and a block is written as soon as it is complete.
+ */
+template <class TInputImage>
+void
+StreamingCOGWriter<TInputImage>
+::AccumulateOverview(GDALDataset * dataset, unsigned int level, const std::vector<unsigned char> & buffer,
+    long x0, long y0, unsigned int width, unsigned int height, OverviewBlockMapType & overviewBlocks)
+ {
+  const unsigned int nbOfBands = dataset->GetRasterCount();
+  const long factor = 1L << (level + 1);
+  const long blockSize = m_BlockSize;
+
+  const long ox0 = (x0 + factor - 1) / factor;
+  const long ox1 = (x0 + width - 1) / factor;
+  const long oy0 = (y0 + factor - 1) / factor;
+  const long oy1 = (y0 + height - 1) / factor;
+  if (ox1 < ox0 || oy1 < oy0)
+    return;
+
+  GDALRasterBand * firstOverviewBand = dataset->GetRasterBand(1)->GetOverview(level);
+  if (firstOverviewBand == NULL)
+    {
+    itkExceptionMacro("Unable to write overview " << level << " in " << m_FileName);
+    }
+  const long overviewWidth = firstOverviewBand->GetXSize();
+  const long overviewHeight = firstOverviewBand->GetYSize();
+
+  for (long by = oy0 / blockSize ; by <= oy1 / blockSize ; by++)
+    {
+    for (long bx = ox0 / blockSize ; bx <= ox1 / blockSize ; bx++)
+      {
+      // Block extent, clipped to the overview
+      const long blockX = bx * blockSize;
+      const long blockY = by * blockSize;
+      const long blockWidth = std::min(blockSize, overviewWidth - blockX);
+      const long blockHeight = std::min(blockSize, overviewHeight - blockY);
+
+      OverviewBlock & block = overviewBlocks[std::make_pair(bx, by)];
+      if (block.pixels.empty())
+        {
+        block.pixels.assign(static_cast<size_t>(blockWidth) * blockHeight * nbOfBands, 0);
+        block.remaining = blockWidth * blockHeight;
+        }
+
+      // Part of the block covered by the tile
+      const long startX = std::max(ox0, blockX);
+      const long endX = std::min(ox1, blockX + blockWidth - 1);
+      const long startY = std::max(oy0, blockY);
+      const long endY = std::min(oy1, blockY + blockHeight - 1);
+      for (long oy = startY ; oy <= endY ; oy++)
+        {
+        const size_t row = oy * factor - y0;
+        for (long ox = startX ; ox <= endX ; ox++)
+          {
+          const size_t col = ox * factor - x0;
+          const GByte * inputPtr = &buffer[(row * width + col) * nbOfBands];
+          GByte * outputPtr = &block.pixels[((oy - blockY) * blockWidth + (ox - blockX)) * nbOfBands];
+          for (unsigned int band = 0 ; band < nbOfBands ; band++)
+            outputPtr[band] = inputPtr[band];
+          }
+        }
+      block.remaining -= (endX - startX + 1) * (endY - startY + 1);
+
+      if (block.remaining == 0)
+        {
+        for (unsigned int band = 0 ; band < nbOfBands ; band++)
+          {
+          GDALRasterBand * overviewBand = dataset->GetRasterBand(band + 1)->GetOverview(level);
+          if (overviewBand == NULL || overviewBand->RasterIO(GF_Write, blockX, blockY, blockWidth, blockHeight,
+              &block.pixels[band], blockWidth, blockHeight, GDT_Byte, nbOfBands, blockWidth * nbOfBands) != CE_None)
+            {
+            itkExceptionMacro("Unable to write overview " << level << " in " << m_FileName);
+            }
+          }
+        overviewBlocks.erase(std::make_pair(bx, by));
+        }
+      }
+    }
+ }
+
+/*
+ * Writer progress: the streaming is the first half, the copy the second one
+ */
+template <class TInputImage>
+int
+StreamingCOGWriter<TInputImage>
+::CopyProgress(double complete, const char * itkNotUsed(message), void * writer)
+ {
+  static_cast<Self *>(writer)->UpdateProgress(0.5 + 0.5 * complete);
+  return TRUE;
+ }
+
+/*
+ * Copy the streamed file in the output file with the COG layout. The
+ * overviews of the streamed file are reused by both drivers.
+ */
+template <class TInputImage>
+void
+StreamingCOGWriter<TInputImage>
+::CopyToCOG(GDALDataset * dataset)
+ {
+  std::ostringstream blockSize;
+  blockSize << m_BlockSize;
+  char ** options = NULL;
+  GDALDriver * driver = GetGDALDriverManager()->GetDriverByName("COG");
+  if (driver != NULL)
+    {
+    options = CSLSetNameValue(options, "BLOCKSIZE", blockSize.str().c_str());
+    options = CSLSetNameValue(options, "OVERVIEWS", "AUTO");
+    options = CSLSetNameValue(options, "RESAMPLING", "NEAREST");
+    }
+  else
+    {
+    driver = GetGDALDriverManager()->GetDriverByName("GTiff");
+    options = CSLSetNameValue(options, "TILED", "YES");
+    options = CSLSetNameValue(options, "BLOCKXSIZE", blockSize.str().c_str());
+    options = CSLSetNameValue(options, "BLOCKYSIZE", blockSize.str().c_str());
+    options = CSLSetNameValue(options, "COPY_SRC_OVERVIEWS", "YES");
+    }
+  options = CSLSetNameValue(options, "COMPRESS", m_Compression.c_str());
+  options = CSLSetNameValue(options, "NUM_THREADS", "ALL_CPUS");
+  options = CSLSetNameValue(options, "BIGTIFF", "IF_SAFER");
+
+  GDALDataset * cogDataset = driver->CreateCopy(m_FileName.c_str(), dataset, FALSE, options,
+      &Self::CopyProgress, this);
+  CSLDestroy(options);
+  if (cogDataset == NULL)
+    {
+    itkExceptionMacro("Unable to write " << m_FileName);
+    }
+  GDALClose(cogDataset);
+ }
+
+/**
+ *
+ */
+template <class TInputImage>
+void
+StreamingCOGWriter<TInputImage>
+::Update()
+ {
+  InputImageType * inputImage = const_cast<InputImageType *>(this->GetInput());
+  if (inputImage == NULL)
+    {
+    itkExceptionMacro("No input image");
+    }
+  if (m_FileName.empty())
+    {
+    itkExceptionMacro("No output file name");
+    }
+
+  this->InvokeEvent(itk::StartEvent());
+  this->UpdateProgress(0.0);
+
+  inputImage->UpdateOutputInformation();
+  const RegionType largestRegion = inputImage->GetLargestPossibleRegion();
+  const unsigned int nbOfBands = inputImage->GetNumberOfComponentsPerPixel();
+  const unsigned int nbOfOverviews = ComputeNumberOfOverviews(largestRegion);
+
+  // Streamed tiles are aligned on the GeoTIFF blocks, and fit in the available RAM
+  typename RAMStreamingManagerType::Pointer ramStreamingManager = RAMStreamingManagerType::New();
+  ramStreamingManager->SetAvailableRAMInMB(m_AvailableRAM);
+  ramStreamingManager->PrepareStreaming(inputImage, largestRegion);
+  const double pixelsPerSplit = static_cast<double>(largestRegion.GetNumberOfPixels())
+      / ramStreamingManager->GetNumberOfSplits();
+  unsigned int tileDimension = m_BlockSize * static_cast<unsigned int>(vcl_sqrt(pixelsPerSplit) / m_BlockSize);
+  if (tileDimension < m_BlockSize)
+    tileDimension = m_BlockSize;
+
+  m_StreamingManager->SetTileDimension(tileDimension);
+  m_StreamingManager->PrepareStreaming(inputImage, largestRegion);
+  const unsigned int nbOfSplits = m_StreamingManager->GetNumberOfSplits();
+
+  // Temporary tiled, compressed GeoTIFF, with empty internal overviews
+  GDALAllRegister();
+  const std::string streamedFileName = m_FileName + ".streamed.tif";
+  std::ostringstream blockSize;
+  blockSize << m_BlockSize;
+  char ** options = NULL;
+  options = CSLSetNameValue(options, "TILED", "YES");
+  options = CSLSetNameValue(options, "BLOCKXSIZE", blockSize.str().c_str());
+  options = CSLSetNameValue(options, "BLOCKYSIZE", blockSize.str().c_str());
+  options = CSLSetNameValue(options, "COMPRESS", m_Compression.c_str());
+  options = CSLSetNameValue(options, "NUM_THREADS", "ALL_CPUS");
+  options = CSLSetNameValue(options, "BIGTIFF", "IF_SAFER");
+  GDALDriver * driver = GetGDALDriverManager()->GetDriverByName("GTiff");
+  GDALDataset * dataset = driver->Create(streamedFileName.c_str(), largestRegion.GetSize(0),
+      largestRegion.GetSize(1), nbOfBands, GDT_Byte, options);
+  CSLDestroy(options);
+  if (dataset == NULL)
+    {
+    itkExceptionMacro("Unable to create " << streamedFileName);
+    }
+
+  // Geo-referencing (origin is the center of the first pixel)
+  const typename InputImageType::PointType origin = inputImage->GetOrigin();
+  const typename InputImageType::SpacingType spacing = inputImage->GetSignedSpacing();
+  double geoTransform[6] = {origin[0] - 0.5 * spacing[0], spacing[0], 0.0,
+      origin[1] - 0.5 * spacing[1], 0.0, spacing[1]};
+  dataset->SetGeoTransform(geoTransform);
+  dataset->SetProjection(inputImage->GetProjectionRef().c_str());
+
+  if (nbOfOverviews > 0)
+    {
+    std::vector<int> factors;
+    for (unsigned int level = 0 ; level < nbOfOverviews ; level++)
+      factors.push_back(1 << (level + 1));
+    if (dataset->BuildOverviews("NONE", nbOfOverviews, &factors[0], 0, NULL, NULL, NULL) != CE_None)
+      {
+      GDALClose(dataset);
+      VSIUnlink(streamedFileName.c_str());
+      itkExceptionMacro("Unable to create overviews in " << streamedFileName);
+      }
+    }
+
+  // Stream, then rewrite with the COG layout. The streamed file is removed
+  // in any case.
+  try
+    {
+    std::vector<OverviewBlockMapType> overviewBlocks(nbOfOverviews);
+    for (unsigned int split = 0 ; split < nbOfSplits ; split++)
+      {
+      RegionType region = m_StreamingManager->GetSplit(split);
+      inputImage->SetRequestedRegion(region);
+      inputImage->PropagateRequestedRegion();
+      inputImage->UpdateOutputData();
+
+      WriteTile(dataset, region, overviewBlocks);
+
+      this->UpdateProgress(0.5 * (split + 1) / nbOfSplits);
+      }
+
+    dataset->FlushCache();
+    CopyToCOG(dataset);
+    }
+  catch (...)
+    {
+    GDALClose(dataset);
+    VSIUnlink(streamedFileName.c_str());
+    throw;
+    }
+  GDALClose(dataset);
+  VSIUnlink(streamedFileName.c_str());
+
+  this->InvokeEvent(itk::EndEvent());
+ }
+
+}
+#endif
@@ -0,0 +1,162 @@
+/*=========================================================================
+
+  Copyright (c) Remi Cresson (IRSTEA). All rights reserved.
+
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef StreamingCoarseCandidatesFilter_H_
+#define StreamingCoarseCandidatesFilter_H_
+
+#include "otbPersistentImageFilter.h"
+#include "otbPersistentFilterStreamingDecorator.h"
+#include "otbCandidateBlocksImageFilter.h"
+
+#include <vector>
+
+namespace otb
+{
+
+/**
+ * \class PersistentCoarseCandidatesFilter
+ * \brief Mark the candidate blocks around the pixels of a coarse image below a threshold
+ *
+ * Each pixel of the (coarse) input image whose value is lower than
+ * m_Threshold marks as candidates the blocks of a CandidateBlocksImageFilter
+ * (at full resolution) which intersect its footprint, plus m_Margin full
+ * resolution pixels. The coarse image is streamed: only the candidate
+ * pixels of the current tile are kept in memory.
+ *
+ * The input image is passed through as output.
+ *
+ * \ingroup ClearCutsDetection
+ */
+template <class TImage>
+class ITK_EXPORT PersistentCoarseCandidatesFilter :
+public PersistentImageFilter<TImage, TImage>
+{
+
+public:
+
+  /** Standard class typedefs. */
+  typedef PersistentCoarseCandidatesFilter        Self;
+  typedef PersistentImageFilter<TImage, TImage>   Superclass;
+  typedef itk::SmartPointer<Self>                 Pointer;
+  typedef itk::SmartPointer<const Self>           ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(PersistentCoarseCandidatesFilter, PersistentImageFilter);
+
+  /** Image typedefs */
+  typedef TImage                                         ImageType;
+  typedef typename ImageType::RegionType                 RegionType;
+  typedef typename ImageType::IndexType                  IndexType;
+  typedef typename ImageType::PixelType                  PixelType;
+  typedef CandidateBlocksImageFilter<TImage>             CandidateBlocksFilterType;
+  typedef std::vector<IndexType>                         IndexListType;
+
+  /** Coarse pixels lower than the threshold are candidates */
+  itkSetMacro(Threshold, double);
+  itkGetMacro(Threshold, double);
+
+  /** Margin around the footprint of the candidate pixels (full resolution pixels) */
+  itkSetMacro(Margin, double);
+  itkGetMacro(Margin, double);
+
+  /** Filter whose blocks are marked. Its input information must be up to date. */
+  void SetCandidateBlocksFilter(CandidateBlocksFilterType * filter) { m_CandidateBlocksFilter = filter; }
+
+  /** Number of coarse candidate pixels */
+  itkGetMacro(NumberOfCandidatePixels, unsigned long);
+
+  /** Persistent filter methods */
+  virtual void Reset(void);
+  virtual void Synthetize(void) {}
+
+protected:
+  PersistentCoarseCandidatesFilter();
+  virtual ~PersistentCoarseCandidatesFilter() {};
+
+  virtual void AllocateOutputs();
+  virtual void GenerateOutputInformation();
+
+  virtual void ThreadedGenerateData(const RegionType& outputRegionForThread,
+      itk::ThreadIdType threadId);
+
+  virtual void AfterThreadedGenerateData();
+
+private:
+  PersistentCoarseCandidatesFilter(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+  double                                      m_Threshold;
+  double                                      m_Margin;
+  typename CandidateBlocksFilterType::Pointer m_CandidateBlocksFilter;
+  unsigned long                               m_NumberOfCandidatePixels;
+
+  std::vector<IndexListType>                  m_ThreadCandidates;
+
+};
+
+/**
+ * \class StreamingCoarseCandidatesFilter
+ * \brief Streamed version of PersistentCoarseCandidatesFilter
+ *
+ * \ingroup ClearCutsDetection
+ */
+template <class TImage>
+class ITK_EXPORT StreamingCoarseCandidatesFilter :
+public PersistentFilterStreamingDecorator<PersistentCoarseCandidatesFilter<TImage> >
+{
+
+public:
+
+  /** Standard class typedefs. */
+  typedef StreamingCoarseCandidatesFilter Self;
+  typedef PersistentFilterStreamingDecorator
+      <PersistentCoarseCandidatesFilter<TImage> >   Superclass;
+  typedef itk::SmartPointer<Self>                   Pointer;
+  typedef itk::SmartPointer<const Self>             ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(StreamingCoarseCandidatesFilter, PersistentFilterStreamingDecorator);
+
+  typedef TImage                                          InputImageType;
+  typedef typename Superclass::FilterType                 CandidatesFilterType;
+  typedef typename CandidatesFilterType::CandidateBlocksFilterType CandidateBlocksFilterType;
+
+  using Superclass::SetInput;
+  void SetInput(InputImageType * input) { this->GetFilter()->SetInput(input); }
+  const InputImageType * GetInput() { return this->GetFilter()->GetInput(); }
+
+  void SetThreshold(double value) { this->GetFilter()->SetThreshold(value); }
+  void SetMargin(double value) { this->GetFilter()->SetMargin(value); }
+  void SetCandidateBlocksFilter(CandidateBlocksFilterType * filter) { this->GetFilter()->SetCandidateBlocksFilter(filter); }
+
+  unsigned long GetNumberOfCandidatePixels() { return this->GetFilter()->GetNumberOfCandidatePixels(); }
+
+protected:
+  StreamingCoarseCandidatesFilter() {};
+  virtual ~StreamingCoarseCandidatesFilter() {};
+
+private:
+  StreamingCoarseCandidatesFilter(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+};
+
+} // end namespace otb
+
+#include "otbStreamingCoarseCandidatesFilter.hxx"
+
+
+#endif /* StreamingCoarseCandidatesFilter_H_ */
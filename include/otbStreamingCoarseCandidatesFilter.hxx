@@ -0,0 +1,147 @@
+/*=========================================================================
+
+  Copyright (c) Remi Cresson (IRSTEA). All rights reserved.
+
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef __StreamingCoarseCandidatesFilter_hxx
+#define __StreamingCoarseCandidatesFilter_hxx
+
+#include "otbStreamingCoarseCandidatesFilter.h"
+#include "itkProgressReporter.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
+#include "itkContinuousIndex.h"
+
+namespace otb
+{
+
+/**
+ *
+ */
+template <class TImage>
+PersistentCoarseCandidatesFilter<TImage>
+::PersistentCoarseCandidatesFilter()
+ {
+  m_Threshold = 0.0;
+  m_Margin = 0.0;
+  m_NumberOfCandidatePixels = 0;
+ }
+
+/*
+ * The input image is passed through as output
+ */
+template <class TImage>
+void
+PersistentCoarseCandidatesFilter<TImage>
+::AllocateOutputs()
+ {
+  ImageType * inputImage = const_cast<ImageType *>(this->GetInput());
+  this->GraftOutput(inputImage);
+ }
+
+template <class TImage>
+void
+PersistentCoarseCandidatesFilter<TImage>
+::GenerateOutputInformation()
+ {
+  Superclass::GenerateOutputInformation();
+  if (this->GetInput())
+    {
+    this->GetOutput()->CopyInformation(this->GetInput());
+    this->GetOutput()->SetLargestPossibleRegion(this->GetInput()->GetLargestPossibleRegion());
+
+    if (this->GetOutput()->GetRequestedRegion().GetNumberOfPixels() == 0)
+      {
+      this->GetOutput()->SetRequestedRegion(this->GetOutput()->GetLargestPossibleRegion());
+      }
+    }
+ }
+
+template <class TImage>
+void
+PersistentCoarseCandidatesFilter<TImage>
+::Reset()
+ {
+  if (m_CandidateBlocksFilter.IsNull())
+    {
+    itkExceptionMacro("The candidate blocks filter must be set");
+    }
+  m_ThreadCandidates.clear();
+  m_ThreadCandidates.resize(this->GetNumberOfThreads());
+  m_NumberOfCandidatePixels = 0;
+ }
+
+/*
+ * Mark the blocks around the candidate pixels of the tile
+ */
+template <class TImage>
+void
+PersistentCoarseCandidatesFilter<TImage>
+::AfterThreadedGenerateData()
+ {
+  const ImageType * coarseImage = this->GetInput();
+  const ImageType * fullImage = m_CandidateBlocksFilter->GetInput();
+
+  // Footprint of a coarse pixel in the full resolution image, plus the margin
+  const typename ImageType::SpacingType coarseSpacing = coarseImage->GetSignedSpacing();
+  const typename ImageType::SpacingType fullSpacing = fullImage->GetSignedSpacing();
+  double radius[2];
+  for (unsigned int dim = 0 ; dim < 2 ; dim++)
+    radius[dim] = 0.5 * vnl_math_abs(coarseSpacing[dim] / fullSpacing[dim]) + m_Margin;
+
+  for (unsigned int i = 0 ; i < m_ThreadCandidates.size() ; i++)
+    {
+    for (unsigned int j = 0 ; j < m_ThreadCandidates[i].size() ; j++)
+      {
+      typename ImageType::PointType point;
+      coarseImage->TransformIndexToPhysicalPoint(m_ThreadCandidates[i][j], point);
+      itk::ContinuousIndex<double, 2> center;
+      fullImage->TransformPhysicalPointToContinuousIndex(point, center);
+
+      RegionType candidateRegion;
+      for (unsigned int dim = 0 ; dim < 2 ; dim++)
+        {
+        const long lower = static_cast<long>(vcl_floor(center[dim] - radius[dim]));
+        const long upper = static_cast<long>(vcl_ceil(center[dim] + radius[dim]));
+        candidateRegion.SetIndex(dim, lower);
+        candidateRegion.SetSize(dim, upper - lower + 1);
+        }
+      m_CandidateBlocksFilter->AddCandidateRegion(candidateRegion);
+      }
+    m_NumberOfCandidatePixels += m_ThreadCandidates[i].size();
+    m_ThreadCandidates[i].clear();
+    }
+ }
+
+/**
+ *
+ */
+template <class TImage>
+void
+PersistentCoarseCandidatesFilter<TImage>
+::ThreadedGenerateData(const RegionType& outputRegionForThread, itk::ThreadIdType threadId)
+ {
+
+  // Debug info
+  itkDebugMacro(<<"Actually executing thread " << threadId << " in region " << outputRegionForThread);
+
+  // Support progress methods/callbacks
+  itk::ProgressReporter progress(this, threadId, outputRegionForThread.GetNumberOfPixels() );
+
+  IndexListType & candidates = m_ThreadCandidates[threadId];
+  itk::ImageRegionConstIteratorWithIndex<ImageType> it(this->GetInput(), outputRegionForThread);
+  for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+    {
+    if (it.Get() < m_Threshold)
+      candidates.push_back(it.GetIndex());
+
+    progress.CompletedPixel();
+    }
+ }
+
+} // end namespace otb
+#endif
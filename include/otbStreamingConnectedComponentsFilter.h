@@ -0,0 +1,167 @@
+/*=========================================================================
+
+  Copyright (c) Remi Cresson (IRSTEA). All rights reserved.
+
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef StreamingConnectedComponentsFilter_H_
+#define StreamingConnectedComponentsFilter_H_
+
+#include "otbPersistentImageFilter.h"
+#include "otbPersistentFilterStreamingDecorator.h"
+#include "otbConnectedComponentsRunTable.h"
+
+#include <vector>
+
+namespace otb
+{
+
+/**
+ * \class PersistentConnectedComponentsFilter
+ * \brief Compute the global connected components of a label image
+ *
+ * Each streamed tile is split in runs of pixels of the same label (no-data
+ * pixels excepted), which are added to a ConnectedComponentsRunTable. The
+ * table resolves the components across the tiles, so that no halo is
+ * requested around the tiles. Components are final after Synthetize().
+ *
+ * When a value image is set (e.g. the dNDVI), the min and mean of its
+ * pixels are computed for each component, with its area and bounding box.
+ *
+ * The input image is passed through as output.
+ *
+ * \ingroup ClearCutsDetection
+ */
+template <class TInputImage, class TValueImage>
+class ITK_EXPORT PersistentConnectedComponentsFilter :
+public PersistentImageFilter<TInputImage, TInputImage>
+{
+
+public:
+
+  /** Standard class typedefs. */
+  typedef PersistentConnectedComponentsFilter             Self;
+  typedef PersistentImageFilter<TInputImage, TInputImage> Superclass;
+  typedef itk::SmartPointer<Self>                         Pointer;
+  typedef itk::SmartPointer<const Self>                   ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(PersistentConnectedComponentsFilter, PersistentImageFilter);
+
+  /** Image typedefs */
+  typedef TInputImage                                 ImageType;
+  typedef TValueImage                                 ValueImageType;
+  typedef typename ImageType::RegionType              RegionType;
+  typedef typename ImageType::IndexType               IndexType;
+  typedef typename ImageType::PixelType               PixelType;
+  typedef ConnectedComponentsRunTable<PixelType>      RunTableType;
+  typedef typename RunTableType::Run                  RunType;
+  typedef std::vector<RunType>                        RunListType;
+
+  itkSetMacro(NoDataPixel, PixelType);
+  itkGetMacro(NoDataPixel, PixelType);
+
+  /** 8-connectivity (true) or 4-connectivity (false, default) */
+  itkSetMacro(FullyConnected, bool);
+  itkGetMacro(FullyConnected, bool);
+
+  /** Optional image of the values summarized in the components attributes */
+  void SetValueImage(const ValueImageType * image);
+  const ValueImageType * GetValueImage() const;
+
+  /** Connected components */
+  const RunTableType & GetRunTable() const { return m_RunTable; }
+
+  /** Persistent filter methods */
+  virtual void Reset(void);
+  virtual void Synthetize(void);
+
+protected:
+  PersistentConnectedComponentsFilter();
+  virtual ~PersistentConnectedComponentsFilter() {};
+
+  virtual void AllocateOutputs();
+  virtual void GenerateOutputInformation();
+
+  virtual void ThreadedGenerateData(const RegionType& outputRegionForThread,
+      itk::ThreadIdType threadId);
+
+  virtual void AfterThreadedGenerateData();
+
+private:
+  PersistentConnectedComponentsFilter(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+  PixelType                m_NoDataPixel;
+  bool                     m_FullyConnected;
+
+  std::vector<RunListType> m_ThreadRuns;
+  RunTableType             m_RunTable;
+
+};
+
+/**
+ * \class StreamingConnectedComponentsFilter
+ * \brief Streamed version of PersistentConnectedComponentsFilter
+ *
+ * \ingroup ClearCutsDetection
+ */
+template <class TInputImage, class TValueImage>
+class ITK_EXPORT StreamingConnectedComponentsFilter :
+public PersistentFilterStreamingDecorator<PersistentConnectedComponentsFilter<TInputImage, TValueImage> >
+{
+
+public:
+
+  /** Standard class typedefs. */
+  typedef StreamingConnectedComponentsFilter Self;
+  typedef PersistentFilterStreamingDecorator
+      <PersistentConnectedComponentsFilter<TInputImage, TValueImage> > Superclass;
+  typedef itk::SmartPointer<Self>                         Pointer;
+  typedef itk::SmartPointer<const Self>                   ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(StreamingConnectedComponentsFilter, PersistentFilterStreamingDecorator);
+
+  typedef TInputImage                                   InputImageType;
+  typedef TValueImage                                   ValueImageType;
+  typedef typename Superclass::FilterType               ComponentsFilterType;
+  typedef typename ComponentsFilterType::PixelType      PixelType;
+  typedef typename ComponentsFilterType::RunTableType   RunTableType;
+
+  using Superclass::SetInput;
+  void SetInput(InputImageType * input) { this->GetFilter()->SetInput(input); }
+  const InputImageType * GetInput() { return this->GetFilter()->GetInput(); }
+
+  void SetNoDataPixel(PixelType value) { this->GetFilter()->SetNoDataPixel(value); }
+  void SetFullyConnected(bool flag) { this->GetFilter()->SetFullyConnected(flag); }
+  void SetValueImage(const ValueImageType * image) { this->GetFilter()->SetValueImage(image); }
+
+  const RunTableType & GetRunTable() const { return this->GetFilter()->GetRunTable(); }
+
+protected:
+  StreamingConnectedComponentsFilter() {};
+  virtual ~StreamingConnectedComponentsFilter() {};
+
+private:
+  StreamingConnectedComponentsFilter(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+};
+
+} // end namespace otb
+
+#include "otbStreamingConnectedComponentsFilter.hxx"
+
+
+#endif /* StreamingConnectedComponentsFilter_H_ */
@@ -0,0 +1,183 @@
+/*=========================================================================
+
+  Copyright (c) Remi Cresson (IRSTEA). All rights reserved.
+
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef __StreamingConnectedComponentsFilter_hxx
+#define __StreamingConnectedComponentsFilter_hxx
+
+#include "otbStreamingConnectedComponentsFilter.h"
+#include "itkProgressReporter.h"
+
+#include <algorithm>
+
+namespace otb
+{
+
+/**
+ *
+ */
+template <class TInputImage, class TValueImage>
+PersistentConnectedComponentsFilter<TInputImage, TValueImage>
+::PersistentConnectedComponentsFilter()
+ {
+  m_NoDataPixel = 0;
+  m_FullyConnected = false;
+ }
+
+template <class TInputImage, class TValueImage>
+void
+PersistentConnectedComponentsFilter<TInputImage, TValueImage>
+::SetValueImage(const ValueImageType * image)
+ {
+  this->itk::ProcessObject::SetNthInput(1, const_cast<ValueImageType *>(image));
+ }
+
+template <class TInputImage, class TValueImage>
+const typename PersistentConnectedComponentsFilter<TInputImage, TValueImage>::ValueImageType *
+PersistentConnectedComponentsFilter<TInputImage, TValueImage>
+::GetValueImage() const
+ {
+  if (this->GetNumberOfInputs() < 2)
+    return NULL;
+  return static_cast<const ValueImageType *>(this->itk::ProcessObject::GetInput(1));
+ }
+
+/*
+ * The input image is passed through as output
+ */
+template <class TInputImage, class TValueImage>
+void
+PersistentConnectedComponentsFilter<TInputImage, TValueImage>
+::AllocateOutputs()
+ {
+  ImageType * inputImage = const_cast<ImageType *>(this->GetInput());
+  this->GraftOutput(inputImage);
+ }
+
+template <class TInputImage, class TValueImage>
+void
+PersistentConnectedComponentsFilter<TInputImage, TValueImage>
+::GenerateOutputInformation()
+ {
+  Superclass::GenerateOutputInformation();
+  if (this->GetInput())
+    {
+    this->GetOutput()->CopyInformation(this->GetInput());
+    this->GetOutput()->SetLargestPossibleRegion(this->GetInput()->GetLargestPossibleRegion());
+
+    if (this->GetOutput()->GetRequestedRegion().GetNumberOfPixels() == 0)
+      {
+      this->GetOutput()->SetRequestedRegion(this->GetOutput()->GetLargestPossibleRegion());
+      }
+    }
+ }
+
+template <class TInputImage, class TValueImage>
+void
+PersistentConnectedComponentsFilter<TInputImage, TValueImage>
+::Reset()
+ {
+  m_ThreadRuns.clear();
+  m_ThreadRuns.resize(this->GetNumberOfThreads());
+  m_RunTable.Clear();
+  m_RunTable.SetFullyConnected(m_FullyConnected);
+ }
+
+template <class TInputImage, class TValueImage>
+void
+PersistentConnectedComponentsFilter<TInputImage, TValueImage>
+::Synthetize()
+ {
+  m_RunTable.Finalize();
+ }
+
+/*
+ * Add the runs of the threads to the table, in the order of the threads
+ */
+template <class TInputImage, class TValueImage>
+void
+PersistentConnectedComponentsFilter<TInputImage, TValueImage>
+::AfterThreadedGenerateData()
+ {
+  for (unsigned int i = 0 ; i < m_ThreadRuns.size() ; i++)
+    {
+    for (unsigned int j = 0 ; j < m_ThreadRuns[i].size() ; j++)
+      {
+      const RunType & run = m_ThreadRuns[i][j];
+      m_RunTable.AddRun(run.row, run.start, run.end, run.value, run.minValue, run.sumValue);
+      }
+    m_ThreadRuns[i].clear();
+    }
+ }
+
+/**
+ *
+ */
+template <class TInputImage, class TValueImage>
+void
+PersistentConnectedComponentsFilter<TInputImage, TValueImage>
+::ThreadedGenerateData(const RegionType& outputRegionForThread, itk::ThreadIdType threadId)
+ {
+
+  // Debug info
+  itkDebugMacro(<<"Actually executing thread " << threadId << " in region " << outputRegionForThread);
+
+  // Support progress methods/callbacks
+  itk::ProgressReporter progress(this, threadId, outputRegionForThread.GetSize(1) );
+
+  const ImageType * inputImage = this->GetInput();
+  const ValueImageType * valueImage = GetValueImage();
+  RunListType & runs = m_ThreadRuns[threadId];
+
+  const long xStart = outputRegionForThread.GetIndex(0);
+  const long xEnd = xStart + outputRegionForThread.GetSize(0);
+  for (unsigned int y = 0 ; y < outputRegionForThread.GetSize(1) ; y++)
+    {
+    IndexType index = outputRegionForThread.GetIndex();
+    index[1] += y;
+
+    // Split the row in runs
+    RunType run;
+    run.row = index[1];
+    long x = xStart;
+    while (x < xEnd)
+      {
+      index[0] = x;
+      const PixelType value = inputImage->GetPixel(index);
+      if (value == m_NoDataPixel)
+        {
+        x++;
+        continue;
+        }
+      run.start = x;
+      run.value = value;
+      run.minValue = 0.0;
+      run.sumValue = 0.0;
+      for ( ; x < xEnd ; x++)
+        {
+        index[0] = x;
+        if (inputImage->GetPixel(index) != value)
+          break;
+        if (valueImage != NULL)
+          {
+          const double pixelValue = static_cast<double>(valueImage->GetPixel(index));
+          run.minValue = (x == run.start) ? pixelValue : std::min(run.minValue, pixelValue);
+          run.sumValue += pixelValue;
+          }
+        }
+      run.end = x - 1;
+      runs.push_back(run);
+      }
+
+    progress.CompletedPixel();
+    } // Next row
+ }
+
+} // end namespace otb
+#endif
@@ -0,0 +1,194 @@
+/*=========================================================================
+
+  Copyright (c) Remi Cresson (IRSTEA). All rights reserved.
+
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef StreamingDeltaNDVIRunsFilter_H_
+#define StreamingDeltaNDVIRunsFilter_H_
+
+#include "otbPersistentImageFilter.h"
+#include "otbPersistentFilterStreamingDecorator.h"
+#include "otbConnectedComponentsRunTable.h"
+#include "itkSimpleDataObjectDecorator.h"
+
+#include <vector>
+
+namespace otb
+{
+
+/**
+ * \class PersistentDeltaNDVIRunsFilter
+ * \brief Threshold a dNDVI image directly into runs of candidate pixels
+ *
+ * Pixels with dNDVI <= µ-m_FirstClassStart*s (no-data excepted) are the
+ * clear cuts candidates, i.e. the pixels DeltaNDVILabelerFilter sets to its
+ * highest class with two classes. Each row of each streamed tile is split
+ * in runs of candidate pixels, which are added to a
+ * ConnectedComponentsRunTable: no label image is produced, and the memory
+ * used is proportional to the number of candidate runs, not to the area
+ * of the image. The min and mean dNDVI of each component are computed too.
+ *
+ * The input image is passed through as output.
+ *
+ * \ingroup ClearCutsDetection
+ */
+template <class TNDVIImage, class TLabelValue>
+class ITK_EXPORT PersistentDeltaNDVIRunsFilter :
+public PersistentImageFilter<TNDVIImage, TNDVIImage>
+{
+
+public:
+
+  /** Standard class typedefs. */
+  typedef PersistentDeltaNDVIRunsFilter                 Self;
+  typedef PersistentImageFilter<TNDVIImage, TNDVIImage> Superclass;
+  typedef itk::SmartPointer<Self>                       Pointer;
+  typedef itk::SmartPointer<const Self>                 ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(PersistentDeltaNDVIRunsFilter, PersistentImageFilter);
+
+  /** Image typedefs */
+  typedef TNDVIImage                                         ImageType;
+  typedef typename ImageType::RegionType                     RegionType;
+  typedef typename ImageType::IndexType                      IndexType;
+  typedef typename ImageType::PixelType                      PixelType;
+  typedef TLabelValue                                        LabelValueType;
+  typedef ConnectedComponentsRunTable<LabelValueType>        RunTableType;
+  typedef typename RunTableType::Run                         RunType;
+  typedef std::vector<RunType>                               RunListType;
+
+  /** Decorator typedef */
+  typedef typename itk::NumericTraits<PixelType>::RealType   RealType;
+  typedef itk::SimpleDataObjectDecorator<RealType>           RealObjectType;
+
+  itkSetMacro(InputNoDataValue, PixelType);
+  itkGetMacro(InputNoDataValue, PixelType);
+
+  /** Threshold, in sigma below the mean */
+  itkSetMacro(FirstClassStart, double);
+  itkGetMacro(FirstClassStart, double);
+
+  /** Label of the runs */
+  itkSetMacro(RunValue, LabelValueType);
+  itkGetMacro(RunValue, LabelValueType);
+
+  /** 8-connectivity (true) or 4-connectivity (false, default) */
+  itkSetMacro(FullyConnected, bool);
+  itkGetMacro(FullyConnected, bool);
+
+  /** Set the mean */
+  void SetInputMeanObject(RealObjectType* inputMeanObject) { m_InputMeanObject = inputMeanObject; }
+
+  /** Set the sigma */
+  void SetInputSigmaObject(RealObjectType* inputSigmaObject) { m_InputSigmaObject = inputSigmaObject; }
+
+  /** Connected components of the candidates */
+  const RunTableType & GetRunTable() const { return m_RunTable; }
+
+  /** Persistent filter methods */
+  virtual void Reset(void);
+  virtual void Synthetize(void);
+
+protected:
+  PersistentDeltaNDVIRunsFilter();
+  virtual ~PersistentDeltaNDVIRunsFilter() {};
+
+  virtual void AllocateOutputs();
+  virtual void GenerateOutputInformation();
+
+  virtual void BeforeThreadedGenerateData();
+
+  virtual void ThreadedGenerateData(const RegionType& outputRegionForThread,
+      itk::ThreadIdType threadId);
+
+  virtual void AfterThreadedGenerateData();
+
+private:
+  PersistentDeltaNDVIRunsFilter(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+  PixelType                m_InputNoDataValue;
+  double                   m_FirstClassStart;
+  LabelValueType           m_RunValue;
+  bool                     m_FullyConnected;
+
+  RealObjectType*          m_InputMeanObject;
+  RealObjectType*          m_InputSigmaObject;
+  PixelType                m_Threshold;
+
+  std::vector<RunListType> m_ThreadRuns;
+  RunTableType             m_RunTable;
+
+};
+
+/**
+ * \class StreamingDeltaNDVIRunsFilter
+ * \brief Streamed version of PersistentDeltaNDVIRunsFilter
+ *
+ * \ingroup ClearCutsDetection
+ */
+template <class TNDVIImage, class TLabelValue>
+class ITK_EXPORT StreamingDeltaNDVIRunsFilter :
+public PersistentFilterStreamingDecorator<PersistentDeltaNDVIRunsFilter<TNDVIImage, TLabelValue> >
+{
+
+public:
+
+  /** Standard class typedefs. */
+  typedef StreamingDeltaNDVIRunsFilter Self;
+  typedef PersistentFilterStreamingDecorator
+      <PersistentDeltaNDVIRunsFilter<TNDVIImage, TLabelValue> > Superclass;
+  typedef itk::SmartPointer<Self>                   Pointer;
+  typedef itk::SmartPointer<const Self>             ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(StreamingDeltaNDVIRunsFilter, PersistentFilterStreamingDecorator);
+
+  typedef TNDVIImage                                  InputImageType;
+  typedef typename Superclass::FilterType             RunsFilterType;
+  typedef typename RunsFilterType::PixelType          PixelType;
+  typedef typename RunsFilterType::LabelValueType     LabelValueType;
+  typedef typename RunsFilterType::RunTableType       RunTableType;
+  typedef typename RunsFilterType::RealObjectType     RealObjectType;
+
+  using Superclass::SetInput;
+  void SetInput(InputImageType * input) { this->GetFilter()->SetInput(input); }
+  const InputImageType * GetInput() { return this->GetFilter()->GetInput(); }
+
+  void SetInputNoDataValue(PixelType value) { this->GetFilter()->SetInputNoDataValue(value); }
+  void SetFirstClassStart(double value) { this->GetFilter()->SetFirstClassStart(value); }
+  void SetRunValue(LabelValueType value) { this->GetFilter()->SetRunValue(value); }
+  void SetFullyConnected(bool flag) { this->GetFilter()->SetFullyConnected(flag); }
+  void SetInputMeanObject(RealObjectType * object) { this->GetFilter()->SetInputMeanObject(object); }
+  void SetInputSigmaObject(RealObjectType * object) { this->GetFilter()->SetInputSigmaObject(object); }
+
+  const RunTableType & GetRunTable() const { return this->GetFilter()->GetRunTable(); }
+
+protected:
+  StreamingDeltaNDVIRunsFilter() {};
+  virtual ~StreamingDeltaNDVIRunsFilter() {};
+
+private:
+  StreamingDeltaNDVIRunsFilter(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+};
+
+} // end namespace otb
+
+#include "otbStreamingDeltaNDVIRunsFilter.hxx"
+
+
+#endif /* StreamingDeltaNDVIRunsFilter_H_ */
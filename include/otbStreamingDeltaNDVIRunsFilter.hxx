@@ -0,0 +1,179 @@
+/*=========================================================================
+
+  Copyright (c) Remi Cresson (IRSTEA). All rights reserved.
+
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef __StreamingDeltaNDVIRunsFilter_hxx
+#define __StreamingDeltaNDVIRunsFilter_hxx
+
+#include "otbStreamingDeltaNDVIRunsFilter.h"
+#include "itkProgressReporter.h"
+
+#include <algorithm>
+
+namespace otb
+{
+
+/**
+ *
+ */
+template <class TNDVIImage, class TLabelValue>
+PersistentDeltaNDVIRunsFilter<TNDVIImage, TLabelValue>
+::PersistentDeltaNDVIRunsFilter()
+ {
+  m_InputNoDataValue = 3.0; // deltaNDVI no data value
+  m_FirstClassStart = 3.0;
+  m_RunValue = 1;
+  m_FullyConnected = false;
+  m_InputMeanObject = NULL;
+  m_InputSigmaObject = NULL;
+  m_Threshold = 0;
+ }
+
+/*
+ * The input image is passed through as output
+ */
+template <class TNDVIImage, class TLabelValue>
+void
+PersistentDeltaNDVIRunsFilter<TNDVIImage, TLabelValue>
+::AllocateOutputs()
+ {
+  ImageType * inputImage = const_cast<ImageType *>(this->GetInput());
+  this->GraftOutput(inputImage);
+ }
+
+template <class TNDVIImage, class TLabelValue>
+void
+PersistentDeltaNDVIRunsFilter<TNDVIImage, TLabelValue>
+::GenerateOutputInformation()
+ {
+  Superclass::GenerateOutputInformation();
+  if (this->GetInput())
+    {
+    this->GetOutput()->CopyInformation(this->GetInput());
+    this->GetOutput()->SetLargestPossibleRegion(this->GetInput()->GetLargestPossibleRegion());
+
+    if (this->GetOutput()->GetRequestedRegion().GetNumberOfPixels() == 0)
+      {
+      this->GetOutput()->SetRequestedRegion(this->GetOutput()->GetLargestPossibleRegion());
+      }
+    }
+ }
+
+template <class TNDVIImage, class TLabelValue>
+void
+PersistentDeltaNDVIRunsFilter<TNDVIImage, TLabelValue>
+::Reset()
+ {
+  m_ThreadRuns.clear();
+  m_ThreadRuns.resize(this->GetNumberOfThreads());
+  m_RunTable.Clear();
+  m_RunTable.SetFullyConnected(m_FullyConnected);
+ }
+
+template <class TNDVIImage, class TLabelValue>
+void
+PersistentDeltaNDVIRunsFilter<TNDVIImage, TLabelValue>
+::Synthetize()
+ {
+  m_RunTable.Finalize();
+ }
+
+/*
+ * Same threshold as DeltaNDVILabelerFilter (computed in the pixel type)
+ */
+template <class TNDVIImage, class TLabelValue>
+void
+PersistentDeltaNDVIRunsFilter<TNDVIImage, TLabelValue>
+::BeforeThreadedGenerateData()
+ {
+  if (m_InputMeanObject == NULL || m_InputSigmaObject == NULL)
+    {
+    itkExceptionMacro("Mean and sigma must be set");
+    }
+  const RealType mean = m_InputMeanObject->Get();
+  const RealType sigma = m_InputSigmaObject->Get();
+  m_Threshold = mean - ((PixelType) m_FirstClassStart) * sigma;
+ }
+
+/*
+ * Add the runs of the threads to the table, in the order of the threads
+ */
+template <class TNDVIImage, class TLabelValue>
+void
+PersistentDeltaNDVIRunsFilter<TNDVIImage, TLabelValue>
+::AfterThreadedGenerateData()
+ {
+  for (unsigned int i = 0 ; i < m_ThreadRuns.size() ; i++)
+    {
+    for (unsigned int j = 0 ; j < m_ThreadRuns[i].size() ; j++)
+      {
+      const RunType & run = m_ThreadRuns[i][j];
+      m_RunTable.AddRun(run.row, run.start, run.end, run.value, run.minValue, run.sumValue);
+      }
+    m_ThreadRuns[i].clear();
+    }
+ }
+
+/**
+ *
+ */
+template <class TNDVIImage, class TLabelValue>
+void
+PersistentDeltaNDVIRunsFilter<TNDVIImage, TLabelValue>
+::ThreadedGenerateData(const RegionType& outputRegionForThread, itk::ThreadIdType threadId)
+ {
+
+  // Debug info
+  itkDebugMacro(<<"Actually executing thread " << threadId << " in region " << outputRegionForThread);
+
+  // Support progress methods/callbacks
+  itk::ProgressReporter progress(this, threadId, outputRegionForThread.GetSize(1) );
+
+  const ImageType * inputImage = this->GetInput();
+  RunListType & runs = m_ThreadRuns[threadId];
+
+  const long xStart = outputRegionForThread.GetIndex(0);
+  const long width = outputRegionForThread.GetSize(0);
+  for (unsigned int y = 0 ; y < outputRegionForThread.GetSize(1) ; y++)
+    {
+    IndexType index = outputRegionForThread.GetIndex();
+    index[1] += y;
+    const PixelType * rowPtr = inputImage->GetBufferPointer() + inputImage->ComputeOffset(index);
+
+    // Split the row in runs of candidates
+    RunType run;
+    run.row = index[1];
+    run.value = m_RunValue;
+    long x = 0;
+    while (x < width)
+      {
+      if (rowPtr[x] == m_InputNoDataValue || m_Threshold < rowPtr[x])
+        {
+        x++;
+        continue;
+        }
+      run.start = xStart + x;
+      run.minValue = rowPtr[x];
+      run.sumValue = 0.0;
+      for ( ; x < width && rowPtr[x] != m_InputNoDataValue && rowPtr[x] <= m_Threshold ; x++)
+        {
+        const double pixelValue = static_cast<double>(rowPtr[x]);
+        run.minValue = std::min(run.minValue, pixelValue);
+        run.sumValue += pixelValue;
+        }
+      run.end = xStart + x - 1;
+      runs.push_back(run);
+      }
+
+    progress.CompletedPixel();
+    } // Next row
+ }
+
+} // end namespace otb
+#endif
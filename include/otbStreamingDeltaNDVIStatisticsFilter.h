@@ -0,0 +1,384 @@
+/*=========================================================================
+
+  Copyright (c) Remi Cresson (IRSTEA). All rights reserved.
+
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef StreamingDeltaNDVIStatisticsFilter_H_
+#define StreamingDeltaNDVIStatisticsFilter_H_
+
+#include "otbPersistentImageFilter.h"
+#include "otbPersistentFilterStreamingDecorator.h"
+#include "itkNumericTraits.h"
+#include "itkSimpleDataObjectDecorator.h"
+#include "itkImageRegionConstIterator.h"
+
+#include "otbBlockAlignedStrippedStreamingManager.h"
+
+#include <string>
+#include <vector>
+#include <atomic>
+
+namespace otb
+{
+
+/**
+ * \class CompensatedSum
+ * \brief Sum of doubles with a compensation of the rounding errors (Neumaier)
+ *
+ * \ingroup ClearCutsDetection
+ */
+class CompensatedSum
+{
+public:
+  CompensatedSum() : m_Sum(0.0), m_Compensation(0.0) {}
+
+  inline void Add(double value)
+  {
+    const double sum = m_Sum + value;
+    if (vcl_abs(m_Sum) >= vcl_abs(value))
+      m_Compensation += (m_Sum - sum) + value;
+    else
+      m_Compensation += (value - sum) + m_Sum;
+    m_Sum = sum;
+  }
+
+  double GetSum() const { return m_Sum + m_Compensation; }
+
+private:
+  double m_Sum;
+  double m_Compensation;
+};
+
+/**
+ * \class DeltaNDVIStatistics
+ * \brief Mergeable first and second order moments of a dNDVI image
+ *
+ * The moments are the count, the mean, and the sum of the squared
+ * deviations from the mean (M2), merged with the pairwise formula of Chan
+ * et al., which does not suffer from the cancellation of sumsq/n - mean^2.
+ *
+ * Partial statistics (e.g. computed by several processes over distinct
+ * parts of the same dNDVI image) can be written to / read from a text file,
+ * and merged. Values are stored as hexadecimal floats, so that a merge
+ * performed in a fixed order gives always the same result.
+ *
+ * The moments of each band of rows of the reduction grid (see
+ * PersistentDeltaNDVIStatisticsFilter) are kept, and the moments of the
+ * image are their merge along a fixed pairwise tree, which only depends on
+ * the number of bands. Appending the bands of the parts in the order of the
+ * parts gives the moments of the whole image, bit for bit.
+ *
+ * \ingroup ClearCutsDetection
+ */
+class DeltaNDVIStatistics
+{
+public:
+  DeltaNDVIStatistics() : m_Count(0), m_Mean(0.0), m_M2(0.0),
+    m_PartId(0), m_PartCount(1) {}
+  ~DeltaNDVIStatistics() {}
+
+  void Reset()
+  {
+    m_Count = 0;
+    m_Mean = 0.0;
+    m_M2 = 0.0;
+    m_BandCounts.clear();
+    m_BandMeans.clear();
+    m_BandM2s.clear();
+  }
+
+  /** Moments of a set of values (e.g. a block of the reduction grid) */
+  void SetMoments(unsigned long count, double mean, double m2)
+  {
+    m_Count = count;
+    m_Mean = mean;
+    m_M2 = m2;
+  }
+
+  /** Merge the moments of another set of values (Chan et al.) */
+  void Merge(const DeltaNDVIStatistics & other)
+  {
+    if (other.m_Count == 0)
+      return;
+    if (m_Count == 0)
+      {
+      SetMoments(other.m_Count, other.m_Mean, other.m_M2);
+      return;
+      }
+    const double count = static_cast<double>(m_Count);
+    const double otherCount = static_cast<double>(other.m_Count);
+    const double mergedCount = count + otherCount;
+    const double delta = other.m_Mean - m_Mean;
+    m_Mean += delta * (otherCount / mergedCount);
+    m_M2 += other.m_M2 + delta * delta * (count * otherCount / mergedCount);
+    m_Count += other.m_Count;
+  }
+
+  /** Merge the moments of statistics[first, last[ along a fixed pairwise tree */
+  static DeltaNDVIStatistics MergePairwise(const std::vector<DeltaNDVIStatistics> & statistics,
+      size_t first, size_t last)
+  {
+    if (last <= first)
+      return DeltaNDVIStatistics();
+    if (last - first == 1)
+      return statistics[first];
+    const size_t middle = first + (last - first) / 2;
+    DeltaNDVIStatistics merged = MergePairwise(statistics, first, middle);
+    merged.Merge(MergePairwise(statistics, middle, last));
+    return merged;
+  }
+
+  /** Append a band of rows, and update the moments */
+  void AddBand(const DeltaNDVIStatistics & band)
+  {
+    AppendBand(band.m_Count, band.m_Mean, band.m_M2);
+    UpdateMoments();
+  }
+
+  /** Append the bands of the next part, and update the moments */
+  void AddBands(const DeltaNDVIStatistics & other)
+  {
+    for (unsigned int i = 0 ; i < other.GetNumberOfBands() ; i++)
+      {
+      AppendBand(other.m_BandCounts[i], other.m_BandMeans[i], other.m_BandM2s[i]);
+      }
+    UpdateMoments();
+  }
+
+  unsigned int GetNumberOfBands() const { return m_BandCounts.size(); }
+
+  unsigned long GetCount() const { return m_Count; }
+  double GetMean() const { return m_Mean; }
+  double GetM2() const { return m_M2; }
+  double GetSigma() const;
+
+  /** Part of the job these statistics come from */
+  void SetPartId(unsigned int id) { m_PartId = id; }
+  unsigned int GetPartId() const { return m_PartId; }
+  void SetPartCount(unsigned int count) { m_PartCount = count; }
+  unsigned int GetPartCount() const { return m_PartCount; }
+
+  /** Write/Read to/from a text file. Read returns false if the file is invalid */
+  void Write(const std::string & filename) const;
+  bool Read(const std::string & filename);
+
+private:
+  void AppendBand(unsigned long count, double mean, double m2)
+  {
+    m_BandCounts.push_back(count);
+    m_BandMeans.push_back(mean);
+    m_BandM2s.push_back(m2);
+  }
+
+  /** Moments of the image: pairwise merge of the bands */
+  void UpdateMoments();
+
+  unsigned long m_Count;
+  double        m_Mean;
+  double        m_M2;
+  unsigned int  m_PartId;
+  unsigned int  m_PartCount;
+
+  // Bands of rows
+  std::vector<unsigned long> m_BandCounts;
+  std::vector<double>        m_BandMeans;
+  std::vector<double>        m_BandM2s;
+};
+
+/**
+ * \class PersistentDeltaNDVIStatisticsFilter
+ * \brief Compute the mean and standard deviation of a dNDVI image
+ *
+ * Pixels equal to the user ignored value (dNDVI no-data) are skipped.
+ * The input image is passed through as output.
+ *
+ * The result does not depend on the number of threads nor on the streaming
+ * tiles: the image is divided in a fixed grid of m_BlockSize square blocks,
+ * anchored on the largest possible region. The moments of each block are
+ * computed by a single thread, in the tile containing its first pixel (the
+ * input requested region is aligned on the blocks owned by the tile, so no
+ * pixel is requested twice), with two passes in raster order over the
+ * block: the compensated sum of the values gives the mean, then the
+ * compensated sums of the deviations give M2. The threads pull the blocks
+ * of the tile from a shared counter, instead of splitting the tile by rows.
+ *
+ * In Synthetize(), the blocks of each band of rows are merged along a fixed
+ * pairwise tree, then the bands along another one (see
+ * DeltaNDVIStatistics::AddBands()). The statistics of parts made of whole
+ * bands can thus be merged into the statistics of the whole image.
+ *
+ * Use StreamingDeltaNDVIStatisticsFilter::SetBlockAlignedStreaming() so
+ * that the streamed strips are made of whole bands: other tiles are padded
+ * to the blocks they own, beyond the RAM estimate of the streamer.
+ *
+ * \ingroup ClearCutsDetection
+ */
+template <class TInputImage>
+class ITK_EXPORT PersistentDeltaNDVIStatisticsFilter :
+public PersistentImageFilter<TInputImage, TInputImage>
+{
+
+public:
+
+  /** Standard class typedefs. */
+  typedef PersistentDeltaNDVIStatisticsFilter             Self;
+  typedef PersistentImageFilter<TInputImage, TInputImage> Superclass;
+  typedef itk::SmartPointer<Self>                         Pointer;
+  typedef itk::SmartPointer<const Self>                   ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(PersistentDeltaNDVIStatisticsFilter, PersistentImageFilter);
+
+  /** Image typedefs */
+  typedef TInputImage                                         ImageType;
+  typedef typename ImageType::Pointer                         ImagePointer;
+  typedef typename ImageType::RegionType                      RegionType;
+  typedef typename ImageType::IndexType                       IndexType;
+  typedef typename ImageType::SizeType                        SizeType;
+  typedef typename ImageType::PixelType                       PixelType;
+  typedef typename itk::ImageRegionConstIterator<ImageType>   InputImageIteratorType;
+
+  /** Decorator typedef */
+  typedef typename itk::NumericTraits<PixelType>::RealType RealType;
+  typedef itk::SimpleDataObjectDecorator<RealType>         RealObjectType;
+
+  /** Ignored value (dNDVI no-data) */
+  itkSetMacro(IgnoreUserDefinedValue, bool);
+  itkGetMacro(IgnoreUserDefinedValue, bool);
+  itkSetMacro(UserIgnoredValue, PixelType);
+  itkGetMacro(UserIgnoredValue, PixelType);
+
+  /** Size of the blocks of the reduction grid (must not change between Reset() and Synthetize()) */
+  itkSetMacro(BlockSize, unsigned int);
+  itkGetMacro(BlockSize, unsigned int);
+
+  /** Results */
+  RealObjectType* GetMeanOutput() { return m_MeanObject; }
+  RealObjectType* GetSigmaOutput() { return m_SigmaObject; }
+  const DeltaNDVIStatistics & GetStatistics() const { return m_Statistics; }
+
+  /** Persistent filter methods */
+  virtual void Reset(void);
+  virtual void Synthetize(void);
+
+protected:
+  PersistentDeltaNDVIStatisticsFilter();
+  virtual ~PersistentDeltaNDVIStatisticsFilter() {};
+
+  virtual void AllocateOutputs();
+  virtual void GenerateOutputInformation();
+  virtual void GenerateInputRequestedRegion();
+
+  /** Blocks whose first pixel is inside the region. Returns false if there is none */
+  bool GetOwnedBlocksRange(const RegionType & region, IndexType & first, IndexType & last) const;
+
+  /** One piece per thread, up to the number of blocks owned by the requested region */
+  virtual unsigned int SplitRequestedRegion(unsigned int i, unsigned int num, RegionType& splitRegion);
+
+  virtual void BeforeThreadedGenerateData();
+
+  virtual void ThreadedGenerateData(const RegionType& outputRegionForThread,
+      itk::ThreadIdType threadId);
+
+private:
+  PersistentDeltaNDVIStatisticsFilter(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+  bool                             m_IgnoreUserDefinedValue;
+  PixelType                        m_UserIgnoredValue;
+
+  // Reduction grid, and statistics of each block
+  unsigned int                     m_BlockSize;
+  RegionType                       m_GridRegion;
+  unsigned int                     m_NumberOfBlocksX;
+  std::vector<DeltaNDVIStatistics> m_BlockStatistics;
+  DeltaNDVIStatistics              m_Statistics;
+
+  // Blocks owned by the current tile, pulled by the threads
+  IndexType                        m_FirstTileBlock;
+  unsigned long                    m_NumberOfTileBlocksX;
+  unsigned long                    m_NumberOfTileBlocks;
+  std::atomic<unsigned long>       m_NextTileBlock;
+
+  typename RealObjectType::Pointer m_MeanObject;
+  typename RealObjectType::Pointer m_SigmaObject;
+
+};
+
+/**
+ * \class StreamingDeltaNDVIStatisticsFilter
+ * \brief Streamed version of PersistentDeltaNDVIStatisticsFilter
+ *
+ * \ingroup ClearCutsDetection
+ */
+template <class TInputImage>
+class ITK_EXPORT StreamingDeltaNDVIStatisticsFilter :
+public PersistentFilterStreamingDecorator<PersistentDeltaNDVIStatisticsFilter<TInputImage> >
+{
+
+public:
+
+  /** Standard class typedefs. */
+  typedef StreamingDeltaNDVIStatisticsFilter Self;
+  typedef PersistentFilterStreamingDecorator
+      <PersistentDeltaNDVIStatisticsFilter<TInputImage> > Superclass;
+  typedef itk::SmartPointer<Self>                         Pointer;
+  typedef itk::SmartPointer<const Self>                   ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(StreamingDeltaNDVIStatisticsFilter, PersistentFilterStreamingDecorator);
+
+  typedef TInputImage                                   InputImageType;
+  typedef typename Superclass::FilterType               StatisticsFilterType;
+  typedef typename StatisticsFilterType::PixelType      PixelType;
+  typedef typename StatisticsFilterType::RealObjectType RealObjectType;
+  typedef BlockAlignedStrippedStreamingManager<InputImageType> StreamingManagerType;
+
+  using Superclass::SetInput;
+  void SetInput(InputImageType * input) { this->GetFilter()->SetInput(input); }
+  const InputImageType * GetInput() { return this->GetFilter()->GetInput(); }
+
+  void SetIgnoreUserDefinedValue(bool flag) { this->GetFilter()->SetIgnoreUserDefinedValue(flag); }
+  void SetUserIgnoredValue(PixelType value) { this->GetFilter()->SetUserIgnoredValue(value); }
+  void SetBlockSize(unsigned int size) { this->GetFilter()->SetBlockSize(size); }
+
+  /** Stream strips of whole bands of blocks, within the available RAM (MB). Call after SetBlockSize() */
+  void SetBlockAlignedStreaming(unsigned int availableRAM)
+  {
+    typename StreamingManagerType::Pointer streamingManager = StreamingManagerType::New();
+    streamingManager->SetAvailableRAMInMB(availableRAM);
+    streamingManager->SetBlockSize(this->GetFilter()->GetBlockSize());
+    this->GetStreamer()->SetStreamingManager(streamingManager);
+  }
+
+  RealObjectType* GetMeanOutput() { return this->GetFilter()->GetMeanOutput(); }
+  RealObjectType* GetSigmaOutput() { return this->GetFilter()->GetSigmaOutput(); }
+  const DeltaNDVIStatistics & GetStatistics() const { return this->GetFilter()->GetStatistics(); }
+
+protected:
+  StreamingDeltaNDVIStatisticsFilter() {};
+  virtual ~StreamingDeltaNDVIStatisticsFilter() {};
+
+private:
+  StreamingDeltaNDVIStatisticsFilter(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+};
+
+} // end namespace otb
+
+#include "otbStreamingDeltaNDVIStatisticsFilter.hxx"
+
+
+#endif /* StreamingDeltaNDVIStatisticsFilter_H_ */
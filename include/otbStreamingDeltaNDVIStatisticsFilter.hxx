@@ -0,0 +1,376 @@
+/*=========================================================================
+
+  Copyright (c) Remi Cresson (IRSTEA). All rights reserved.
+
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef __StreamingDeltaNDVIStatisticsFilter_hxx
+#define __StreamingDeltaNDVIStatisticsFilter_hxx
+
+#include "otbStreamingDeltaNDVIStatisticsFilter.h"
+#include "itkProgressReporter.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+
+namespace otb
+{
+
+inline double
+DeltaNDVIStatistics
+::GetSigma() const
+ {
+  if (m_Count == 0 || m_M2 <= 0.0)
+    return 0.0;
+  return vcl_sqrt(m_M2 / static_cast<double>(m_Count));
+ }
+
+inline void
+DeltaNDVIStatistics
+::UpdateMoments()
+ {
+  std::vector<DeltaNDVIStatistics> bands(GetNumberOfBands());
+  for (unsigned int i = 0 ; i < GetNumberOfBands() ; i++)
+    {
+    bands[i].SetMoments(m_BandCounts[i], m_BandMeans[i], m_BandM2s[i]);
+    }
+  const DeltaNDVIStatistics merged = MergePairwise(bands, 0, bands.size());
+  SetMoments(merged.m_Count, merged.m_Mean, merged.m_M2);
+ }
+
+/*
+ * Values are written as hexadecimal floats (%a) to be read back exactly
+ */
+inline void
+DeltaNDVIStatistics
+::Write(const std::string & filename) const
+ {
+  FILE * file = std::fopen(filename.c_str(), "w");
+  if (file == NULL)
+    {
+    itkGenericExceptionMacro("Unable to write statistics file " << filename);
+    }
+  std::fprintf(file, "part.id %u\n", m_PartId);
+  std::fprintf(file, "part.count %u\n", m_PartCount);
+  std::fprintf(file, "count %lu\n", m_Count);
+  std::fprintf(file, "mean %a\n", m_Mean);
+  std::fprintf(file, "m2 %a\n", m_M2);
+  std::fprintf(file, "bands %u\n", GetNumberOfBands());
+  for (unsigned int i = 0 ; i < GetNumberOfBands() ; i++)
+    {
+    std::fprintf(file, "band %lu %a %a\n", m_BandCounts[i], m_BandMeans[i], m_BandM2s[i]);
+    }
+  std::fclose(file);
+ }
+
+inline bool
+DeltaNDVIStatistics
+::Read(const std::string & filename)
+ {
+  FILE * file = std::fopen(filename.c_str(), "r");
+  if (file == NULL)
+    return false;
+
+  Reset();
+  unsigned int nbOfFields = 0;
+  unsigned int nbOfBands = 0;
+  char line[256];
+  char key[64];
+  char value[64];
+  char mean[64];
+  char m2[64];
+  while (std::fgets(line, sizeof(line), file) != NULL)
+    {
+    if (std::sscanf(line, "band %63s %63s %63s", value, mean, m2) == 3)
+      {
+      AppendBand(std::strtoul(value, NULL, 10), std::strtod(mean, NULL), std::strtod(m2, NULL));
+      continue;
+      }
+    if (std::sscanf(line, "%63s %63s", key, value) != 2)
+      continue;
+    if (std::strcmp(key, "part.id") == 0)
+      m_PartId = std::strtoul(value, NULL, 10);
+    else if (std::strcmp(key, "part.count") == 0)
+      m_PartCount = std::strtoul(value, NULL, 10);
+    else if (std::strcmp(key, "count") == 0)
+      m_Count = std::strtoul(value, NULL, 10);
+    else if (std::strcmp(key, "mean") == 0)
+      m_Mean = std::strtod(value, NULL);
+    else if (std::strcmp(key, "m2") == 0)
+      m_M2 = std::strtod(value, NULL);
+    else if (std::strcmp(key, "bands") == 0)
+      nbOfBands = std::strtoul(value, NULL, 10);
+    else
+      continue;
+    nbOfFields++;
+    }
+  std::fclose(file);
+
+  return nbOfFields == 6 && nbOfBands == GetNumberOfBands();
+ }
+
+/**
+ *
+ */
+template <class TInputImage>
+PersistentDeltaNDVIStatisticsFilter<TInputImage>
+::PersistentDeltaNDVIStatisticsFilter()
+ {
+  m_IgnoreUserDefinedValue = false;
+  m_UserIgnoredValue = itk::NumericTraits<PixelType>::Zero;
+  m_BlockSize = 256;
+  m_NumberOfBlocksX = 0;
+  m_FirstTileBlock.Fill(0);
+  m_NumberOfTileBlocksX = 0;
+  m_NumberOfTileBlocks = 0;
+  m_NextTileBlock = 0;
+
+  m_MeanObject = RealObjectType::New();
+  m_MeanObject->Set(itk::NumericTraits<RealType>::Zero);
+  m_SigmaObject = RealObjectType::New();
+  m_SigmaObject->Set(itk::NumericTraits<RealType>::Zero);
+ }
+
+/*
+ * The input image is passed through as output
+ */
+template <class TInputImage>
+void
+PersistentDeltaNDVIStatisticsFilter<TInputImage>
+::AllocateOutputs()
+ {
+  ImageType * inputImage = const_cast<ImageType *>(this->GetInput());
+  this->GraftOutput(inputImage);
+ }
+
+template <class TInputImage>
+void
+PersistentDeltaNDVIStatisticsFilter<TInputImage>
+::GenerateOutputInformation()
+ {
+  Superclass::GenerateOutputInformation();
+  if (this->GetInput())
+    {
+    this->GetOutput()->CopyInformation(this->GetInput());
+    this->GetOutput()->SetLargestPossibleRegion(this->GetInput()->GetLargestPossibleRegion());
+
+    if (this->GetOutput()->GetRequestedRegion().GetNumberOfPixels() == 0)
+      {
+      this->GetOutput()->SetRequestedRegion(this->GetOutput()->GetLargestPossibleRegion());
+      }
+    }
+ }
+
+/*
+ * Blocks of the grid whose first pixel is inside the region
+ */
+template <class TInputImage>
+bool
+PersistentDeltaNDVIStatisticsFilter<TInputImage>
+::GetOwnedBlocksRange(const RegionType & region, IndexType & first, IndexType & last) const
+ {
+  const IndexType origin = m_GridRegion.GetIndex();
+  for (unsigned int dim = 0 ; dim < 2 ; dim++)
+    {
+    const long start = region.GetIndex(dim) - origin[dim];
+    const long end = start + static_cast<long>(region.GetSize(dim)) - 1;
+    first[dim] = (start + m_BlockSize - 1) / m_BlockSize;
+    last[dim] = end / m_BlockSize;
+    if (last[dim] < first[dim])
+      return false;
+    }
+  return true;
+ }
+
+/*
+ * The threads pull the blocks from a counter: the pieces only tell how
+ * many threads are started
+ */
+template <class TInputImage>
+unsigned int
+PersistentDeltaNDVIStatisticsFilter<TInputImage>
+::SplitRequestedRegion(unsigned int i, unsigned int num, RegionType& splitRegion)
+ {
+  splitRegion = this->GetOutput()->GetRequestedRegion();
+
+  IndexType first, last;
+  if (!GetOwnedBlocksRange(splitRegion, first, last))
+    return 1;
+  const unsigned long nbOfBlocks = (last[0] - first[0] + 1) * (last[1] - first[1] + 1);
+  return std::max(1UL, std::min(static_cast<unsigned long>(num), nbOfBlocks));
+ }
+
+/*
+ * Request the whole blocks owned by the requested region only
+ */
+template <class TInputImage>
+void
+PersistentDeltaNDVIStatisticsFilter<TInputImage>
+::GenerateInputRequestedRegion()
+ {
+  ImageType * inputImage = const_cast<ImageType *>(this->GetInput());
+  if (!inputImage)
+    return;
+
+  m_GridRegion = inputImage->GetLargestPossibleRegion();
+  const RegionType outRegion = this->GetOutput()->GetRequestedRegion();
+
+  RegionType inRegion;
+  IndexType first, last;
+  if (GetOwnedBlocksRange(outRegion, first, last))
+    {
+    IndexType index;
+    SizeType size;
+    for (unsigned int dim = 0 ; dim < 2 ; dim++)
+      {
+      index[dim] = m_GridRegion.GetIndex(dim) + first[dim] * m_BlockSize;
+      size[dim] = (last[dim] - first[dim] + 1) * m_BlockSize;
+      }
+    inRegion.SetIndex(index);
+    inRegion.SetSize(size);
+    inRegion.Crop(m_GridRegion);
+    }
+  else
+    {
+    // No block starts here: request a single pixel
+    SizeType size;
+    size.Fill(1);
+    inRegion.SetIndex(outRegion.GetIndex());
+    inRegion.SetSize(size);
+    }
+  inputImage->SetRequestedRegion(inRegion);
+ }
+
+template <class TInputImage>
+void
+PersistentDeltaNDVIStatisticsFilter<TInputImage>
+::Reset()
+ {
+  m_BlockStatistics.clear();
+  m_Statistics.Reset();
+ }
+
+/*
+ * Initialize the grid at the first streamed region, and list the blocks of the tile
+ */
+template <class TInputImage>
+void
+PersistentDeltaNDVIStatisticsFilter<TInputImage>
+::BeforeThreadedGenerateData()
+ {
+  if (m_BlockStatistics.empty())
+    {
+    m_GridRegion = this->GetInput()->GetLargestPossibleRegion();
+    m_NumberOfBlocksX = (m_GridRegion.GetSize(0) + m_BlockSize - 1) / m_BlockSize;
+    const unsigned int nbOfBlocksY = (m_GridRegion.GetSize(1) + m_BlockSize - 1) / m_BlockSize;
+    m_BlockStatistics.resize(m_NumberOfBlocksX * nbOfBlocksY);
+    }
+
+  IndexType last;
+  m_NumberOfTileBlocksX = 0;
+  m_NumberOfTileBlocks = 0;
+  if (GetOwnedBlocksRange(this->GetOutput()->GetRequestedRegion(), m_FirstTileBlock, last))
+    {
+    m_NumberOfTileBlocksX = last[0] - m_FirstTileBlock[0] + 1;
+    m_NumberOfTileBlocks = m_NumberOfTileBlocksX * (last[1] - m_FirstTileBlock[1] + 1);
+    }
+  m_NextTileBlock = 0;
+ }
+
+/*
+ * Merge the blocks of each band along a pairwise tree, then the bands
+ * along another one
+ */
+template <class TInputImage>
+void
+PersistentDeltaNDVIStatisticsFilter<TInputImage>
+::Synthetize()
+ {
+  m_Statistics.Reset();
+  for (size_t bandStart = 0 ; bandStart < m_BlockStatistics.size() ; bandStart += m_NumberOfBlocksX)
+    {
+    m_Statistics.AddBand(DeltaNDVIStatistics::MergePairwise(m_BlockStatistics,
+        bandStart, bandStart + m_NumberOfBlocksX));
+    }
+
+  m_MeanObject->Set(static_cast<RealType>(m_Statistics.GetMean()));
+  m_SigmaObject->Set(static_cast<RealType>(m_Statistics.GetSigma()));
+ }
+
+/**
+ *
+ */
+template <class TInputImage>
+void
+PersistentDeltaNDVIStatisticsFilter<TInputImage>
+::ThreadedGenerateData(const RegionType& outputRegionForThread, itk::ThreadIdType threadId)
+ {
+
+  // Debug info
+  itkDebugMacro(<<"Actually executing thread " << threadId << " in region " << outputRegionForThread);
+
+  // Support progress methods/callbacks
+  itk::ProgressReporter progress(this, threadId,
+      m_NumberOfTileBlocks / std::max(1U, this->GetNumberOfThreads()));
+
+  // Blocks of the tile, pulled one by one
+  for (unsigned long k = m_NextTileBlock++ ; k < m_NumberOfTileBlocks ; k = m_NextTileBlock++)
+    {
+    const long bx = m_FirstTileBlock[0] + k % m_NumberOfTileBlocksX;
+    const long by = m_FirstTileBlock[1] + k / m_NumberOfTileBlocksX;
+    RegionType block;
+    block.SetIndex(0, m_GridRegion.GetIndex(0) + bx * m_BlockSize);
+    block.SetIndex(1, m_GridRegion.GetIndex(1) + by * m_BlockSize);
+    block.SetSize(0, m_BlockSize);
+    block.SetSize(1, m_BlockSize);
+    block.Crop(m_GridRegion);
+
+    // Mean
+    unsigned long count = 0;
+    CompensatedSum sum;
+    InputImageIteratorType inputIt(this->GetInput(), block);
+    for ( inputIt.GoToBegin(); !inputIt.IsAtEnd(); ++inputIt )
+      {
+      const PixelType value = inputIt.Get();
+      if (!m_IgnoreUserDefinedValue || value != m_UserIgnoredValue)
+        {
+        sum.Add(static_cast<double>(value));
+        count++;
+        }
+      } // Next pixel
+
+    // Deviations from the mean: their sum corrects the rounding of the mean
+    double mean = 0.0;
+    double m2 = 0.0;
+    if (count > 0)
+      {
+      mean = sum.GetSum() / static_cast<double>(count);
+      CompensatedSum deviations;
+      CompensatedSum squaredDeviations;
+      for ( inputIt.GoToBegin(); !inputIt.IsAtEnd(); ++inputIt )
+        {
+        const PixelType value = inputIt.Get();
+        if (!m_IgnoreUserDefinedValue || value != m_UserIgnoredValue)
+          {
+          const double deviation = static_cast<double>(value) - mean;
+          deviations.Add(deviation);
+          squaredDeviations.Add(deviation * deviation);
+          }
+        } // Next pixel
+      const double deviation = deviations.GetSum();
+      mean += deviation / static_cast<double>(count);
+      m2 = std::max(0.0, squaredDeviations.GetSum() - deviation * deviation / static_cast<double>(count));
+      }
+    m_BlockStatistics[by * m_NumberOfBlocksX + bx].SetMoments(count, mean, m2);
+    progress.CompletedPixel();
+    } // Next block
+ }
+
+} // end namespace otb
+#endif
@@ -0,0 +1,134 @@
+/*=========================================================================
+
+  Copyright (c) Remi Cresson (IRSTEA). All rights reserved.
+
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef VectorDataMaskImageFilter_H_
+#define VectorDataMaskImageFilter_H_
+
+#include "itkImageToImageFilter.h"
+#include "otbVectorData.h"
+
+#include <vector>
+
+namespace otb
+{
+
+/**
+ * \class VectorDataMaskImageFilter
+ * \brief Restrict an image to the polygons of a vector data
+ *
+ * The output is the envelope of the polygons (cropped to the input), where
+ * pixels whose center is outside the polygons are set to m_OutsideValue,
+ * like the ExtractGeom application. The polygons must be in the projection
+ * of the image.
+ *
+ * The polygons are not rasterized beforehand: their edges (in input
+ * indices) are sorted in bands of m_BandHeight rows, and each output row
+ * is filled with a scanline, from the crossings of the edges of its band
+ * only (even-odd rule inside each polygon, union of the polygons). The
+ * cost of a tile depends on its size and on the edges crossing it, not on
+ * the size of the image nor on the whole mask.
+ *
+ * \ingroup ClearCutsDetection
+ */
+template <class TImage, class TVectorData = otb::VectorData<double, 2> >
+class ITK_EXPORT VectorDataMaskImageFilter :
+public itk::ImageToImageFilter<TImage, TImage>
+{
+
+public:
+
+  /** Standard class typedefs. */
+  typedef VectorDataMaskImageFilter               Self;
+  typedef itk::ImageToImageFilter<TImage, TImage> Superclass;
+  typedef itk::SmartPointer<Self>                 Pointer;
+  typedef itk::SmartPointer<const Self>           ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(VectorDataMaskImageFilter, itk::ImageToImageFilter);
+
+  /** Image typedefs */
+  typedef TImage                                  ImageType;
+  typedef typename ImageType::RegionType          ImageRegionType;
+  typedef typename ImageType::IndexType           ImageIndexType;
+  typedef typename ImageType::SizeType            ImageSizeType;
+  typedef typename ImageType::PointType           ImagePointType;
+  typedef typename ImageType::InternalPixelType   InternalPixelType;
+  typedef typename ImageIndexType::IndexValueType IndexValueType;
+
+  /** Vector data typedefs */
+  typedef TVectorData                             VectorDataType;
+  typedef typename VectorDataType::DataTreeType   DataTreeType;
+  typedef typename VectorDataType::DataNodeType   DataNodeType;
+  typedef typename DataNodeType::PolygonType      PolygonType;
+  typedef typename DataNodeType::PolygonListType  PolygonListType;
+
+  /** An edge of a polygon ring, in input continuous indices */
+  struct Edge
+  {
+    double       x0;
+    double       y0;
+    double       x1;
+    double       y1;
+    unsigned int polygon;
+  };
+  typedef std::vector<unsigned int>               EdgeIdListType;
+
+  itkSetMacro(OutsideValue, InternalPixelType);
+  itkGetMacro(OutsideValue, InternalPixelType);
+
+  itkSetMacro(BandHeight, unsigned int);
+  itkGetMacro(BandHeight, unsigned int);
+
+  /** Polygons, in the projection of the input image */
+  void SetVectorData(const VectorDataType * vectorData) { m_VectorData = vectorData; this->Modified(); }
+
+  /** Number of polygons (valid after the output information is generated) */
+  unsigned int GetNumberOfPolygons() const { return m_NumberOfPolygons; }
+
+protected:
+  VectorDataMaskImageFilter();
+  virtual ~VectorDataMaskImageFilter() {};
+
+  /** Add the edges of a ring */
+  void AddRing(const PolygonType * ring, unsigned int polygon);
+
+  virtual void GenerateOutputInformation();
+
+  virtual void GenerateInputRequestedRegion();
+
+  virtual void ThreadedGenerateData(const ImageRegionType& outputRegionForThread,
+      itk::ThreadIdType threadId);
+
+private:
+  VectorDataMaskImageFilter(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+  InternalPixelType                       m_OutsideValue;
+  unsigned int                            m_BandHeight;
+  typename VectorDataType::ConstPointer   m_VectorData;
+
+  // Edges, bands of rows, and envelope (input indices)
+  unsigned int                            m_NumberOfPolygons;
+  std::vector<Edge>                       m_Edges;
+  std::vector<EdgeIdListType>             m_Bands;
+  ImageRegionType                         m_EnvelopeRegion;
+
+};
+
+
+} // end namespace otb
+
+#include "otbVectorDataMaskImageFilter.hxx"
+
+
+#endif /* VectorDataMaskImageFilter_H_ */
@@ -0,0 +1,246 @@
+/*=========================================================================
+
+  Copyright (c) Remi Cresson (IRSTEA). All rights reserved.
+
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef __VectorDataMaskImageFilter_hxx
+#define __VectorDataMaskImageFilter_hxx
+
+#include "otbVectorDataMaskImageFilter.h"
+#include "itkProgressReporter.h"
+#include "itkPreOrderTreeIterator.h"
+#include "itkContinuousIndex.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace otb
+{
+/**
+ *
+ */
+template <class TImage, class TVectorData>
+VectorDataMaskImageFilter<TImage, TVectorData>
+::VectorDataMaskImageFilter()
+ {
+  m_OutsideValue = itk::NumericTraits<InternalPixelType>::Zero;
+  m_BandHeight = 64;
+  m_NumberOfPolygons = 0;
+ }
+
+template <class TImage, class TVectorData>
+void
+VectorDataMaskImageFilter<TImage, TVectorData>
+::AddRing(const PolygonType * ring, unsigned int polygon)
+ {
+  const ImageType * inputImage = this->GetInput();
+  const typename PolygonType::VertexListType * vertices = ring->GetVertexList();
+  const unsigned int nbOfVertices = vertices->Size();
+  if (nbOfVertices < 3)
+    return;
+
+  itk::ContinuousIndex<double, 2> previous;
+  for (unsigned int i = 0 ; i <= nbOfVertices ; i++)
+    {
+    const typename PolygonType::VertexType & vertex = vertices->ElementAt(i % nbOfVertices);
+    ImagePointType point;
+    point[0] = vertex[0];
+    point[1] = vertex[1];
+    itk::ContinuousIndex<double, 2> index;
+    inputImage->TransformPhysicalPointToContinuousIndex(point, index);
+    if (i > 0)
+      {
+      Edge edge = {previous[0], previous[1], index[0], index[1], polygon};
+      m_Edges.push_back(edge);
+      }
+    previous = index;
+    }
+ }
+
+/*
+ * Edges of the polygons, bands of rows, and envelope of the polygons
+ */
+template <class TImage, class TVectorData>
+void
+VectorDataMaskImageFilter<TImage, TVectorData>
+::GenerateOutputInformation()
+ {
+  Superclass::GenerateOutputInformation();
+
+  if (m_VectorData.IsNull())
+    {
+    itkExceptionMacro("No vector data");
+    }
+
+  // Edges
+  m_Edges.clear();
+  m_NumberOfPolygons = 0;
+  itk::PreOrderTreeIterator<DataTreeType> it(const_cast<DataTreeType *>(m_VectorData->GetDataTree()));
+  for (it.GoToBegin() ; !it.IsAtEnd() ; ++it)
+    {
+    typename DataNodeType::Pointer node = it.Get();
+    if (!node->IsPolygonFeature())
+      continue;
+    AddRing(node->GetPolygonExteriorRing(), m_NumberOfPolygons);
+    typename PolygonListType::Pointer holes = node->GetPolygonInteriorRings();
+    for (unsigned int i = 0 ; i < holes->Size() ; i++)
+      AddRing(holes->GetNthElement(i), m_NumberOfPolygons);
+    m_NumberOfPolygons++;
+    }
+
+  // Bands of rows: each edge is in the bands of the rows (pixel centers) it crosses
+  const ImageRegionType inputRegion = this->GetInput()->GetLargestPossibleRegion();
+  const IndexValueType firstRow = inputRegion.GetIndex(1);
+  const IndexValueType lastRow = firstRow + static_cast<IndexValueType>(inputRegion.GetSize(1)) - 1;
+  m_Bands.assign((inputRegion.GetSize(1) + m_BandHeight - 1) / m_BandHeight, EdgeIdListType());
+  double xMin = itk::NumericTraits<double>::max();
+  double xMax = itk::NumericTraits<double>::NonpositiveMin();
+  IndexValueType yMin = lastRow + 1;
+  IndexValueType yMax = firstRow - 1;
+  for (unsigned int i = 0 ; i < m_Edges.size() ; i++)
+    {
+    const Edge & edge = m_Edges[i];
+    const IndexValueType row0 = std::max(firstRow,
+        static_cast<IndexValueType>(vcl_ceil(std::min(edge.y0, edge.y1))));
+    const IndexValueType row1 = std::min(lastRow,
+        static_cast<IndexValueType>(vcl_ceil(std::max(edge.y0, edge.y1))) - 1);
+    if (row1 < row0)
+      continue;
+    for (IndexValueType band = (row0 - firstRow) / m_BandHeight ; band <= (row1 - firstRow) / m_BandHeight ; band++)
+      m_Bands[band].push_back(i);
+    xMin = std::min(xMin, std::min(edge.x0, edge.x1));
+    xMax = std::max(xMax, std::max(edge.x0, edge.x1));
+    yMin = std::min(yMin, row0);
+    yMax = std::max(yMax, row1);
+    }
+
+  // Envelope of the pixel centers inside the polygons
+  ImageRegionType envelope;
+  ImageIndexType envelopeIndex;
+  ImageSizeType envelopeSize;
+  envelopeIndex[0] = static_cast<IndexValueType>(vcl_ceil(xMin));
+  envelopeIndex[1] = yMin;
+  const IndexValueType xEnd = static_cast<IndexValueType>(vcl_ceil(xMax)) - 1;
+  if (yMax < yMin || xEnd < envelopeIndex[0])
+    {
+    itkExceptionMacro("The vector data does not intersect the image");
+    }
+  envelopeSize[0] = xEnd - envelopeIndex[0] + 1;
+  envelopeSize[1] = yMax - yMin + 1;
+  envelope.SetIndex(envelopeIndex);
+  envelope.SetSize(envelopeSize);
+  if (!envelope.Crop(inputRegion))
+    {
+    itkExceptionMacro("The vector data does not intersect the image");
+    }
+  m_EnvelopeRegion = envelope;
+
+  // Output starts at index 0, like otb::ExtractROI
+  ImagePointType origin;
+  this->GetInput()->TransformIndexToPhysicalPoint(m_EnvelopeRegion.GetIndex(), origin);
+  ImageRegionType outputRegion;
+  outputRegion.SetSize(m_EnvelopeRegion.GetSize());
+  this->GetOutput()->SetOrigin(origin);
+  this->GetOutput()->SetLargestPossibleRegion(outputRegion);
+ }
+
+template <class TImage, class TVectorData>
+void
+VectorDataMaskImageFilter<TImage, TVectorData>
+::GenerateInputRequestedRegion()
+ {
+  ImageType * inputImage = const_cast<ImageType *>(this->GetInput());
+  ImageRegionType inputRequestedRegion = this->GetOutput()->GetRequestedRegion();
+  ImageIndexType index = inputRequestedRegion.GetIndex();
+  index[0] += m_EnvelopeRegion.GetIndex(0);
+  index[1] += m_EnvelopeRegion.GetIndex(1);
+  inputRequestedRegion.SetIndex(index);
+  inputImage->SetRequestedRegion(inputRequestedRegion);
+ }
+
+/**
+ *
+ */
+template <class TImage, class TVectorData>
+void
+VectorDataMaskImageFilter<TImage, TVectorData>
+::ThreadedGenerateData(const ImageRegionType& outputRegionForThread, itk::ThreadIdType threadId)
+ {
+
+  // Debug info
+  itkDebugMacro(<<"Actually executing thread " << threadId << " in region " << outputRegionForThread);
+
+  // Support progress methods/callbacks
+  itk::ProgressReporter progress(this, threadId, outputRegionForThread.GetSize(1) );
+
+  const ImageType * inputImage = this->GetInput();
+  ImageType * outputImage = this->GetOutput();
+  const unsigned int nbOfComponents = outputImage->GetNumberOfComponentsPerPixel();
+  const IndexValueType firstRow = inputImage->GetLargestPossibleRegion().GetIndex(1);
+  const IndexValueType width = outputRegionForThread.GetSize(0);
+
+  // Input columns of the thread region
+  const IndexValueType xStart = outputRegionForThread.GetIndex(0) + m_EnvelopeRegion.GetIndex(0);
+  const IndexValueType xEnd = xStart + width - 1;
+
+  std::vector<std::pair<unsigned int, double> > crossings;
+  for (unsigned int y = 0 ; y < outputRegionForThread.GetSize(1) ; y++)
+    {
+    ImageIndexType outputIndex = outputRegionForThread.GetIndex();
+    outputIndex[1] += y;
+    ImageIndexType inputIndex;
+    inputIndex[0] = xStart;
+    inputIndex[1] = outputIndex[1] + m_EnvelopeRegion.GetIndex(1);
+    const double row = inputIndex[1];
+
+    // Crossings of the row with the edges of its band, by polygon
+    crossings.clear();
+    const EdgeIdListType & band = m_Bands[(inputIndex[1] - firstRow) / m_BandHeight];
+    for (unsigned int i = 0 ; i < band.size() ; i++)
+      {
+      const Edge & edge = m_Edges[band[i]];
+      if ((edge.y0 <= row) != (edge.y1 <= row))
+        {
+        const double x = edge.x0 + (row - edge.y0) * (edge.x1 - edge.x0) / (edge.y1 - edge.y0);
+        crossings.push_back(std::make_pair(edge.polygon, x));
+        }
+      }
+    std::sort(crossings.begin(), crossings.end());
+
+    // Outside value, then the pixels between pairs of crossings of the same polygon
+    InternalPixelType * outputPtr = outputImage->GetBufferPointer()
+        + outputImage->ComputeOffset(outputIndex) * nbOfComponents;
+    std::fill(outputPtr, outputPtr + width * nbOfComponents, m_OutsideValue);
+    const InternalPixelType * inputPtr = inputImage->GetBufferPointer()
+        + inputImage->ComputeOffset(inputIndex) * nbOfComponents;
+    unsigned int i = 0;
+    while (i + 1 < crossings.size())
+      {
+      if (crossings[i].first != crossings[i + 1].first)
+        {
+        i++;
+        continue;
+        }
+      const IndexValueType start = std::max(xStart,
+          static_cast<IndexValueType>(vcl_ceil(crossings[i].second)));
+      const IndexValueType end = std::min(xEnd,
+          static_cast<IndexValueType>(vcl_ceil(crossings[i + 1].second)) - 1);
+      if (start <= end)
+        {
+        std::copy(inputPtr + (start - xStart) * nbOfComponents, inputPtr + (end - xStart + 1) * nbOfComponents,
+            outputPtr + (start - xStart) * nbOfComponents);
+        }
+      i += 2;
+      }
+
+    progress.CompletedPixel();
+    } // Next row
+ }
+}
+#endif
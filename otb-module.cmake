@@ -6,6 +6,8 @@ otb_module(ClearCutsDetection
     OTBIndices
     OTBStatistics
     OTBIOXML
+    OTBGdalAdapters
+    OTBProjection
     SimpleExtractionTools
     	
   TEST_DEPENDS
@@ -0,0 +1,26 @@
+/*=========================================================================
+
+  Copyright (c) Remi Cresson (IRSTEA). All rights reserved.
+
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#include "otbTestMain.h"
+
+void RegisterTests()
+{
+  REGISTER_TEST(otbClearCutsReducersTest);
+  REGISTER_TEST(otbMappedRasterFileTest);
+  REGISTER_TEST(otbDeltaNDVIStatisticsTest);
+  REGISTER_TEST(otbConnectedComponentsRunTableTest);
+  REGISTER_TEST(otbConnectedComponentsRunTableToVectorDataTest);
+  REGISTER_TEST(otbVectorDataMaskImageFilterTest);
+  REGISTER_TEST(otbGridAlignedResampleImageFilterTest);
+  REGISTER_TEST(otbClearCutsStitchingInputs);
+  REGISTER_TEST(otbClearCutsStitchingCompare);
+  REGISTER_TEST(otbClearCutsInMemoryDetectorInputs);
+  REGISTER_TEST(otbClearCutsInMemoryDetectorTest);
+}
@@ -0,0 +1,329 @@
+/*=========================================================================
+
+  Copyright (c) Remi Cresson (IRSTEA). All rights reserved.
+
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#include "otbClearCutsInMemoryDetector.h"
+#include "itkPreOrderTreeIterator.h"
+
+#include "gdal.h"
+#include "gdal_priv.h"
+#include "ogrsf_frmts.h"
+#include "ogr_spatialref.h"
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cstdlib>
+
+typedef otb::ClearCutsInMemoryDetector<float>                  InMemoryDetectorType;
+typedef InMemoryDetectorType::VectorDataType                   InMemoryVectorDataType;
+typedef InMemoryVectorDataType::DataNodeType                   InMemoryDataNodeType;
+typedef itk::PreOrderTreeIterator<InMemoryVectorDataType::DataTreeType> InMemoryTreeIteratorType;
+
+// Two blocks of statistics in each dimension
+static const int inMemoryWidth = 300;
+static const int inMemoryHeight = 400;
+
+// Pixel size and origin which are not exact in binary
+static const double inMemoryGeoTransform[6] = {612345.7, 0.3, 0.0, 4876543.1, 0.0, -0.3};
+
+// Clear cuts (rows and columns, inclusive): a rectangle, a bar split in two
+// polygons by the masked rows, a rectangle across the blocks boundaries, and
+// a rectangle inside the masked area
+struct InMemoryRectangle
+{
+  int firstRow;
+  int lastRow;
+  int firstColumn;
+  int lastColumn;
+};
+
+static const InMemoryRectangle inMemoryCuts[] =
+{
+  { 40,  69,  30,  59},
+  {120, 199, 100, 109},
+  {250, 269, 240, 269},
+  {330, 349,  20,  49},
+};
+
+static const InMemoryRectangle inMemoryMasked[] =
+{
+  {150, 169,   0, 299},
+  {320, 359,  10,  59},
+};
+
+static const unsigned int inMemoryNbOfPolygons = 4;
+
+static bool IsInMemoryRectangle(const InMemoryRectangle * rectangles, unsigned int count, int row, int column)
+{
+  for (unsigned int i = 0 ; i < count ; i++)
+    {
+    const InMemoryRectangle & rect = rectangles[i];
+    if (row >= rect.firstRow && row <= rect.lastRow && column >= rect.firstColumn && column <= rect.lastColumn)
+      return true;
+    }
+  return false;
+}
+
+/*
+ * Pixel interleaved red and near infrared bands (1 and 4) of a forest, with
+ * some noise. At the second date, the near infrared drops in the clear cuts.
+ */
+static std::vector<float> CreateInMemoryBuffer(bool after)
+{
+  std::vector<float> pixels(4 * inMemoryWidth * inMemoryHeight);
+  unsigned int state = after ? 4321 : 1234;
+  for (int row = 0 ; row < inMemoryHeight ; row++)
+    {
+    for (int column = 0 ; column < inMemoryWidth ; column++)
+      {
+      state = state * 1103515245 + 12345;
+      const float noise = static_cast<float>((state >> 16) & 0xFF) / 25600.0f;
+      const bool cut = after && IsInMemoryRectangle(inMemoryCuts,
+          sizeof(inMemoryCuts) / sizeof(inMemoryCuts[0]), row, column);
+      float * pixel = &pixels[4 * (row * inMemoryWidth + column)];
+      pixel[0] = 0.05f;
+      pixel[1] = 0.08f;
+      pixel[2] = 0.1f;
+      pixel[3] = cut ? 0.05f : 0.4f + noise;
+      }
+    }
+  return pixels;
+}
+
+/*
+ * Validity mask (0 where pixels are not valid)
+ */
+static std::vector<unsigned char> CreateInMemoryMask()
+{
+  std::vector<unsigned char> mask(inMemoryWidth * inMemoryHeight);
+  for (int row = 0 ; row < inMemoryHeight ; row++)
+    for (int column = 0 ; column < inMemoryWidth ; column++)
+      mask[row * inMemoryWidth + column] = IsInMemoryRectangle(inMemoryMasked,
+          sizeof(inMemoryMasked) / sizeof(inMemoryMasked[0]), row, column) ? 0 : 255;
+  return mask;
+}
+
+static std::string GetInMemoryProjectionRef()
+{
+  OGRSpatialReference srs;
+  srs.importFromEPSG(32631);
+  char * wkt = NULL;
+  srs.exportToWkt(&wkt);
+  const std::string projectionRef(wkt);
+  CPLFree(wkt);
+  return projectionRef;
+}
+
+static bool WriteInMemoryRaster(const char * filename, const void * pixels, int nbBands, GDALDataType type)
+{
+  GDALDriver * driver = GetGDALDriverManager()->GetDriverByName("GTiff");
+  GDALDataset * dataset = driver->Create(filename, inMemoryWidth, inMemoryHeight, nbBands, type, NULL);
+  if (dataset == NULL)
+    {
+    std::cerr << "Unable to create " << filename << std::endl;
+    return false;
+    }
+  double geoTransform[6];
+  std::copy(inMemoryGeoTransform, inMemoryGeoTransform + 6, geoTransform);
+  dataset->SetGeoTransform(geoTransform);
+  dataset->SetProjection(GetInMemoryProjectionRef().c_str());
+
+  const int pixelSize = GDALGetDataTypeSize(type) / 8;
+  const bool ok = dataset->RasterIO(GF_Write, 0, 0, inMemoryWidth, inMemoryHeight, const_cast<void *>(pixels),
+      inMemoryWidth, inMemoryHeight, type, nbBands, NULL, nbBands * pixelSize,
+      nbBands * pixelSize * inMemoryWidth, pixelSize) == CE_None;
+  GDALClose(dataset);
+  if (!ok)
+    std::cerr << "Unable to write " << filename << std::endl;
+  return ok;
+}
+
+/*
+ * Same buffers as GeoTIFF files, for the file-based pipeline. The mask is a
+ * quality band whose bit 1 is set where pixels are not valid.
+ */
+int otbClearCutsInMemoryDetectorInputs(int argc, char * argv [])
+{
+  if (argc < 4)
+    {
+    std::cerr << "Usage: " << argv[0] << " before.tif after.tif qa.tif" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  const std::vector<float> before = CreateInMemoryBuffer(false);
+  const std::vector<float> after = CreateInMemoryBuffer(true);
+  std::vector<unsigned char> quality = CreateInMemoryMask();
+  for (unsigned int i = 0 ; i < quality.size() ; i++)
+    quality[i] = quality[i] == 0 ? 1 : 0;
+
+  GDALAllRegister();
+  if (!WriteInMemoryRaster(argv[1], &before[0], 4, GDT_Float32) ||
+      !WriteInMemoryRaster(argv[2], &after[0], 4, GDT_Float32) ||
+      !WriteInMemoryRaster(argv[3], &quality[0], 1, GDT_Byte))
+    return EXIT_FAILURE;
+  return EXIT_SUCCESS;
+}
+
+/*
+ * Rings with the same vertices, from the same first vertex, in any direction
+ */
+static bool SameInMemoryRing(const OGRLinearRing * ring, const OGRLinearRing * other)
+{
+  const int nbOfPoints = ring->getNumPoints() - 1;
+  if (nbOfPoints != other->getNumPoints() - 1 || nbOfPoints < 3)
+    return false;
+  if (ring->getX(0) != other->getX(0) || ring->getY(0) != other->getY(0))
+    return false;
+  bool forward = true;
+  bool backward = true;
+  for (int i = 1 ; i < nbOfPoints ; i++)
+    {
+    forward = forward && ring->getX(i) == other->getX(i) && ring->getY(i) == other->getY(i);
+    backward = backward && ring->getX(i) == other->getX(nbOfPoints - i)
+        && ring->getY(i) == other->getY(nbOfPoints - i);
+    }
+  return forward || backward;
+}
+
+static OGRLinearRing * CreateInMemoryRing(const InMemoryDataNodeType::PolygonType * polygon)
+{
+  OGRLinearRing * ring = new OGRLinearRing;
+  const InMemoryDataNodeType::PolygonType::VertexListType * vertices = polygon->GetVertexList();
+  for (unsigned int i = 0 ; i < vertices->Size() ; i++)
+    ring->addPoint(vertices->GetElement(i)[0], vertices->GetElement(i)[1]);
+  ring->closeRings();
+  return ring;
+}
+
+static bool SameInMemoryPolygon(OGRPolygon & polygon, OGRPolygon * other)
+{
+  if (other == NULL || polygon.getNumInteriorRings() != other->getNumInteriorRings() ||
+      !SameInMemoryRing(polygon.getExteriorRing(), other->getExteriorRing()))
+    return false;
+  for (int i = 0 ; i < polygon.getNumInteriorRings() ; i++)
+    if (!SameInMemoryRing(polygon.getInteriorRing(i), other->getInteriorRing(i)))
+      return false;
+  return true;
+}
+
+/*
+ * The detector, run on the buffers, must give the statistics and the layer
+ * of ClearCutsDetection with the sparse pipeline on the same images
+ */
+int otbClearCutsInMemoryDetectorTest(int argc, char * argv [])
+{
+  if (argc < 3)
+    {
+    std::cerr << "Usage: " << argv[0] << " reference_stats.txt reference.shp" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  const std::vector<float> before = CreateInMemoryBuffer(false);
+  const std::vector<float> after = CreateInMemoryBuffer(true);
+  const std::vector<unsigned char> mask = CreateInMemoryMask();
+
+  InMemoryDetectorType::Pointer detector = InMemoryDetectorType::New();
+  detector->SetInputBuffers(&before[0], 4, &after[0], 4, inMemoryWidth, inMemoryHeight);
+  detector->SetMaskBuffer(&mask[0]);
+  detector->SetGeoTransform(inMemoryGeoTransform);
+  detector->SetProjectionRef(GetInMemoryProjectionRef());
+  detector->Execute();
+
+  // Statistics, with the masked pixels excluded
+  otb::DeltaNDVIStatistics reference;
+  if (!reference.Read(argv[1]))
+    {
+    std::cerr << "Unable to read " << argv[1] << std::endl;
+    return EXIT_FAILURE;
+    }
+  const otb::DeltaNDVIStatistics & statistics = detector->GetStatistics();
+  bool ok = true;
+  if (statistics.GetCount() != reference.GetCount() || statistics.GetMean() != reference.GetMean()
+      || statistics.GetM2() != reference.GetM2())
+    {
+    std::cerr << "Statistics differ: count " << statistics.GetCount() << " / " << reference.GetCount()
+        << ", mean " << statistics.GetMean() << " / " << reference.GetMean()
+        << ", M2 " << statistics.GetM2() << " / " << reference.GetM2() << std::endl;
+    ok = false;
+    }
+  unsigned long nbOfMasked = 0;
+  for (unsigned int i = 0 ; i < mask.size() ; i++)
+    nbOfMasked += mask[i] == 0 ? 1 : 0;
+  if (statistics.GetCount() != mask.size() - nbOfMasked)
+    {
+    std::cerr << "Statistics of " << statistics.GetCount() << " pixels, "
+        << mask.size() - nbOfMasked << " valid pixels expected" << std::endl;
+    ok = false;
+    }
+
+  // Polygons, in the same order
+  GDALAllRegister();
+  GDALDataset * dataset = static_cast<GDALDataset *>(GDALOpenEx(argv[2], GDAL_OF_VECTOR, NULL, NULL, NULL));
+  if (dataset == NULL)
+    {
+    std::cerr << "Unable to open " << argv[2] << std::endl;
+    return EXIT_FAILURE;
+    }
+  OGRLayer * layer = dataset->GetLayer(0);
+  layer->ResetReading();
+
+  unsigned int nbOfPolygons = 0;
+  InMemoryTreeIteratorType it(detector->GetPolygons()->GetDataTree());
+  for (it.GoToBegin(); ok && !it.IsAtEnd(); ++it)
+    {
+    InMemoryDataNodeType::Pointer node = it.Get();
+    if (!node->IsPolygonFeature())
+      continue;
+    OGRPolygon polygon;
+    polygon.addRingDirectly(CreateInMemoryRing(node->GetPolygonExteriorRing()));
+    InMemoryDataNodeType::PolygonListType::Pointer holes = node->GetPolygonInteriorRings();
+    for (unsigned int i = 0 ; i < holes->Size() ; i++)
+      polygon.addRingDirectly(CreateInMemoryRing(holes->GetNthElement(i)));
+
+    OGRFeature * feature = layer->GetNextFeature();
+    OGRGeometry * geometry = feature ? feature->GetGeometryRef() : NULL;
+    OGRPolygon * referencePolygon = (geometry && wkbFlatten(geometry->getGeometryType()) == wkbPolygon) ?
+        static_cast<OGRPolygon *>(geometry) : NULL;
+    if (referencePolygon == NULL || feature->GetFieldAsInteger("DN") != node->GetFieldAsInt("DN")
+        || !SameInMemoryPolygon(polygon, referencePolygon))
+      {
+      char * wkt = NULL;
+      char * referenceWkt = NULL;
+      polygon.exportToWkt(&wkt);
+      if (geometry)
+        geometry->exportToWkt(&referenceWkt);
+      std::cerr << "Polygon " << nbOfPolygons << " differs:" << std::endl << "  reference: "
+          << (referenceWkt ? referenceWkt : "none") << std::endl << "  detector:  " << wkt << std::endl;
+      CPLFree(wkt);
+      CPLFree(referenceWkt);
+      ok = false;
+      }
+    OGRFeature::DestroyFeature(feature);
+    nbOfPolygons++;
+    }
+  if (ok && static_cast<GIntBig>(nbOfPolygons) != layer->GetFeatureCount())
+    {
+    std::cerr << "Detector has " << nbOfPolygons << " polygons, reference has "
+        << layer->GetFeatureCount() << std::endl;
+    ok = false;
+    }
+
+  // The cut inside the masked area is not detected, the bar is split in two
+  if (ok && nbOfPolygons != inMemoryNbOfPolygons)
+    {
+    std::cerr << "Detector has " << nbOfPolygons << " polygons, " << inMemoryNbOfPolygons
+        << " expected" << std::endl;
+    ok = false;
+    }
+
+  GDALClose(dataset);
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,124 @@
+/*=========================================================================
+
+  Copyright (c) Remi Cresson (IRSTEA). All rights reserved.
+
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#include "otbClearCutsReducers.h"
+#include "itkVariableLengthVector.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+
+typedef float                                                 ValueType;
+typedef itk::VariableLengthVector<ValueType>                  PixelType;
+typedef otb::Functor::MaxCC<ValueType>                        MaxCCType;
+typedef otb::Functor::MeanCC<ValueType>                       MeanCCType;
+typedef otb::Functor::CountCC<ValueType>                      CountCCType;
+typedef otb::Functor::LastDateCC<ValueType>                   LastDateCCType;
+typedef otb::Functor::WeightedModeCC<ValueType, false>        ModeCCType;
+typedef otb::Functor::WeightedModeCC<ValueType, true>         VoteCCType;
+typedef otb::Functor::ReducerChain<CountCCType,
+    otb::Functor::ReducerChain<LastDateCCType,
+    otb::Functor::ReducerChain<ModeCCType, VoteCCType> > >    AllCCType;
+
+// Labels of the inputs, for one pixel
+static const unsigned int nbOfInputs = 5;
+static const ValueType inputValues[nbOfInputs] = {1, 0, 2, 2, 1};
+
+template <class TReducer>
+PixelType Reduce(TReducer & reducer)
+{
+  reducer.Reset();
+  for (unsigned int i = 0 ; i < nbOfInputs ; i++)
+    reducer.Push(inputValues[i], i);
+
+  PixelType output(TReducer::NumberOfBands);
+  output.Fill(-1);
+  reducer.Fill(output, 0);
+  return output;
+}
+
+bool Check(const std::string & name, ValueType value, ValueType expected)
+{
+  if (value != expected)
+    {
+    std::cerr << name << ": got " << value << ", expected " << expected << std::endl;
+    return false;
+    }
+  return true;
+}
+
+int otbClearCutsReducersTest(int itkNotUsed(argc), char * itkNotUsed(argv) [])
+{
+  bool ok = true;
+
+  std::vector<double> dates;
+  dates.push_back(150);
+  dates.push_back(160);
+  dates.push_back(170);
+  dates.push_back(180);
+  dates.push_back(175);
+  std::vector<double> weights;
+  weights.push_back(3.0);
+  weights.push_back(1.0);
+  weights.push_back(1.0);
+  weights.push_back(1.0);
+  weights.push_back(2.0);
+
+  MaxCCType maxReducer;
+  ok &= Check("max", Reduce(maxReducer)[0], 2);
+
+  MeanCCType meanReducer;
+  ok &= Check("mean", Reduce(meanReducer)[0], 6.0 / 5.0);
+
+  CountCCType countReducer;
+  ok &= Check("count", Reduce(countReducer)[0], 4);
+
+  // Date rank, then input dates: the input 3 is the most recent detection
+  LastDateCCType lastDateReducer;
+  ok &= Check("lastdate (ranks)", Reduce(lastDateReducer)[0], 5);
+  lastDateReducer.SetInputDates(dates);
+  ok &= Check("lastdate (dates)", Reduce(lastDateReducer)[0], 180);
+
+  // Labels 1 and 2 are tied (2 votes each): the lowest one wins
+  ModeCCType modeReducer;
+  modeReducer.SetInputWeights(weights);
+  ok &= Check("mode", Reduce(modeReducer)[0], 1);
+
+  // Label 1 has a weight of 5, label 2 a weight of 2
+  VoteCCType voteReducer;
+  ok &= Check("vote (no weights)", Reduce(voteReducer)[0], 1);
+  voteReducer.SetInputWeights(weights);
+  ok &= Check("vote", Reduce(voteReducer)[0], 1);
+  weights[0] = 0.5;
+  weights[4] = 0.5;
+  voteReducer.SetInputWeights(weights);
+  ok &= Check("vote (reweighted)", Reduce(voteReducer)[0], 2);
+
+  // The chain fills the bands of each reducer, in order
+  AllCCType allReducer;
+  allReducer.SetInputDates(dates);
+  allReducer.SetInputWeights(weights);
+  PixelType all = Reduce(allReducer);
+  ok &= Check("all bands", all.GetSize(), 4);
+  ok &= Check("all (count)", all[0], 4);
+  ok &= Check("all (lastdate)", all[1], 180);
+  ok &= Check("all (mode)", all[2], 1);
+  ok &= Check("all (vote)", all[3], 2);
+
+  // Reset between pixels
+  allReducer.Reset();
+  allReducer.Fill(all, 0);
+  ok &= Check("reset (count)", all[0], 0);
+  ok &= Check("reset (lastdate)", all[1], 0);
+  ok &= Check("reset (mode)", all[2], 0);
+
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,209 @@
+/*=========================================================================
+
+  Copyright (c) Remi Cresson (IRSTEA). All rights reserved.
+
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#include "itkMacro.h"
+
+#include "gdal.h"
+#include "gdal_priv.h"
+#include "ogrsf_frmts.h"
+#include "ogr_spatialref.h"
+
+#include <iostream>
+#include <vector>
+#include <cstdlib>
+
+// Three parts of 256 rows
+static const int stitchWidth = 320;
+static const int stitchHeight = 768;
+
+// Clear cuts (rows and columns, inclusive) crossing the parts boundaries
+// (rows 256 and 512): a rectangle, a U joined in the next part, a ring
+// whose hole is split by a boundary, a bar across all the parts, and a
+// rectangle inside a part
+struct StitchingCut
+{
+  int firstRow;
+  int lastRow;
+  int firstColumn;
+  int lastColumn;
+  bool hole;
+};
+
+static const StitchingCut stitchCuts[] =
+{
+  {200, 300,  20,  60, false},
+  {220, 300, 100, 110, false},
+  {220, 300, 130, 140, false},
+  {290, 300, 100, 140, false},
+  {480, 560, 200, 260, false},
+  {500, 540, 220, 240, true},
+  {100, 700, 280, 290, false},
+  { 50,  80, 150, 180, false},
+};
+
+static bool IsStitchingCut(int row, int column)
+{
+  bool cut = false;
+  for (unsigned int i = 0 ; i < sizeof(stitchCuts) / sizeof(stitchCuts[0]) ; i++)
+    {
+    const StitchingCut & rect = stitchCuts[i];
+    if (row >= rect.firstRow && row <= rect.lastRow && column >= rect.firstColumn && column <= rect.lastColumn)
+      cut = !rect.hole;
+    }
+  return cut;
+}
+
+/*
+ * Red and near infrared bands (1 and 4) of a forest, with some noise. At
+ * the second date, the near infrared drops in the clear cuts.
+ */
+static bool WriteStitchingImage(const char * filename, bool after)
+{
+  GDALDriver * driver = GetGDALDriverManager()->GetDriverByName("GTiff");
+  GDALDataset * dataset = driver->Create(filename, stitchWidth, stitchHeight, 4, GDT_Float32, NULL);
+  if (dataset == NULL)
+    {
+    std::cerr << "Unable to create " << filename << std::endl;
+    return false;
+    }
+
+  // Pixel size and origin which are not exact in binary
+  double geoTransform[6] = {612345.7, 0.3, 0.0, 4876543.1, 0.0, -0.3};
+  dataset->SetGeoTransform(geoTransform);
+  OGRSpatialReference srs;
+  srs.importFromEPSG(32631);
+  char * wkt = NULL;
+  srs.exportToWkt(&wkt);
+  dataset->SetProjection(wkt);
+  CPLFree(wkt);
+
+  std::vector<float> pixels(4 * stitchWidth * stitchHeight);
+  unsigned int state = after ? 4321 : 1234;
+  for (int row = 0 ; row < stitchHeight ; row++)
+    {
+    for (int column = 0 ; column < stitchWidth ; column++)
+      {
+      state = state * 1103515245 + 12345;
+      const float noise = static_cast<float>((state >> 16) & 0xFF) / 25600.0f;
+      float * pixel = &pixels[4 * (row * stitchWidth + column)];
+      pixel[0] = 0.05f;
+      pixel[1] = 0.08f;
+      pixel[2] = 0.1f;
+      pixel[3] = (after && IsStitchingCut(row, column)) ? 0.05f : 0.4f + noise;
+      }
+    }
+  const bool ok = dataset->RasterIO(GF_Write, 0, 0, stitchWidth, stitchHeight, &pixels[0],
+      stitchWidth, stitchHeight, GDT_Float32, 4, NULL, 4 * sizeof(float),
+      4 * sizeof(float) * stitchWidth, sizeof(float)) == CE_None;
+  GDALClose(dataset);
+  if (!ok)
+    std::cerr << "Unable to write " << filename << std::endl;
+  return ok;
+}
+
+int otbClearCutsStitchingInputs(int argc, char * argv [])
+{
+  if (argc < 3)
+    {
+    std::cerr << "Usage: " << argv[0] << " before.tif after.tif" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  GDALAllRegister();
+  if (!WriteStitchingImage(argv[1], false) || !WriteStitchingImage(argv[2], true))
+    return EXIT_FAILURE;
+  return EXIT_SUCCESS;
+}
+
+/*
+ * The stitched layer must be identical to the single-process one: same
+ * features, in the same order, with the same attributes and vertices
+ */
+int otbClearCutsStitchingCompare(int argc, char * argv [])
+{
+  if (argc < 3)
+    {
+    std::cerr << "Usage: " << argv[0] << " reference.shp stitched.shp" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  GDALAllRegister();
+  GDALDataset * reference = static_cast<GDALDataset *>(GDALOpenEx(argv[1], GDAL_OF_VECTOR, NULL, NULL, NULL));
+  GDALDataset * stitched = static_cast<GDALDataset *>(GDALOpenEx(argv[2], GDAL_OF_VECTOR, NULL, NULL, NULL));
+  if (reference == NULL || stitched == NULL)
+    {
+    std::cerr << "Unable to open the layers" << std::endl;
+    if (reference != NULL)
+      GDALClose(reference);
+    if (stitched != NULL)
+      GDALClose(stitched);
+    return EXIT_FAILURE;
+    }
+
+  OGRLayer * referenceLayer = reference->GetLayer(0);
+  OGRLayer * stitchedLayer = stitched->GetLayer(0);
+  bool ok = true;
+  if (referenceLayer->GetFeatureCount() != stitchedLayer->GetFeatureCount())
+    {
+    std::cerr << "Reference has " << referenceLayer->GetFeatureCount() << " polygons, stitched layer has "
+        << stitchedLayer->GetFeatureCount() << std::endl;
+    ok = false;
+    }
+
+  // Expected polygons (the U is a single polygon, the ring has a hole)
+  if (referenceLayer->GetFeatureCount() != 5)
+    {
+    std::cerr << "Reference has " << referenceLayer->GetFeatureCount() << " polygons, 5 expected" << std::endl;
+    ok = false;
+    }
+
+  referenceLayer->ResetReading();
+  stitchedLayer->ResetReading();
+  OGRFeature * referenceFeature;
+  unsigned int nbOfHoles = 0;
+  for (unsigned int i = 0 ; ok && (referenceFeature = referenceLayer->GetNextFeature()) != NULL ; i++)
+    {
+    OGRFeature * stitchedFeature = stitchedLayer->GetNextFeature();
+    OGRGeometry * referenceGeometry = referenceFeature->GetGeometryRef();
+    OGRGeometry * stitchedGeometry = stitchedFeature ? stitchedFeature->GetGeometryRef() : NULL;
+    if (stitchedGeometry == NULL || referenceGeometry == NULL
+        || referenceFeature->GetFieldAsInteger("DN") != stitchedFeature->GetFieldAsInteger("DN")
+        || !referenceGeometry->Equals(stitchedGeometry))
+      {
+      char * referenceWkt = NULL;
+      char * stitchedWkt = NULL;
+      if (referenceGeometry)
+        referenceGeometry->exportToWkt(&referenceWkt);
+      if (stitchedGeometry)
+        stitchedGeometry->exportToWkt(&stitchedWkt);
+      std::cerr << "Polygon " << i << " differs:" << std::endl << "  reference: "
+          << (referenceWkt ? referenceWkt : "none") << std::endl << "  stitched:  "
+          << (stitchedWkt ? stitchedWkt : "none") << std::endl;
+      CPLFree(referenceWkt);
+      CPLFree(stitchedWkt);
+      ok = false;
+      }
+    else if (wkbFlatten(referenceGeometry->getGeometryType()) == wkbPolygon)
+      {
+      nbOfHoles += static_cast<OGRPolygon *>(referenceGeometry)->getNumInteriorRings();
+      }
+    OGRFeature::DestroyFeature(referenceFeature);
+    OGRFeature::DestroyFeature(stitchedFeature);
+    }
+  if (ok && nbOfHoles != 1)
+    {
+    std::cerr << "Reference has " << nbOfHoles << " holes, 1 expected" << std::endl;
+    ok = false;
+    }
+
+  GDALClose(reference);
+  GDALClose(stitched);
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,263 @@
+/*=========================================================================
+
+  Copyright (c) Remi Cresson (IRSTEA). All rights reserved.
+
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#include "otbConnectedComponentsRunTable.h"
+#include "otbImage.h"
+#include "otbStreamingConnectedComponentsFilter.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
+
+typedef otb::ConnectedComponentsRunTable<unsigned char>       CCRunTableType;
+typedef otb::Image<unsigned char, 2>                          CCLabelImageType;
+typedef otb::Image<float, 2>                                  CCValueImageType;
+typedef otb::StreamingConnectedComponentsFilter<CCLabelImageType, CCValueImageType> CCFilterType;
+
+// Labels (0 is no-data). Tiles of ccTileWidth x ccTileHeight cut the
+// components: U shapes, a ring with a hole, diagonal contacts, and
+// touching components of different labels.
+static const unsigned int ccWidth = 16;
+static const unsigned int ccHeight = 12;
+static const unsigned int ccTileWidth = 5;
+static const unsigned int ccTileHeight = 4;
+static const char * ccLabels[ccHeight] = {
+    "1111.....2222...",
+    "1..1....2....1..",
+    "1..1...2......1.",
+    "1..11112..111..1",
+    "1......2..1.1...",
+    "11111..2..111..2",
+    "....1.22.......2",
+    ".1..1......1.1.2",
+    "..1.1111..1.1..2",
+    "...1......1111.2",
+    "2222...1.1.....2",
+    "......1...1111.."};
+
+static unsigned char GetCCLabel(long x, long y)
+{
+  return ccLabels[y][x] == '.' ? 0 : static_cast<unsigned char>(ccLabels[y][x] - '0');
+}
+
+/*
+ * Reference: flood fill of each component, numbered in raster order
+ */
+static void ComputeReferenceComponents(bool fullyConnected, std::vector<long> & ids, unsigned long & nbOfComponents)
+{
+  ids.assign(ccWidth * ccHeight, -1);
+  nbOfComponents = 0;
+  for (long y0 = 0 ; y0 < static_cast<long>(ccHeight) ; y0++)
+    {
+    for (long x0 = 0 ; x0 < static_cast<long>(ccWidth) ; x0++)
+      {
+      const unsigned char label = GetCCLabel(x0, y0);
+      if (label == 0 || ids[y0 * ccWidth + x0] >= 0)
+        continue;
+      std::vector<long> stack(1, y0 * ccWidth + x0);
+      ids[y0 * ccWidth + x0] = nbOfComponents;
+      while (!stack.empty())
+        {
+        const long x = stack.back() % ccWidth;
+        const long y = stack.back() / ccWidth;
+        stack.pop_back();
+        for (long dy = -1 ; dy <= 1 ; dy++)
+          {
+          for (long dx = -1 ; dx <= 1 ; dx++)
+            {
+            const long nx = x + dx;
+            const long ny = y + dy;
+            if ((dx == 0 && dy == 0) || (!fullyConnected && dx != 0 && dy != 0)
+                || nx < 0 || ny < 0 || nx >= static_cast<long>(ccWidth) || ny >= static_cast<long>(ccHeight))
+              continue;
+            if (GetCCLabel(nx, ny) == label && ids[ny * ccWidth + nx] < 0)
+              {
+              ids[ny * ccWidth + nx] = nbOfComponents;
+              stack.push_back(ny * ccWidth + nx);
+              }
+            }
+          }
+        }
+      nbOfComponents++;
+      }
+    }
+}
+
+/*
+ * Runs of a region of the labels, row by row
+ */
+static void AddCCRuns(CCRunTableType & runTable, long xStart, long yStart, long xEnd, long yEnd)
+{
+  for (long y = yStart ; y < yEnd ; y++)
+    {
+    long x = xStart;
+    while (x < xEnd)
+      {
+      const unsigned char label = GetCCLabel(x, y);
+      const long start = x;
+      while (x < xEnd && GetCCLabel(x, y) == label)
+        x++;
+      if (label != 0)
+        runTable.AddRun(y, start, x - 1, label, 1.0, x - start);
+      }
+    }
+}
+
+/*
+ * Compare the components of the run table with the reference
+ */
+static bool CheckCCRunTable(const std::string & name, const CCRunTableType & runTable,
+    const std::vector<long> & ids, unsigned long nbOfComponents)
+{
+  if (runTable.GetNumberOfComponents() != nbOfComponents)
+    {
+    std::cerr << name << ": " << runTable.GetNumberOfComponents() << " components, "
+        << nbOfComponents << " expected" << std::endl;
+    return false;
+    }
+
+  std::vector<unsigned long> areas(nbOfComponents, 0);
+  std::vector<long> xMin(nbOfComponents, ccWidth), xMax(nbOfComponents, -1);
+  std::vector<long> yMin(nbOfComponents, ccHeight), yMax(nbOfComponents, -1);
+  CCRunTableType::RunIdListType runs;
+  for (long y = 0 ; y < static_cast<long>(ccHeight) ; y++)
+    {
+    for (long x = 0 ; x < static_cast<long>(ccWidth) ; x++)
+      {
+      const long id = ids[y * ccWidth + x];
+      runTable.GetRuns(y, x, x, runs);
+      if (id < 0)
+        {
+        if (!runs.empty())
+          {
+          std::cerr << name << ": run on a no-data pixel at " << x << "," << y << std::endl;
+          return false;
+          }
+        continue;
+        }
+      if (runs.size() != 1 || runTable.GetComponentId(runs[0]) != static_cast<unsigned long>(id))
+        {
+        std::cerr << name << ": wrong component at " << x << "," << y << std::endl;
+        return false;
+        }
+      areas[id]++;
+      xMin[id] = std::min(xMin[id], x);
+      xMax[id] = std::max(xMax[id], x);
+      yMin[id] = std::min(yMin[id], y);
+      yMax[id] = std::max(yMax[id], y);
+      }
+    }
+
+  for (unsigned long id = 0 ; id < nbOfComponents ; id++)
+    {
+    const CCRunTableType::ComponentAttributes & attributes = runTable.GetComponentAttributes(id);
+    if (attributes.area != areas[id] || attributes.xMin != xMin[id] || attributes.xMax != xMax[id]
+        || attributes.yMin != yMin[id] || attributes.yMax != yMax[id])
+      {
+      std::cerr << name << ": wrong attributes of component " << id << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+static CCLabelImageType::Pointer CreateCCLabelImage()
+{
+  CCLabelImageType::RegionType region;
+  region.SetIndex(0, 0);
+  region.SetIndex(1, 0);
+  region.SetSize(0, ccWidth);
+  region.SetSize(1, ccHeight);
+  CCLabelImageType::Pointer image = CCLabelImageType::New();
+  image->SetRegions(region);
+  image->Allocate();
+  for (long y = 0 ; y < static_cast<long>(ccHeight) ; y++)
+    {
+    for (long x = 0 ; x < static_cast<long>(ccWidth) ; x++)
+      {
+      CCLabelImageType::IndexType index;
+      index[0] = x;
+      index[1] = y;
+      image->SetPixel(index, GetCCLabel(x, y));
+      }
+    }
+  return image;
+}
+
+int otbConnectedComponentsRunTableTest(int itkNotUsed(argc), char * itkNotUsed(argv) [])
+{
+  bool ok = true;
+
+  // Diagonal contact: merged in 8-connectivity only
+  CCRunTableType diagonal;
+  diagonal.AddRun(0, 0, 1, 1);
+  diagonal.AddRun(1, 2, 3, 1);
+  diagonal.Finalize();
+  if (diagonal.GetNumberOfComponents() != 2)
+    {
+    std::cerr << "Diagonal runs merged in 4-connectivity" << std::endl;
+    ok = false;
+    }
+  diagonal.Clear();
+  diagonal.SetFullyConnected(true);
+  diagonal.AddRun(0, 0, 1, 1);
+  diagonal.AddRun(1, 2, 3, 1);
+  diagonal.Finalize();
+  if (diagonal.GetNumberOfComponents() != 1)
+    {
+    std::cerr << "Diagonal runs not merged in 8-connectivity" << std::endl;
+    ok = false;
+    }
+
+  CCLabelImageType::Pointer image = CreateCCLabelImage();
+  for (unsigned int connectivity = 4 ; connectivity <= 8 ; connectivity += 4)
+    {
+    const bool fullyConnected = (connectivity == 8);
+    std::vector<long> ids;
+    unsigned long nbOfComponents;
+    ComputeReferenceComponents(fullyConnected, ids, nbOfComponents);
+    const std::string suffix = fullyConnected ? " (8-connectivity)" : " (4-connectivity)";
+
+    // Whole rows, in raster order
+    CCRunTableType rows;
+    rows.SetFullyConnected(fullyConnected);
+    AddCCRuns(rows, 0, 0, ccWidth, ccHeight);
+    rows.Finalize();
+    ok &= CheckCCRunTable("rows" + suffix, rows, ids, nbOfComponents);
+
+    // Tiles, in reverse order: runs are cut at the seams
+    CCRunTableType tiles;
+    tiles.SetFullyConnected(fullyConnected);
+    for (long ty = (ccHeight - 1) / ccTileHeight ; ty >= 0 ; ty--)
+      {
+      for (long tx = (ccWidth - 1) / ccTileWidth ; tx >= 0 ; tx--)
+        {
+        AddCCRuns(tiles, tx * ccTileWidth, ty * ccTileHeight,
+            std::min<long>((tx + 1) * ccTileWidth, ccWidth), std::min<long>((ty + 1) * ccTileHeight, ccHeight));
+        }
+      }
+    tiles.Finalize();
+    ok &= CheckCCRunTable("tiles" + suffix, tiles, ids, nbOfComponents);
+
+    // Streamed filter, with tiles and threads
+    CCFilterType::Pointer filter = CCFilterType::New();
+    filter->SetInput(image);
+    filter->SetNoDataPixel(0);
+    filter->SetFullyConnected(fullyConnected);
+    filter->GetFilter()->SetNumberOfThreads(3);
+    filter->GetStreamer()->SetNumberOfDivisionsTiledStreaming(6);
+    filter->Update();
+    ok &= CheckCCRunTable("streamed" + suffix, filter->GetRunTable(), ids, nbOfComponents);
+    }
+
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
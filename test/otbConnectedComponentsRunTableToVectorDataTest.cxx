@@ -0,0 +1,222 @@
+/*=========================================================================
+
+  Copyright (c) Remi Cresson (IRSTEA). All rights reserved.
+
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#include "otbConnectedComponentsRunTable.h"
+#include "otbConnectedComponentsRunTableToVectorDataFilter.h"
+#include "otbImage.h"
+#include "itkPreOrderTreeIterator.h"
+
+#include "gdal.h"
+#include "gdal_alg.h"
+#include "gdal_priv.h"
+#include "ogrsf_frmts.h"
+
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
+
+typedef otb::ConnectedComponentsRunTable<unsigned char>                     PolyRunTableType;
+typedef otb::ConnectedComponentsRunTableToVectorDataFilter<PolyRunTableType> PolygonsFilterType;
+typedef PolygonsFilterType::VectorDataType                                  PolyVectorDataType;
+typedef PolyVectorDataType::DataNodeType                                    PolyDataNodeType;
+typedef itk::PreOrderTreeIterator<PolyVectorDataType::DataTreeType>          PolyTreeIteratorType;
+typedef otb::Image<unsigned char, 2>                                        PolyLabelImageType;
+
+// Labels (0 is no-data): holes, a hole in a hole, pixels touching by a
+// corner only (one 8-connected component, several 4-connected polygons),
+// single pixels, and components of different labels sharing edges
+static const unsigned int polyWidth = 18;
+static const unsigned int polyHeight = 12;
+static const char * polyLabels[polyHeight] = {
+    "111111111.....2...",
+    "1.......1....2.2..",
+    "1.22222.1...2...2.",
+    "1.2...2.1..2..1..2",
+    "1.2.1.2.1...2...2.",
+    "1.2...2.1....2.2..",
+    "1.22222.11....2...",
+    "1.......1.1.......",
+    "111111111..1.1..22",
+    "....1.......1.1.21",
+    ".1...1.1.......211",
+    "..1...1.2222222222"};
+
+/*
+ * Comparable description of a polygon: label, envelope, area, holes
+ */
+struct PolygonKey
+{
+  int    label;
+  double minX;
+  double minY;
+  double maxX;
+  double maxY;
+  double area;
+  int    nbOfHoles;
+
+  bool operator<(const PolygonKey & other) const
+  {
+    if (label != other.label) return label < other.label;
+    if (minX != other.minX) return minX < other.minX;
+    if (minY != other.minY) return minY < other.minY;
+    if (maxX != other.maxX) return maxX < other.maxX;
+    if (maxY != other.maxY) return maxY < other.maxY;
+    if (area != other.area) return area < other.area;
+    return nbOfHoles < other.nbOfHoles;
+  }
+  bool operator==(const PolygonKey & other) const { return !(*this < other) && !(other < *this); }
+};
+
+static PolygonKey GetPolygonKey(OGRPolygon & polygon, int label)
+{
+  OGREnvelope envelope;
+  polygon.getEnvelope(&envelope);
+  PolygonKey key = {label, envelope.MinX, envelope.MinY, envelope.MaxX, envelope.MaxY,
+      polygon.get_Area(), polygon.getNumInteriorRings()};
+  return key;
+}
+
+static OGRLinearRing * CreateRing(const PolyDataNodeType::PolygonType * polygon)
+{
+  OGRLinearRing * ring = new OGRLinearRing;
+  const PolyDataNodeType::PolygonType::VertexListType * vertices = polygon->GetVertexList();
+  for (unsigned int i = 0 ; i < vertices->Size() ; i++)
+    ring->addPoint(vertices->GetElement(i)[0], vertices->GetElement(i)[1]);
+  ring->closeRings();
+  return ring;
+}
+
+/*
+ * Polygons traced from the runs, and polygons of GDALPolygonize on the
+ * rasterized components, must describe the same pixels
+ */
+static bool CheckPolygons(unsigned int minNumberOfComponents)
+{
+  // Run table of the 8-connected components
+  PolyRunTableType runTable;
+  runTable.SetFullyConnected(true);
+  for (long y = 0 ; y < static_cast<long>(polyHeight) ; y++)
+    {
+    long x = 0;
+    while (x < static_cast<long>(polyWidth))
+      {
+      const char label = polyLabels[y][x];
+      const long start = x;
+      while (x < static_cast<long>(polyWidth) && polyLabels[y][x] == label)
+        x++;
+      if (label != '.')
+        runTable.AddRun(y, start, x - 1, label - '0');
+      }
+    }
+  runTable.Finalize();
+
+  // Same components, as an image without the small components
+  std::vector<unsigned char> pixels(polyWidth * polyHeight, 0);
+  for (PolyRunTableType::RunIdType id = 0 ; id < runTable.GetNumberOfRuns() ; id++)
+    {
+    const PolyRunTableType::Run & run = runTable.GetRun(id);
+    if (runTable.GetComponentSize(runTable.GetComponentId(id)) <= minNumberOfComponents)
+      continue;
+    for (long x = run.start ; x <= run.end ; x++)
+      pixels[run.row * polyWidth + x] = run.value;
+    }
+
+  // GDALPolygonize, with pixel corners on integer coordinates
+  GDALAllRegister();
+  GDALDriver * rasterDriver = GetGDALDriverManager()->GetDriverByName("MEM");
+  GDALDataset * raster = rasterDriver->Create("", polyWidth, polyHeight, 1, GDT_Byte, NULL);
+  double geoTransform[6] = {0.0, 1.0, 0.0, 0.0, 0.0, 1.0};
+  raster->SetGeoTransform(geoTransform);
+  GDALRasterBand * band = raster->GetRasterBand(1);
+  if (band->RasterIO(GF_Write, 0, 0, polyWidth, polyHeight, &pixels[0], polyWidth, polyHeight,
+      GDT_Byte, 0, 0, NULL) != CE_None)
+    {
+    std::cerr << "Unable to write the MEM raster" << std::endl;
+    GDALClose(raster);
+    return false;
+    }
+  GDALDriver * vectorDriver = GetGDALDriverManager()->GetDriverByName("Memory");
+  GDALDataset * vector = vectorDriver->Create("", 0, 0, 0, GDT_Unknown, NULL);
+  OGRLayer * layer = vector->CreateLayer("polygons", NULL, wkbPolygon, NULL);
+  OGRFieldDefn field("DN", OFTInteger);
+  layer->CreateField(&field);
+  GDALPolygonize(band, band, layer, 0, NULL, NULL, NULL);
+
+  std::vector<PolygonKey> gdalPolygons;
+  layer->ResetReading();
+  OGRFeature * feature;
+  while ((feature = layer->GetNextFeature()) != NULL)
+    {
+    OGRPolygon * polygon = static_cast<OGRPolygon *>(feature->GetGeometryRef());
+    gdalPolygons.push_back(GetPolygonKey(*polygon, feature->GetFieldAsInteger("DN")));
+    OGRFeature::DestroyFeature(feature);
+    }
+  GDALClose(vector);
+  GDALClose(raster);
+
+  // Polygons traced from the runs. The origin is the center of the first pixel.
+  PolyLabelImageType::Pointer referenceImage = PolyLabelImageType::New();
+  PolyLabelImageType::PointType origin;
+  origin.Fill(0.5);
+  referenceImage->SetOrigin(origin);
+
+  PolygonsFilterType::Pointer filter = PolygonsFilterType::New();
+  filter->SetRunTable(&runTable);
+  filter->SetReferenceImage(referenceImage);
+  filter->SetFieldName("DN");
+  filter->SetMinNumberOfComponents(minNumberOfComponents);
+  filter->Update();
+
+  std::vector<PolygonKey> runsPolygons;
+  PolyTreeIteratorType it(filter->GetOutput()->GetDataTree());
+  for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+    {
+    PolyDataNodeType::Pointer node = it.Get();
+    if (!node->IsPolygonFeature())
+      continue;
+    OGRPolygon polygon;
+    polygon.addRingDirectly(CreateRing(node->GetPolygonExteriorRing()));
+    PolyDataNodeType::PolygonListType::Pointer holes = node->GetPolygonInteriorRings();
+    for (unsigned int i = 0 ; i < holes->Size() ; i++)
+      polygon.addRingDirectly(CreateRing(holes->GetNthElement(i)));
+    runsPolygons.push_back(GetPolygonKey(polygon, node->GetFieldAsInt("DN")));
+    }
+
+  std::sort(gdalPolygons.begin(), gdalPolygons.end());
+  std::sort(runsPolygons.begin(), runsPolygons.end());
+  if (gdalPolygons.size() != runsPolygons.size() || !std::equal(gdalPolygons.begin(), gdalPolygons.end(),
+      runsPolygons.begin()))
+    {
+    std::cerr << "Filter " << minNumberOfComponents << ": " << runsPolygons.size()
+        << " polygons traced from the runs, " << gdalPolygons.size() << " from GDALPolygonize" << std::endl;
+    for (unsigned int i = 0 ; i < std::max(gdalPolygons.size(), runsPolygons.size()) ; i++)
+      {
+      if (i < runsPolygons.size())
+        std::cerr << "  runs: DN " << runsPolygons[i].label << " (" << runsPolygons[i].minX << ","
+          << runsPolygons[i].minY << ")-(" << runsPolygons[i].maxX << "," << runsPolygons[i].maxY
+          << ") area " << runsPolygons[i].area << " holes " << runsPolygons[i].nbOfHoles << std::endl;
+      if (i < gdalPolygons.size())
+        std::cerr << "  gdal: DN " << gdalPolygons[i].label << " (" << gdalPolygons[i].minX << ","
+          << gdalPolygons[i].minY << ")-(" << gdalPolygons[i].maxX << "," << gdalPolygons[i].maxY
+          << ") area " << gdalPolygons[i].area << " holes " << gdalPolygons[i].nbOfHoles << std::endl;
+      }
+    return false;
+    }
+  return true;
+}
+
+int otbConnectedComponentsRunTableToVectorDataTest(int itkNotUsed(argc), char * itkNotUsed(argv) [])
+{
+  bool ok = true;
+  ok &= CheckPolygons(0);
+  ok &= CheckPolygons(3);
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,203 @@
+/*=========================================================================
+
+  Copyright (c) Remi Cresson (IRSTEA). All rights reserved.
+
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#include "otbImage.h"
+#include "otbExtractROI.h"
+#include "otbStreamingDeltaNDVIStatisticsFilter.h"
+#include "itkImageRegionIterator.h"
+#include "itkImageRegionConstIterator.h"
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <cstdlib>
+#include <cmath>
+
+typedef otb::Image<float, 2>                                    FloatImageType;
+typedef otb::StreamingDeltaNDVIStatisticsFilter<FloatImageType> StatsFilterType;
+typedef otb::ExtractROI<float, float>                           ExtractROIFilterType;
+
+static const float statsNoDataValue = -10.0;
+static const unsigned int statsBlockSize = 256;
+
+enum StatsStreamingMode
+{
+  streaming_aligned, streaming_stripped, streaming_tiled
+};
+
+/*
+ * dNDVI-like values, with no-data pixels. The number of rows is not a
+ * multiple of the block size.
+ */
+static FloatImageType::Pointer CreateDeltaNDVIImage()
+{
+  FloatImageType::RegionType region;
+  region.SetIndex(0, 0);
+  region.SetIndex(1, 0);
+  region.SetSize(0, 700);
+  region.SetSize(1, 1100);
+
+  FloatImageType::Pointer image = FloatImageType::New();
+  image->SetRegions(region);
+  image->Allocate();
+
+  unsigned int state = 12345;
+  itk::ImageRegionIterator<FloatImageType> it(image, region);
+  for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+    {
+    state = state * 1103515245 + 12345;
+    const float value = static_cast<float>((state >> 8) & 0xFFFF) / 32768.0f - 1.0f;
+    it.Set((state >> 24) % 17 == 0 ? statsNoDataValue : value);
+    }
+  return image;
+}
+
+static otb::DeltaNDVIStatistics ComputeStatistics(FloatImageType * image, unsigned int nbOfThreads,
+    StatsStreamingMode streamingMode, unsigned int parameter)
+{
+  StatsFilterType::Pointer filter = StatsFilterType::New();
+  filter->SetInput(image);
+  filter->SetIgnoreUserDefinedValue(true);
+  filter->SetUserIgnoredValue(statsNoDataValue);
+  filter->SetBlockSize(statsBlockSize);
+  filter->GetFilter()->SetNumberOfThreads(nbOfThreads);
+  if (streamingMode == streaming_aligned)
+    filter->SetBlockAlignedStreaming(parameter);
+  else if (streamingMode == streaming_stripped)
+    filter->GetStreamer()->SetNumberOfDivisionsStrippedStreaming(parameter);
+  else
+    filter->GetStreamer()->SetNumberOfDivisionsTiledStreaming(parameter);
+  filter->Update();
+  return filter->GetStatistics();
+}
+
+static bool CheckStatistics(const std::string & name, const otb::DeltaNDVIStatistics & statistics,
+    const otb::DeltaNDVIStatistics & expected)
+{
+  if (statistics.GetCount() != expected.GetCount() || statistics.GetMean() != expected.GetMean()
+      || statistics.GetM2() != expected.GetM2()
+      || statistics.GetNumberOfBands() != expected.GetNumberOfBands())
+    {
+    std::cerr.precision(17);
+    std::cerr << name << ": count " << statistics.GetCount() << " mean " << statistics.GetMean()
+        << " m2 " << statistics.GetM2() << " bands " << statistics.GetNumberOfBands()
+        << ", expected count " << expected.GetCount() << " mean " << expected.GetMean()
+        << " m2 " << expected.GetM2() << " bands " << expected.GetNumberOfBands() << std::endl;
+    return false;
+    }
+  return true;
+}
+
+/*
+ * Mean and standard deviation of the valid pixels, with two passes in long
+ * double precision
+ */
+static bool CheckAccuracy(FloatImageType * image, const otb::DeltaNDVIStatistics & statistics)
+{
+  long double sum = 0.0;
+  unsigned long count = 0;
+  itk::ImageRegionConstIterator<FloatImageType> it(image, image->GetLargestPossibleRegion());
+  for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+    {
+    if (it.Get() != statsNoDataValue)
+      {
+      sum += it.Get();
+      count++;
+      }
+    }
+  const long double mean = sum / count;
+  long double m2 = 0.0;
+  for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+    {
+    if (it.Get() != statsNoDataValue)
+      {
+      m2 += (it.Get() - mean) * (it.Get() - mean);
+      }
+    }
+  const double sigma = std::sqrt(static_cast<double>(m2 / count));
+
+  if (statistics.GetCount() != count
+      || std::abs(statistics.GetMean() - static_cast<double>(mean)) > 1e-13
+      || std::abs(statistics.GetSigma() - sigma) > 1e-13 * sigma)
+    {
+    std::cerr.precision(17);
+    std::cerr << "Inaccurate moments: mean " << statistics.GetMean() << " sigma " << statistics.GetSigma()
+        << ", expected mean " << static_cast<double>(mean) << " sigma " << sigma << std::endl;
+    return false;
+    }
+  return true;
+}
+
+int otbDeltaNDVIStatisticsTest(int argc, char * argv [])
+{
+  if (argc < 2)
+    {
+    std::cerr << "Usage: " << argv[0] << " partialStatisticsPrefix" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  FloatImageType::Pointer image = CreateDeltaNDVIImage();
+  bool ok = true;
+
+  // Reference: a single thread, a single strip
+  const otb::DeltaNDVIStatistics reference = ComputeStatistics(image, 1, streaming_aligned, 1024);
+  ok &= CheckStatistics("bands", reference, reference);
+  ok &= CheckAccuracy(image, reference);
+  if (reference.GetNumberOfBands() != 5)
+    {
+    std::cerr << "Wrong number of bands: " << reference.GetNumberOfBands() << std::endl;
+    ok = false;
+    }
+
+  // Threads and streaming tiles (aligned or not on the blocks)
+  ok &= CheckStatistics("aligned strips, 5 threads",
+      ComputeStatistics(image, 5, streaming_aligned, 1), reference);
+  ok &= CheckStatistics("7 strips, 3 threads",
+      ComputeStatistics(image, 3, streaming_stripped, 7), reference);
+  ok &= CheckStatistics("9 tiles, 8 threads",
+      ComputeStatistics(image, 8, streaming_tiled, 9), reference);
+  ok &= CheckStatistics("25 tiles, 2 threads",
+      ComputeStatistics(image, 2, streaming_tiled, 25), reference);
+
+  // Parts of whole bands, written and read like mode.stats and mode.detect do
+  const unsigned int partRows[] = {0, 512, 768, 1100};
+  const unsigned int nbOfParts = 3;
+  otb::DeltaNDVIStatistics merged;
+  for (unsigned int part = 0 ; part < nbOfParts ; part++)
+    {
+    FloatImageType::RegionType partRegion = image->GetLargestPossibleRegion();
+    partRegion.SetIndex(1, partRows[part]);
+    partRegion.SetSize(1, partRows[part + 1] - partRows[part]);
+
+    ExtractROIFilterType::Pointer extractFilter = ExtractROIFilterType::New();
+    extractFilter->SetInput(image);
+    extractFilter->SetExtractionRegion(partRegion);
+
+    otb::DeltaNDVIStatistics partStatistics = ComputeStatistics(extractFilter->GetOutput(),
+        part + 2, streaming_tiled, part + 3);
+    partStatistics.SetPartId(part);
+    partStatistics.SetPartCount(nbOfParts);
+
+    std::ostringstream fileName;
+    fileName << argv[1] << part << ".txt";
+    partStatistics.Write(fileName.str());
+    otb::DeltaNDVIStatistics readStatistics;
+    if (!readStatistics.Read(fileName.str()) || readStatistics.GetPartId() != part)
+      {
+      std::cerr << "Unable to read back " << fileName.str() << std::endl;
+      return EXIT_FAILURE;
+      }
+    ok &= CheckStatistics(fileName.str(), readStatistics, partStatistics);
+    merged.AddBands(readStatistics);
+    }
+  ok &= CheckStatistics("parts", merged, reference);
+
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,152 @@
+/*=========================================================================
+
+  Copyright (c) Remi Cresson (IRSTEA). All rights reserved.
+
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#include "otbVectorImage.h"
+#include "otbGridAlignedResampleImageFilter.h"
+#include "otbStreamingResampleImageFilter.h"
+#include "itkNearestNeighborInterpolateImageFunction.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
+
+#include <iostream>
+#include <cstdlib>
+
+typedef otb::VectorImage<float, 2>                                                  ResampleTestImageType;
+typedef otb::GridAlignedResampleImageFilter<ResampleTestImageType>                  GridResampleFilterType;
+typedef otb::StreamingResampleImageFilter<ResampleTestImageType, ResampleTestImageType> ResampleFilterType;
+typedef itk::NearestNeighborInterpolateImageFunction<ResampleTestImageType>         ResampleInterpolatorType;
+
+static const unsigned int resampleTestNbOfBands = 2;
+
+/*
+ * North up input, whose pixel values are their index
+ */
+static ResampleTestImageType::Pointer CreateResampleTestImage()
+{
+  ResampleTestImageType::RegionType region;
+  region.SetIndex(0, 0);
+  region.SetIndex(1, 0);
+  region.SetSize(0, 30);
+  region.SetSize(1, 25);
+  ResampleTestImageType::Pointer image = ResampleTestImageType::New();
+  image->SetRegions(region);
+  image->SetNumberOfComponentsPerPixel(resampleTestNbOfBands);
+  ResampleTestImageType::PointType origin;
+  origin[0] = 500005.0;
+  origin[1] = 6400295.0;
+  ResampleTestImageType::SpacingType spacing;
+  spacing[0] = 10.0;
+  spacing[1] = -10.0;
+  image->SetOrigin(origin);
+  image->SetSignedSpacing(spacing);
+  image->Allocate();
+
+  ResampleTestImageType::PixelType pixel(resampleTestNbOfBands);
+  itk::ImageRegionIteratorWithIndex<ResampleTestImageType> it(image, region);
+  for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+    {
+    pixel[0] = 1 + it.GetIndex()[0];
+    pixel[1] = 1 + it.GetIndex()[1];
+    it.Set(pixel);
+    }
+  return image;
+}
+
+/*
+ * Resample the input on a grid with both filters, and compare the outputs.
+ * The grid aligned filter is updated tile by tile.
+ */
+static bool CheckResampleGrid(const std::string & name, ResampleTestImageType * image,
+    double originX, double originY, double spacingX, double spacingY, unsigned int sizeX, unsigned int sizeY)
+{
+  ResampleTestImageType::PointType origin;
+  origin[0] = originX;
+  origin[1] = originY;
+  ResampleTestImageType::SpacingType spacing;
+  spacing[0] = spacingX;
+  spacing[1] = spacingY;
+  ResampleTestImageType::SizeType size;
+  size[0] = sizeX;
+  size[1] = sizeY;
+
+  ResampleTestImageType::PixelType zero(resampleTestNbOfBands);
+  zero.Fill(0);
+  ResampleFilterType::Pointer resampleFilter = ResampleFilterType::New();
+  resampleFilter->SetInput(image);
+  resampleFilter->SetInterpolator(ResampleInterpolatorType::New());
+  resampleFilter->SetOutputOrigin(origin);
+  resampleFilter->SetOutputSpacing(spacing);
+  resampleFilter->SetOutputSize(size);
+  resampleFilter->SetEdgePaddingValue(zero);
+  resampleFilter->Update();
+  ResampleTestImageType * reference = resampleFilter->GetOutput();
+
+  GridResampleFilterType::Pointer gridFilter = GridResampleFilterType::New();
+  gridFilter->SetInput(image);
+  gridFilter->SetOutputOrigin(origin);
+  gridFilter->SetOutputSpacing(spacing);
+  gridFilter->SetOutputSize(size);
+  gridFilter->UpdateOutputInformation();
+  ResampleTestImageType * output = gridFilter->GetOutput();
+
+  const ResampleTestImageType::RegionType largestRegion = output->GetLargestPossibleRegion();
+  if (largestRegion != reference->GetLargestPossibleRegion())
+    {
+    std::cerr << name << ": wrong output region " << largestRegion << std::endl;
+    return false;
+    }
+  for (unsigned int ty = 0 ; ty < sizeY ; ty += 11)
+    {
+    for (unsigned int tx = 0 ; tx < sizeX ; tx += 13)
+      {
+      ResampleTestImageType::RegionType tile;
+      tile.SetIndex(0, tx);
+      tile.SetIndex(1, ty);
+      tile.SetSize(0, 13);
+      tile.SetSize(1, 11);
+      tile.Crop(largestRegion);
+      output->SetRequestedRegion(tile);
+      output->PropagateRequestedRegion();
+      output->UpdateOutputData();
+
+      itk::ImageRegionConstIteratorWithIndex<ResampleTestImageType> it(output, tile);
+      for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+        {
+        const ResampleTestImageType::PixelType expected = reference->GetPixel(it.GetIndex());
+        for (unsigned int band = 0 ; band < resampleTestNbOfBands ; band++)
+          {
+          if (it.Get()[band] != expected[band])
+            {
+            std::cerr << name << ": pixel " << it.GetIndex() << " band " << band << " is "
+                << it.Get()[band] << ", expected " << expected[band] << std::endl;
+            return false;
+            }
+          }
+        }
+      }
+    }
+  return true;
+}
+
+int otbGridAlignedResampleImageFilterTest(int itkNotUsed(argc), char * itkNotUsed(argv) [])
+{
+  ResampleTestImageType::Pointer image = CreateResampleTestImage();
+  bool ok = true;
+
+  // Same spacing, grid shifted by a fraction of pixel
+  ok &= CheckResampleGrid("shifted", image, 500038.7, 6400261.8, 10.0, -10.0, 24, 20);
+  // Finer and coarser grids
+  ok &= CheckResampleGrid("finer", image, 500021.3, 6400283.9, 3.0, -3.0, 70, 60);
+  ok &= CheckResampleGrid("coarser", image, 500012.2, 6400287.1, 23.0, -17.0, 12, 14);
+  // Grid partly outside the input: zeros
+  ok &= CheckResampleGrid("outside", image, 499931.6, 6400344.3, 10.0, -10.0, 45, 40);
+
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,182 @@
+/*=========================================================================
+
+  Copyright (c) Remi Cresson (IRSTEA). All rights reserved.
+
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#include "otbImage.h"
+#include "otbVectorImage.h"
+#include "otbMappedRasterFileWriter.h"
+#include "otbMappedRasterFileTeeFilter.h"
+#include "otbMappedRasterImageSource.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
+
+#include <iostream>
+#include <cstdlib>
+
+typedef otb::Image<unsigned char, 2>                      LabelImageType;
+typedef otb::VectorImage<float, 2>                        FloatVectorImageType;
+typedef otb::MappedRasterFileWriter<LabelImageType>       WriterType;
+typedef otb::MappedRasterFileTeeFilter<LabelImageType>    TeeFilterType;
+typedef otb::MappedRasterImageSource<LabelImageType>      LabelSourceType;
+typedef otb::MappedRasterImageSource<FloatVectorImageType> FloatSourceType;
+
+LabelImageType::PixelType LabelValue(const LabelImageType::IndexType & index)
+{
+  return static_cast<LabelImageType::PixelType>((index[0] * 7 + index[1] * 13) % 5);
+}
+
+/*
+ * Labels image with a non-trivial geometry
+ */
+LabelImageType::Pointer CreateLabelImage()
+{
+  LabelImageType::RegionType region;
+  region.SetIndex(0, 0);
+  region.SetIndex(1, 0);
+  region.SetSize(0, 123);
+  region.SetSize(1, 77);
+
+  LabelImageType::Pointer image = LabelImageType::New();
+  image->SetRegions(region);
+  LabelImageType::PointType origin;
+  origin[0] = 500010.0;
+  origin[1] = 6400000.0;
+  LabelImageType::SpacingType spacing;
+  spacing[0] = 20.0;
+  spacing[1] = -20.0;
+  image->SetOrigin(origin);
+  image->SetSignedSpacing(spacing);
+  image->Allocate();
+
+  itk::ImageRegionIteratorWithIndex<LabelImageType> it(image, region);
+  for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+    it.Set(LabelValue(it.GetIndex()));
+  return image;
+}
+
+/*
+ * Compare the mapped pixels of a region with the labels
+ */
+template <class TSource>
+bool CheckRegion(TSource * source, const LabelImageType::RegionType & region, const std::string & name)
+{
+  typedef typename TSource::OutputImageType ImageType;
+  ImageType * image = source->GetOutput();
+  image->SetRequestedRegion(region);
+  image->PropagateRequestedRegion();
+  image->UpdateOutputData();
+
+  itk::ImageRegionConstIteratorWithIndex<ImageType> it(image, region);
+  for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+    {
+    if (static_cast<double>(it.Get()[0]) != LabelValue(it.GetIndex()))
+      {
+      std::cerr << name << ": wrong pixel at " << it.GetIndex() << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+bool CheckFile(const std::string & fileName, const LabelImageType * reference)
+{
+  bool ok = true;
+
+  // Same pixel type: the buffer points in the mapping
+  LabelSourceType::Pointer labelSource = LabelSourceType::New();
+  labelSource->SetFileName(fileName);
+  labelSource->UpdateOutputInformation();
+  if (!labelSource->IsZeroCopy())
+    {
+    std::cerr << fileName << ": uint8 labels are not mapped without copy" << std::endl;
+    ok = false;
+    }
+  LabelImageType * labelImage = labelSource->GetOutput();
+  if (labelImage->GetLargestPossibleRegion() != reference->GetLargestPossibleRegion() ||
+      labelImage->GetOrigin() != reference->GetOrigin() ||
+      labelImage->GetSignedSpacing() != reference->GetSignedSpacing())
+    {
+    std::cerr << fileName << ": wrong geometry" << std::endl;
+    ok = false;
+    }
+
+  // Converted to float, in a region which is not made of full rows
+  FloatSourceType::Pointer floatSource = FloatSourceType::New();
+  floatSource->SetFileName(fileName);
+  floatSource->UpdateOutputInformation();
+  LabelImageType::RegionType tile;
+  tile.SetIndex(0, 17);
+  tile.SetIndex(1, 30);
+  tile.SetSize(0, 40);
+  tile.SetSize(1, 25);
+  ok &= CheckRegion(floatSource.GetPointer(), tile, fileName + " (float)");
+
+  // Whole image, mapped
+  LabelImageType::RegionType largestRegion = reference->GetLargestPossibleRegion();
+  typedef itk::ImageRegionConstIteratorWithIndex<LabelImageType> IteratorType;
+  labelImage->SetRequestedRegion(largestRegion);
+  labelImage->PropagateRequestedRegion();
+  labelImage->UpdateOutputData();
+  IteratorType it(labelImage, largestRegion);
+  for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+    {
+    if (it.Get() != LabelValue(it.GetIndex()))
+      {
+      std::cerr << fileName << ": wrong pixel at " << it.GetIndex() << std::endl;
+      return false;
+      }
+    }
+
+  return ok;
+}
+
+int otbMappedRasterFileTest(int argc, char * argv [])
+{
+  if (argc < 3)
+    {
+    std::cerr << "Usage: " << argv[0] << " writerOutput.ccr teeOutput.ccr" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  LabelImageType::Pointer image = CreateLabelImage();
+  bool ok = true;
+
+  // Streamed writer
+  WriterType::Pointer writer = WriterType::New();
+  writer->SetInput(image);
+  writer->SetFileName(argv[1]);
+  writer->Update();
+  ok &= CheckFile(argv[1], image);
+
+  // Tee filter, written by a consumer of tiles
+  TeeFilterType::Pointer teeFilter = TeeFilterType::New();
+  teeFilter->SetInput(image);
+  teeFilter->SetFileName(argv[2]);
+  teeFilter->UpdateOutputInformation();
+  const LabelImageType::RegionType largestRegion = image->GetLargestPossibleRegion();
+  for (unsigned int y = 0 ; y < largestRegion.GetSize(1) ; y += 32)
+    {
+    for (unsigned int x = 0 ; x < largestRegion.GetSize(0) ; x += 32)
+      {
+      LabelImageType::RegionType tile;
+      tile.SetIndex(0, x);
+      tile.SetIndex(1, y);
+      tile.SetSize(0, 32);
+      tile.SetSize(1, 32);
+      tile.Crop(largestRegion);
+      teeFilter->GetOutput()->SetRequestedRegion(tile);
+      teeFilter->GetOutput()->PropagateRequestedRegion();
+      teeFilter->GetOutput()->UpdateOutputData();
+      }
+    }
+  teeFilter->Close();
+  ok &= CheckFile(argv[2], image);
+
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
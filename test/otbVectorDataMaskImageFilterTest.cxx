@@ -0,0 +1,228 @@
+/*=========================================================================
+
+  Copyright (c) Remi Cresson (IRSTEA). All rights reserved.
+
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#include "otbVectorImage.h"
+#include "otbVectorData.h"
+#include "otbVectorDataMaskImageFilter.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
+
+#include "gdal.h"
+#include "gdal_alg.h"
+#include "gdal_priv.h"
+#include "ogr_geometry.h"
+
+#include <iostream>
+#include <vector>
+#include <cstdlib>
+
+typedef otb::VectorImage<float, 2>                                          MaskTestImageType;
+typedef otb::VectorData<double, 2>                                          MaskTestVectorDataType;
+typedef MaskTestVectorDataType::DataNodeType                                MaskTestDataNodeType;
+typedef otb::VectorDataMaskImageFilter<MaskTestImageType, MaskTestVectorDataType> MaskFilterType;
+
+// Image of maskTestWidth x maskTestHeight pixels of 10m, north up
+static const unsigned int maskTestWidth = 40;
+static const unsigned int maskTestHeight = 30;
+static const double maskTestUpperLeft[2] = {500000.0, 6400300.0};
+static const double maskTestSpacing = 10.0;
+static const float maskTestOutsideValue = -1.0;
+
+// Rings, in pixel coordinates (x, y from the upper left corner), away from the pixel centers
+static const unsigned int maskTestNbOfPolygons = 3;
+static const unsigned int maskTestNbOfRings = 4;
+static const unsigned int maskTestRingSizes[maskTestNbOfRings] = {8, 4, 3, 4};
+static const int maskTestRingPolygons[maskTestNbOfRings] = {0, 0, 1, 2};
+static const double maskTestRings[maskTestNbOfRings][8][2] = {
+    // Concave polygon...
+    {{3.3, 2.2}, {20.7, 4.1}, {18.2, 12.6}, {11.4, 9.3}, {9.8, 18.9}, {22.1, 24.6}, {4.6, 26.3}, {1.7, 14.2}},
+    // ...with a hole
+    {{5.2, 6.1}, {9.3, 6.4}, {8.6, 11.8}, {4.9, 10.7}},
+    // Triangle overlapping the first polygon
+    {{15.1, 7.3}, {34.6, 15.9}, {17.3, 21.2}},
+    // Thin diagonal band, partly outside the image
+    {{30.3, -4.2}, {44.8, 21.7}, {43.1, 22.4}, {28.9, -3.1}}};
+
+static MaskTestDataNodeType::PolygonType::Pointer CreateMaskTestRing(unsigned int ring)
+{
+  MaskTestDataNodeType::PolygonType::Pointer polygon = MaskTestDataNodeType::PolygonType::New();
+  for (unsigned int i = 0 ; i < maskTestRingSizes[ring] ; i++)
+    {
+    MaskTestDataNodeType::PolygonType::VertexType vertex;
+    vertex[0] = maskTestUpperLeft[0] + maskTestRings[ring][i][0] * maskTestSpacing;
+    vertex[1] = maskTestUpperLeft[1] - maskTestRings[ring][i][1] * maskTestSpacing;
+    polygon->AddVertex(vertex);
+    }
+  return polygon;
+}
+
+static MaskTestVectorDataType::Pointer CreateMaskTestVectorData()
+{
+  MaskTestVectorDataType::Pointer vectorData = MaskTestVectorDataType::New();
+  MaskTestVectorDataType::DataTreeType::Pointer tree = vectorData->GetDataTree();
+  MaskTestDataNodeType::Pointer root = tree->GetRoot()->Get();
+  MaskTestDataNodeType::Pointer document = MaskTestDataNodeType::New();
+  document->SetNodeType(otb::DOCUMENT);
+  tree->Add(document, root);
+  MaskTestDataNodeType::Pointer folder = MaskTestDataNodeType::New();
+  folder->SetNodeType(otb::FOLDER);
+  tree->Add(folder, document);
+
+  for (unsigned int ring = 0 ; ring < maskTestNbOfRings ; ring++)
+    {
+    if (ring > 0 && maskTestRingPolygons[ring] == maskTestRingPolygons[ring - 1])
+      continue;
+    MaskTestDataNodeType::Pointer node = MaskTestDataNodeType::New();
+    node->SetNodeType(otb::FEATURE_POLYGON);
+    node->SetPolygonExteriorRing(CreateMaskTestRing(ring));
+    MaskTestDataNodeType::PolygonListType::Pointer holes = MaskTestDataNodeType::PolygonListType::New();
+    for (unsigned int hole = ring + 1 ; hole < maskTestNbOfRings
+        && maskTestRingPolygons[hole] == maskTestRingPolygons[ring] ; hole++)
+      {
+      holes->PushBack(CreateMaskTestRing(hole));
+      }
+    node->SetPolygonInteriorRings(holes);
+    tree->Add(node, folder);
+    }
+  return vectorData;
+}
+
+/*
+ * Pixels whose center is inside the polygons, rasterized by GDAL (like
+ * ExtractGeom does)
+ */
+static bool RasterizeMaskTestPolygons(std::vector<unsigned char> & mask)
+{
+  GDALAllRegister();
+  GDALDriver * driver = GetGDALDriverManager()->GetDriverByName("MEM");
+  GDALDataset * dataset = driver->Create("", maskTestWidth, maskTestHeight, 1, GDT_Byte, NULL);
+  double geoTransform[6] = {maskTestUpperLeft[0], maskTestSpacing, 0.0, maskTestUpperLeft[1], 0.0, -maskTestSpacing};
+  dataset->SetGeoTransform(geoTransform);
+
+  OGRPolygon polygons[maskTestNbOfPolygons];
+  for (unsigned int ring = 0 ; ring < maskTestNbOfRings ; ring++)
+    {
+    OGRLinearRing * linearRing = new OGRLinearRing;
+    for (unsigned int i = 0 ; i < maskTestRingSizes[ring] ; i++)
+      linearRing->addPoint(maskTestUpperLeft[0] + maskTestRings[ring][i][0] * maskTestSpacing,
+          maskTestUpperLeft[1] - maskTestRings[ring][i][1] * maskTestSpacing);
+    linearRing->closeRings();
+    polygons[maskTestRingPolygons[ring]].addRingDirectly(linearRing);
+    }
+  std::vector<OGRGeometryH> geometries;
+  std::vector<double> burnValues;
+  for (unsigned int i = 0 ; i < maskTestNbOfPolygons ; i++)
+    {
+    geometries.push_back(reinterpret_cast<OGRGeometryH>(&polygons[i]));
+    burnValues.push_back(1.0);
+    }
+
+  int bandList[1] = {1};
+  mask.assign(maskTestWidth * maskTestHeight, 0);
+  bool ok = GDALRasterizeGeometries(dataset, 1, bandList, geometries.size(), &geometries[0],
+      NULL, NULL, &burnValues[0], NULL, NULL, NULL) == CE_None;
+  ok = ok && dataset->GetRasterBand(1)->RasterIO(GF_Read, 0, 0, maskTestWidth, maskTestHeight, &mask[0],
+      maskTestWidth, maskTestHeight, GDT_Byte, 0, 0, NULL) == CE_None;
+  GDALClose(dataset);
+  return ok;
+}
+
+int otbVectorDataMaskImageFilterTest(int itkNotUsed(argc), char * itkNotUsed(argv) [])
+{
+  // Input: the pixel values are their offset in the image
+  MaskTestImageType::RegionType region;
+  region.SetIndex(0, 0);
+  region.SetIndex(1, 0);
+  region.SetSize(0, maskTestWidth);
+  region.SetSize(1, maskTestHeight);
+  MaskTestImageType::Pointer image = MaskTestImageType::New();
+  image->SetRegions(region);
+  image->SetNumberOfComponentsPerPixel(1);
+  MaskTestImageType::PointType origin;
+  origin[0] = maskTestUpperLeft[0] + 0.5 * maskTestSpacing;
+  origin[1] = maskTestUpperLeft[1] - 0.5 * maskTestSpacing;
+  MaskTestImageType::SpacingType spacing;
+  spacing[0] = maskTestSpacing;
+  spacing[1] = -maskTestSpacing;
+  image->SetOrigin(origin);
+  image->SetSignedSpacing(spacing);
+  image->Allocate();
+  itk::ImageRegionIteratorWithIndex<MaskTestImageType> it(image, region);
+  MaskTestImageType::PixelType pixel(1);
+  for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+    {
+    pixel[0] = it.GetIndex()[1] * maskTestWidth + it.GetIndex()[0];
+    it.Set(pixel);
+    }
+
+  std::vector<unsigned char> mask;
+  if (!RasterizeMaskTestPolygons(mask))
+    {
+    std::cerr << "Unable to rasterize the polygons" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Filter, with small bands of rows, updated tile by tile
+  MaskFilterType::Pointer filter = MaskFilterType::New();
+  filter->SetInput(image);
+  filter->SetVectorData(CreateMaskTestVectorData());
+  filter->SetOutsideValue(maskTestOutsideValue);
+  filter->SetBandHeight(4);
+  filter->UpdateOutputInformation();
+  MaskTestImageType * output = filter->GetOutput();
+  const MaskTestImageType::RegionType outputRegion = output->GetLargestPossibleRegion();
+  MaskTestImageType::IndexType envelopeIndex;
+  image->TransformPhysicalPointToIndex(output->GetOrigin(), envelopeIndex);
+
+  bool ok = true;
+  std::vector<bool> checked(maskTestWidth * maskTestHeight, false);
+  for (unsigned int ty = 0 ; ty < outputRegion.GetSize(1) ; ty += 7)
+    {
+    for (unsigned int tx = 0 ; tx < outputRegion.GetSize(0) ; tx += 9)
+      {
+      MaskTestImageType::RegionType tile;
+      tile.SetIndex(0, tx);
+      tile.SetIndex(1, ty);
+      tile.SetSize(0, 9);
+      tile.SetSize(1, 7);
+      tile.Crop(outputRegion);
+      output->SetRequestedRegion(tile);
+      output->PropagateRequestedRegion();
+      output->UpdateOutputData();
+
+      itk::ImageRegionConstIteratorWithIndex<MaskTestImageType> outIt(output, tile);
+      for (outIt.GoToBegin(); !outIt.IsAtEnd(); ++outIt)
+        {
+        const long x = outIt.GetIndex()[0] + envelopeIndex[0];
+        const long y = outIt.GetIndex()[1] + envelopeIndex[1];
+        const float expected = mask[y * maskTestWidth + x] ? y * maskTestWidth + x : maskTestOutsideValue;
+        checked[y * maskTestWidth + x] = true;
+        if (outIt.Get()[0] != expected)
+          {
+          std::cerr << "Pixel " << x << "," << y << ": " << outIt.Get()[0] << ", expected " << expected << std::endl;
+          ok = false;
+          }
+        }
+      }
+    }
+
+  // Pixels inside the polygons are all in the output
+  for (unsigned int i = 0 ; i < mask.size() ; i++)
+    {
+    if (mask[i] && !checked[i])
+      {
+      std::cerr << "Pixel " << i % maskTestWidth << "," << i / maskTestWidth
+          << " is inside the polygons, but not in the output region " << outputRegion << std::endl;
+      ok = false;
+      }
+    }
+
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}